@@ -0,0 +1,560 @@
+#include "exp.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define BENCH_MAX       64
+#define BENCH_MIN_TIME  0.25    // seconds of repetitions per microbenchmark
+#define BENCH_MIN_REPS  5
+#define BENCH_MAX_REPS  200
+#define BENCH_E2E_REPS  3
+#define BENCH_TOL       10.0    // default regression tolerance (%)
+
+#define BENCH_SCRATCH   "bench_scratch.ppm"
+
+typedef void (*bench_fn)(void *ctx);
+
+typedef struct bench_t {
+    char name[48];
+    const char *group;  // "micro" or "e2e"
+    size_t n;           // items processed per repetition
+    int reps;
+    double med, min;    // seconds per repetition
+} bench_t;
+
+typedef struct bench_opts_t {
+    const char *json, *csv, *compare, *filter;
+    double tol;
+    int quick;
+} bench_opts_t;
+
+// shared fixture for the microbenchmarks
+typedef struct fixture_t {
+    gauss_t *g[2];
+    MAT *x;             // 2-D samples
+    Image *img, *ref, *out;
+    feats_t *feat;
+    Disc disc;
+    MAT *a, *b, *c;     // dense k x k operands
+    PERM *p;
+    batch_t batch;
+    IVEC *labels;
+    size_t counts[2];
+    double sink;
+} fixture_t;
+
+static bench_t res[BENCH_MAX];
+static int nres = 0;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static int dbl_cmp(const void *a, const void *b) {
+    double l = *(const double*)a, r = *(const double*)b;
+
+    return (l > r) - (l < r);
+}
+
+/**
+ * @brief Sends stdout to /dev/null (the experiments are chatty);
+ * returns the descriptor to restore with quiet_end.
+ */
+static int quiet_begin(void) {
+    int fd, nul;
+
+    fflush(stdout);
+    fd = dup(1);
+    if ((nul = open("/dev/null", O_WRONLY)) >= 0) {
+        dup2(nul, 1);
+        close(nul);
+    }
+
+    return fd;
+}
+
+static void quiet_end(int fd) {
+    fflush(stdout);
+    if (fd >= 0) {
+        dup2(fd, 1);
+        close(fd);
+    }
+}
+
+/**
+ * @brief Times fn(ctx). Microbenchmarks get one warm-up run and
+ * repeat until BENCH_MIN_TIME has passed (within the rep
+ * limits); end-to-end runs repeat a fixed number of times.
+ * Median and minimum per-repetition times are recorded.
+ *
+ * @param o - Options (name filter, quick mode)
+ * @param name - Benchmark name (unique; used by --compare)
+ * @param group - "micro" or "e2e"
+ * @param n - Items per repetition (samples, pixels, ...)
+ * @param fn - Work to time
+ * @param ctx - fn argument
+ */
+static void bench_run(const bench_opts_t *o, const char *name, const char *group, size_t n, bench_fn fn, void *ctx) {
+    double t[BENCH_MAX_REPS], t0, total;
+    bench_t *b;
+    int r, e2e, fd;
+
+    if (o->filter && !strstr(name, o->filter)) return;
+    if (nres == BENCH_MAX) {
+        fprintf(stderr, "Error. Too many benchmarks, '%s' skipped.\n", name);
+        return;
+    }
+
+    e2e = !strcmp(group, "e2e");
+    fprintf(stderr, "%-32s ", name);
+
+    fd = quiet_begin();
+    if (!e2e) fn(ctx);
+
+    for (r = 0, total = 0; r < BENCH_MAX_REPS; r += 1) {
+        if (e2e && r == (o->quick ? 1 : BENCH_E2E_REPS)) break;
+        if (!e2e && r >= BENCH_MIN_REPS && total >= BENCH_MIN_TIME) break;
+
+        t0 = now();
+        fn(ctx);
+        t[r] = now() - t0;
+        total += t[r];
+    }
+    quiet_end(fd);
+
+    qsort(t, r, sizeof(double), dbl_cmp);
+
+    b = &res[nres++];
+    snprintf(b->name, sizeof(b->name), "%s", name);
+    b->group = group;
+    b->n = n;
+    b->reps = r;
+    b->med = (r % 2) ? t[r / 2] : 0.5 * (t[r / 2 - 1] + t[r / 2]);
+    b->min = t[0];
+
+    fprintf(stderr, "%12.0f ns  %10.2f ns/item  (%d reps)\n", b->med * 1e9, b->med * 1e9 / b->n, b->reps);
+}
+
+static void gauss_set(gauss_t *g, double m0, double m1, double s00, double s01, double s11) {
+    g->mu->ve[0] = m0; g->mu->ve[1] = m1;
+    m_set_val(g->sigma, 0, 0, s00); m_set_val(g->sigma, 0, 1, s01);
+    m_set_val(g->sigma, 1, 0, s01); m_set_val(g->sigma, 1, 1, s11);
+}
+
+static gauss_t *gauss_new(int id, double prior) {
+    gauss_t *g = (gauss_t*) calloc(1, sizeof(gauss_t));
+
+    g->id = id;
+    g->mu = v_get(2);
+    g->sigma = m_get(2, 2);
+    g->prior = prior;
+
+    return g;
+}
+
+static void gauss_del(gauss_t *g) {
+    v_free(g->mu); m_free(g->sigma);
+    m_free(g->dataset);
+    gauss_model_free(g->model);
+    free(g);
+}
+
+/* ---------------- microbenchmarks ---------------- */
+
+static void b_gauss_eval(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+    VEC row = { .dim = 2, .max_dim = 2 };
+    size_t i;
+
+    for (i = 0; i < f->x->m; i += 1) {
+        row.ve = f->x->me[i];
+        f->sink += gauss_eval(f->g[0], &row);
+    }
+}
+
+static void b_disc(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+    VEC row = { .dim = 2, .max_dim = 2 };
+    size_t i;
+
+    for (i = 0; i < f->x->m; i += 1) {
+        row.ve = f->x->me[i];
+        f->sink += f->disc(&row, f->g[0]);
+    }
+}
+
+static void b_classify(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    classify_run(&f->batch, f->x, f->counts, f->labels);
+}
+
+static void b_rgmat(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    f->c = image_rgmat(f->img, f->c);
+}
+
+static void b_ycbcrmat(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    f->c = image_ycbcrmat(f->img, f->c);
+}
+
+static void b_write_image(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    write_image(BENCH_SCRATCH, f->img);
+}
+
+static void b_load_image(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+    Image *img = load_image(BENCH_SCRATCH);
+
+    if (img) f->sink += img->data[0];
+    del_image(img);
+}
+
+static void b_face_test(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    face_test(f->g[0], f->out, f->img, f->feat, 1e-3);
+}
+
+static void b_face_validate(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+    double fpr, fnr;
+
+    face_validate(f->img, f->ref, &fpr, &fnr);
+    f->sink += fpr + fnr;
+}
+
+static void b_compute_mle(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    compute_mle(f->g[1], f->g[1]->dataset->m);
+}
+
+static void b_m_mlt(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    f->c = m_mlt(f->a, f->b, f->c);
+}
+
+static void b_lufactor(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    f->c = m_copy(f->a, f->c);
+    LUfactor(f->c, f->p);
+}
+
+static void b_m_inverse(void *arg) {
+    fixture_t *f = (fixture_t*)arg;
+
+    f->c = m_inverse(f->a, f->c);
+}
+
+/**
+ * @brief Square k x k operands: uniform entries plus k on the
+ * diagonal (well conditioned for LU / inverse).
+ */
+static void dense_set(fixture_t *f, int k) {
+    int i;
+
+    f->a = m_rand(m_resize(f->a, k, k));
+    f->b = m_rand(m_resize(f->b, k, k));
+    for (i = 0; i < k; i += 1) f->a->me[i][i] += k;
+    f->p = px_resize(f->p, k);
+}
+
+static void micro(const bench_opts_t *o) {
+    static const struct { const char *name; Disc g; } discs[] = {
+        { "euclid_disc", euclid_disc }, { "case1_disc", case1_disc },
+        { "case2_disc", case2_disc }, { "case3_disc", case3_disc }
+    };
+    static const int dims[] = { 16, 64, 256 };
+    fixture_t f = { 0 };
+    size_t n, i;
+    char name[48];
+    rng_t r;
+    int k;
+
+    n = o->quick ? 20000 : 200000;
+
+    f.g[0] = gauss_new(1, 0.3);
+    f.g[1] = gauss_new(2, 0.7);
+    gauss_set(f.g[0], 1, 1, 1, 0, 1);
+    gauss_set(f.g[1], 4, 4, 4, 0, 8);
+
+    rng_seed(&r, RNG_SEED);
+    f.x = gauss_sample(f.g[0], n, &r, 0, MNULL);
+    f.g[1]->dataset = gauss_sample(f.g[1], 5 * n, &r, 0, MNULL);
+
+    gauss_compile(f.g[0]);
+    bench_run(o, "gauss_eval", "micro", n, b_gauss_eval, &f);
+
+    for (k = 0; k < sizeof(discs) / sizeof(discs[0]); k += 1) {
+        f.disc = discs[k].g;
+        bench_run(o, discs[k].name, "micro", n, b_disc, &f);
+    }
+
+    f.batch = (batch_t) { .c = 2, .d = 2, .n = n, .g = case3_disc, .dist = f.g };
+    f.labels = iv_get(n);
+    bench_run(o, "classify_run", "micro", n, b_classify, &f);
+
+    bench_run(o, "compute_mle", "micro", f.g[1]->dataset->m, b_compute_mle, &f);
+
+    // synthetic 1024 x 768 image and mask
+    f.img = new_image(768, 1024, 255);
+    f.ref = new_image(768, 1024, 255);
+    f.out = new_image(768, 1024, 255);
+    for (i = 0; i < f.img->size; i += 1) f.img->data[i] = (uint8_t)rng_next(&r);
+    for (i = 0; i < f.ref->size; i += 3) {
+        f.ref->data[i] = f.ref->data[i + 1] = f.ref->data[i + 2] = (rng_next(&r) & 1) ? 255 : 0;
+    }
+    n = f.img->size / 3;
+
+    bench_run(o, "image_rgmat", "micro", n, b_rgmat, &f);
+    bench_run(o, "image_ycbcrmat", "micro", n, b_ycbcrmat, &f);
+
+    mkdir(IMAGE_DIR, 0755);
+    bench_run(o, "write_image", "micro", n, b_write_image, &f);
+    bench_run(o, "load_image", "micro", n, b_load_image, &f);
+    remove(IMAGE_DIR BENCH_SCRATCH);
+
+    // color model fit on the image's own RG features
+    f.g[0]->dataset = image_rgmat(f.img, f.g[0]->dataset);
+    compute_mle(f.g[0], f.g[0]->dataset->m);
+    f.feat = feats_image(f.img, 1, PREC_F64, NULL);
+    bench_run(o, "face_test", "micro", n, b_face_test, &f);
+    bench_run(o, "face_validate", "micro", n, b_face_validate, &f);
+
+    for (k = 0; k < sizeof(dims) / sizeof(dims[0]); k += 1) {
+        dense_set(&f, dims[k]);
+        snprintf(name, sizeof(name), "m_mlt/%d", dims[k]);
+        bench_run(o, name, "micro", dims[k], b_m_mlt, &f);
+        snprintf(name, sizeof(name), "LUfactor/%d", dims[k]);
+        bench_run(o, name, "micro", dims[k], b_lufactor, &f);
+        snprintf(name, sizeof(name), "m_inverse/%d", dims[k]);
+        bench_run(o, name, "micro", dims[k], b_m_inverse, &f);
+    }
+
+    m_free(f.x); m_free(f.a); m_free(f.b); m_free(f.c);
+    px_free(f.p);
+    iv_free(f.labels);
+    feats_free(f.feat);
+    del_image(f.img); del_image(f.ref); del_image(f.out);
+    gauss_del(f.g[0]); gauss_del(f.g[1]);
+}
+
+/* ---------------- end-to-end ---------------- */
+
+typedef struct mle_ctx_t {
+    size_t n;
+    gauss_t *g[2];
+    batch_t batch;
+} mle_ctx_t;
+
+/**
+ * @brief Experiment 2 setup at n samples (30% / 70% split),
+ * freshly drawn every repetition since mle_exp re-estimates
+ * the classes in place.
+ */
+static void b_mle_exp(void *arg) {
+    mle_ctx_t *c = (mle_ctx_t*)arg;
+    MAT *datasets[2];
+    rng_t r;
+
+    rng_seed(&r, RNG_SEED);
+    gauss_set(c->g[0], 1, 1, 1, 0, 1);
+    gauss_set(c->g[1], 4, 4, 4, 0, 8);
+    c->g[0]->dataset = gauss_sample(c->g[0], 3 * c->n / 10, &r, 0, c->g[0]->dataset);
+    c->g[1]->dataset = gauss_sample(c->g[1], c->n - c->g[0]->dataset->m, &r, 0, c->g[1]->dataset);
+
+    datasets[0] = c->g[0]->dataset;
+    datasets[1] = c->g[1]->dataset;
+
+    mle_exp(datasets, &c->batch, 0);
+    plot_wait();
+}
+
+static void b_face_exp(void *arg) {
+    face_exp(*(int*)arg);
+    plot_wait();
+}
+
+static void e2e(const bench_opts_t *o) {
+    // mle_exp's smallest fraction is 0.01%, so 100k is the floor; 200k is the assignment's size
+    static const size_t sizes[] = { 100000, 200000, 1000000 };
+    static const char *imgs[] = { "train1.ppm", "ref1.ppm", "train3.ppm", "ref3.ppm", "train6.ppm", "ref6.ppm" };
+    char name[48], path[MAX_FPATH];
+    mle_ctx_t c;
+    int k, rg, have;
+
+    c.g[0] = gauss_new(1, 0.3);
+    c.g[1] = gauss_new(2, 0.7);
+    c.batch = (batch_t) { .c = 2, .d = 2, .g = case3_disc, .dist = c.g };
+
+    for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]) - (o->quick ? 1 : 0); k += 1) {
+        c.n = sizes[k];
+        snprintf(name, sizeof(name), "mle_exp/%zu", c.n);
+        bench_run(o, name, "e2e", c.n, b_mle_exp, &c);
+    }
+
+    gauss_del(c.g[0]); gauss_del(c.g[1]);
+
+    for (k = 0, have = 1; k < sizeof(imgs) / sizeof(imgs[0]); k += 1) {
+        snprintf(path, sizeof(path), "%s%s", IMAGE_DIR, imgs[k]);
+        have &= !access(path, R_OK);
+    }
+
+    if (!have) {
+        fprintf(stderr, "face_exp skipped: training images not found under '%s'\n", IMAGE_DIR);
+        return;
+    }
+
+    rg = IMG_NMRG;
+    bench_run(o, "face_exp/RG", "e2e", 1, b_face_exp, &rg);
+    rg = IMG_YCBCR;
+    bench_run(o, "face_exp/YCbCr", "e2e", 1, b_face_exp, &rg);
+}
+
+/* ---------------- output ---------------- */
+
+static int write_json(const char *path) {
+    FILE *fp;
+    int i;
+
+    if (!(fp = fopen(path, "w"))) {
+        fprintf(stderr, "Error opening '%s'.\n", path);
+        return 1;
+    }
+
+    fprintf(fp, "{\n  \"isa\": { \"score\": \"%s\", \"feat\": \"%s\", \"rng\": \"%s\" },\n", score_isa(), feat_isa(), rng_isa());
+    fprintf(fp, "  \"threads\": %d,\n  \"benchmarks\": [\n", pool_threads(0));
+
+    for (i = 0; i < nres; i += 1) {
+        fprintf(fp, "    { \"name\": \"%s\", \"group\": \"%s\", \"n\": %zu, \"reps\": %d, "
+                    "\"median_ns\": %.0f, \"min_ns\": %.0f, \"ns_per_item\": %.3f }%s\n",
+                res[i].name, res[i].group, res[i].n, res[i].reps,
+                res[i].med * 1e9, res[i].min * 1e9, res[i].med * 1e9 / res[i].n,
+                (i < nres - 1) ? "," : "");
+    }
+
+    fprintf(fp, "  ]\n}\n");
+
+    return fclose(fp) != 0;
+}
+
+static int write_csv(const char *path) {
+    FILE *fp;
+    int i;
+
+    if (!(fp = fopen(path, "w"))) {
+        fprintf(stderr, "Error opening '%s'.\n", path);
+        return 1;
+    }
+
+    fprintf(fp, "name,group,n,reps,median_ns,min_ns,ns_per_item\n");
+    for (i = 0; i < nres; i += 1) {
+        fprintf(fp, "%s,%s,%zu,%d,%.0f,%.0f,%.3f\n", res[i].name, res[i].group, res[i].n, res[i].reps,
+                res[i].med * 1e9, res[i].min * 1e9, res[i].med * 1e9 / res[i].n);
+    }
+
+    return fclose(fp) != 0;
+}
+
+/**
+ * @brief Compares this run's medians with a baseline CSV (as
+ * written by --csv). A benchmark matches only a baseline row of
+ * the same name and n (--quick changes n, and the working set
+ * with it); mismatches are listed but not compared. Benchmarks
+ * slower than the baseline by more than tol percent are flagged.
+ *
+ * @param path - Baseline CSV
+ * @param tol - Tolerance (%)
+ * @return int - Number of regressions, -1 if unreadable
+ */
+static int compare(const char *path, double tol) {
+    char line[256], name[48];
+    double base;
+    size_t n, other;
+    FILE *fp;
+    int i, bad = 0, found;
+
+    if (!(fp = fopen(path, "r"))) {
+        fprintf(stderr, "Error opening baseline '%s'.\n", path);
+        return -1;
+    }
+
+    printf("%-32s %14s %14s %8s\n", "benchmark", "baseline ns", "current ns", "ratio");
+
+    for (i = 0; i < nres; i += 1) {
+        rewind(fp);
+        for (found = 0, other = 0; !found && fgets(line, sizeof(line), fp);) {
+            if (sscanf(line, "%47[^,],%*[^,],%zu,%*[^,],%lf", name, &n, &base) != 3 || strcmp(name, res[i].name)) continue;
+            if (n == res[i].n) found = 1;
+            else other = n;
+        }
+
+        if (!found && other) {
+            printf("%-32s %14s %14.0f %8s  n %zu vs %zu, skipped\n", res[i].name, "-", res[i].med * 1e9, "-", other, res[i].n);
+            continue;
+        }
+        if (!found || base <= 0) {
+            printf("%-32s %14s %14.0f %8s  new\n", res[i].name, "-", res[i].med * 1e9, "-");
+            continue;
+        }
+
+        printf("%-32s %14.0f %14.0f %8.3f%s\n", res[i].name, base, res[i].med * 1e9, res[i].med * 1e9 / base,
+               (res[i].med * 1e9 > base * (1 + tol / 100)) ? "  REGRESSION" : "");
+        if (res[i].med * 1e9 > base * (1 + tol / 100)) bad += 1;
+    }
+
+    fclose(fp);
+
+    printf("\n%d regression(s) beyond %.1f%%\n", bad, tol);
+
+    return bad;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--json FILE] [--csv FILE] [--compare BASELINE.csv] [--tol PCT] [--filter STR] [--quick]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    bench_opts_t o = { .tol = BENCH_TOL };
+    int i, rc = 0;
+
+    for (i = 1; i < argc; i += 1) {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc) o.json = argv[++i];
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc) o.csv = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && i + 1 < argc) o.compare = argv[++i];
+        else if (!strcmp(argv[i], "--tol") && i + 1 < argc) o.tol = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) o.filter = argv[++i];
+        else if (!strcmp(argv[i], "--quick")) o.quick = 1;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    trace_init();
+
+    mkdir(DATA_DIR, 0755);
+    mkdir(PLOT_DIR, 0755);
+
+    micro(&o);
+    e2e(&o);
+
+    if (o.json && write_json(o.json)) rc = 1;
+    if (o.csv && write_csv(o.csv)) rc = 1;
+    if (o.compare && compare(o.compare, o.tol)) rc = 1;
+
+    return rc;
+}
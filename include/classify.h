@@ -0,0 +1,22 @@
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include "headers.h"
+#include "score.h"
+#include "pool.h"
+
+// rows per work item; scores for every class stay in L1/L2
+#define CLASSIFY_BLOCK SCORE_BLOCK
+
+typedef struct classify_ctx_t {
+    batch_t *batch;
+    MAT *data;
+    disc_tab_t *tab;    // compiled discriminants, or NULL
+    Real **scores;      // per-worker score buffers (c x CLASSIFY_BLOCK)
+    size_t **counts;    // per-worker class counts
+    int *labels;        // per-sample class index, or NULL
+} classify_ctx_t;
+
+int classify_run(batch_t *batch, MAT *data, size_t *counts, IVEC *labels);
+
+#endif // CLASSIFY_H
@@ -0,0 +1,49 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdint.h>
+
+#include "headers.h"
+
+/*
+ * Binary dataset file, all integers and samples little-endian:
+ *
+ *   0  magic "CS479DS\0"
+ *   8  u32 version (DSET_VERSION)
+ *  12  u32 dtype (DSET_F64 / DSET_F32)
+ *  16  u64 rows
+ *  24  u32 cols
+ *  28  i32 label (class id of every row)
+ *  32  u64 offset of column 0 (multiple of DSET_ALIGN)
+ *  40  u64 stride between column starts (multiple of DSET_ALIGN)
+ *
+ * followed by cols raw columns of rows samples each.
+ */
+#define DSET_MAGIC      "CS479DS"
+#define DSET_VERSION    1
+#define DSET_HDR_LEN    48
+#define DSET_ALIGN      64
+
+// sample types
+#define DSET_F64 1
+#define DSET_F32 2
+
+typedef struct dset_t {
+    uint32_t version, dtype;
+    uint64_t rows;
+    uint32_t cols;
+    int32_t label;
+    uint64_t offset, stride;
+
+    void *map;          // read-only file mapping
+    size_t map_size;
+} dset_t;
+
+char *dset_path(const char *fname, char *out, size_t len);
+int dset_write(const char *path, const MAT *m, int label);
+int dset_open(const char *path, dset_t *d);
+const void *dset_col(const dset_t *d, uint32_t j);
+MAT *dset_mat(const dset_t *d, MAT *out);
+void dset_close(dset_t *d);
+
+#endif // DATASET_H
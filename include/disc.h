@@ -4,8 +4,33 @@
 #include "headers.h"
 #include "util.h"
 
+// compiled discriminant: g(x) = x'.W.x + w'.x + w0
+typedef struct disc_t {
+    int d;
+    int quad;       // W is non-zero (otherwise linear)
+    MAT *W;         // symmetric quadratic term
+    VEC *w;         // linear term
+    double w0;      // bias
+} disc_t;
+
+// a batch's classes compiled for one discriminant
+typedef struct disc_tab_t {
+    Disc g;
+    size_t c;
+    disc_t *k;      // one per class
+    disc_t diff;    // k[0] - k[1], two-class batches only
+} disc_tab_t;
+
 double euclid_disc(VEC *x, gauss_t *g);
 double case1_disc(VEC *x, gauss_t *g);
+double case2_disc(VEC *x, gauss_t *g);
 double case3_disc(VEC *x, gauss_t *g);
 
+int disc_compile(Disc g, gauss_t *c, disc_t *out);
+void disc_sub(const disc_t *a, const disc_t *b, disc_t *out);
+double disc_eval(const disc_t *k, const Real *x);
+void disc_free(disc_t *k);
+int disc_tab_compile(batch_t *b, disc_tab_t *t);
+void disc_tab_free(disc_tab_t *t);
+
 #endif // DISC_H
\ No newline at end of file
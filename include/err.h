@@ -38,7 +38,20 @@
 
 /* Error recovery */
 
-extern	jmp_buf	restart;
+/* The restart buffer, error flag and error count are kept per thread
+   (Oct 2026), so each thread has its own ON_ERROR()/catch() context
+   and the library can be called from several threads at once.  The
+   attached error lists stay global; attach them before starting
+   threads. */
+#if defined(__GNUC__) || defined(__clang__)
+#define	ERR_TLS		__thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define	ERR_TLS		_Thread_local
+#else
+#define	ERR_TLS
+#endif
+
+extern	ERR_TLS	jmp_buf	restart;
 
 
 /* max. # of error lists */
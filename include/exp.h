@@ -0,0 +1,38 @@
+#ifndef EXP_H
+#define EXP_H
+
+#include "headers.h"
+#include "disc.h"
+#include "util.h"
+#include "roc.h"
+#include "score.h"
+#include "classify.h"
+#include "stream.h"
+#include "plot.h"
+#include "trace.h"
+
+#define PLOT_DIR "plots/"
+
+// face_exp feature spaces
+#define IMG_YCBCR 0
+#define IMG_NMRG  1
+
+// > 0: face_exp scores pixels from an RGB table with this many bits per channel (lut.h)
+#define FACE_LUT_BITS 0
+// feature precision of face_exp without a table (PREC_F32: float32 planes, feat.h)
+#define FACE_PREC PREC_F64
+
+void plot_roc(MAT *data, char *fname, char *title);
+void plot_data(MAT **data, int n, char *fname, char *title);
+void plot_batch(batch_t *b);
+
+void face_validate(Image *img, Image *ref, double *fpr, double *fnr);
+void face_test(gauss_t *color, Image *out, Image *img, const feats_t *data, double thresh);
+void face_detect(gauss_t *color, char *ifname, char *rfname, size_t n, double step, int rg, const lut_t *lut, prec_t prec);
+void face_train(gauss_t *color, char *ifname, char *rfname, int rg);
+void face_exp(int rg);
+
+void mle_exp(MAT **datasets, batch_t *batch, int it);
+size_t classify(batch_t *batch, MAT *data, int class);
+
+#endif // EXP_H
@@ -0,0 +1,35 @@
+#ifndef FEAT_H
+#define FEAT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "util.h"
+#include "score.h"
+
+// feature storage precision, picked per call site
+typedef enum prec_t {
+    PREC_F64 = 0,       // Real rows in a MAT (image_rgmat / image_ycbcrmat)
+    PREC_F32            // float32 planes, mixed precision scoring
+} prec_t;
+
+// 2-D image features (RG or CbCr) in either precision
+typedef struct feats_t {
+    prec_t prec;
+    size_t n;           // rows (one per pixel)
+    MAT *x;             // PREC_F64: n x 2 feature rows
+    float *x0, *x1;     // PREC_F32: feature planes
+    size_t cap;         // plane capacity (rows)
+} feats_t;
+
+const char *feat_isa(void);
+
+void feat_rg_f32(const uint8_t *rgb, size_t n, float *x0, float *x1);
+void feat_ycbcr_f32(const uint8_t *rgb, size_t n, float *x0, float *x1);
+
+feats_t *feats_image(Image *img, int rg, prec_t prec, feats_t *f);
+void feats_logeval(const gauss_model_t *m, const feats_t *f, size_t lo, size_t n, Real *out);
+void feats_free(feats_t *f);
+
+#endif // FEAT_H
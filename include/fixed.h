@@ -0,0 +1,22 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stddef.h>
+
+#include "headers.h"
+
+// largest feature dimension with specialized kernels
+#define FX_MAX_D 4
+
+#define fx_has(d) ((d) >= 1 && (d) <= FX_MAX_D)
+
+double fx_det(const MAT *a);
+MAT *fx_inverse(const MAT *a, MAT *out);
+
+void fx_mom(int d, const Real *x, size_t n, ptrdiff_t ld, size_t *cnt, Real *mu, Real **m2);
+void fx_cov(int d, const Real *x, size_t n, ptrdiff_t ld, const Real *mu, Real **out);
+void fx_quad(int d, const Real *mu, Real **p, const Real *x, size_t n, ptrdiff_t ld, double scale, double offset, Real *out);
+void fx_disc(int d, Real **W, const Real *w, double w0, int quad, const Real *x, size_t n, ptrdiff_t ld, Real *out);
+void fx_sample(int d, Real **L, const Real *mu, const double *z, size_t n, Real **out);
+
+#endif // FIXED_H
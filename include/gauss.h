@@ -0,0 +1,19 @@
+#ifndef GAUSS_H
+#define GAUSS_H
+
+#include "headers.h"
+#include "rng.h"
+#include "pool.h"
+#include "fixed.h"
+
+// samples drawn per work block (one rng stream each)
+#define GAUSS_SAMPLE_BLOCK 16384
+
+gauss_model_t *gauss_compile(gauss_t *g);
+void gauss_model_free(gauss_model_t *m);
+double gauss_maha(const gauss_model_t *m, const Real *x);
+double gauss_logeval(const gauss_model_t *m, const Real *x);
+double gauss_model_eval(const gauss_model_t *m, const Real *x);
+MAT *gauss_sample(gauss_t *g, size_t n, const rng_t *rng, int nthreads, MAT *out);
+
+#endif // GAUSS_H
@@ -10,17 +10,28 @@
 #include "gnuplot_i.h"
 #include "matrix2.h"
 #include "image.h"
+#include "memprof.h"
 
 #define DATA_DIR  "data/"
 #define ADATA_LEN 60000.0
 #define BDATA_LEN 140000.0
 
+typedef struct gauss_model_t {
+    int d;
+    VEC *mu;
+    MAT *chol;      // Cholesky factor of sigma (L.L')
+    MAT *prec;      // precision matrix (sigma^-1)
+    double logdet;  // log |sigma|
+    double lognorm; // log of the density normalizer
+} gauss_model_t;
+
 typedef struct gauss_t {
     int id;
     VEC *mu;
     MAT *sigma;
     MAT *dataset;
     double prior;
+    gauss_model_t *model;
 } gauss_t;
 
 typedef double (*Disc)(VEC *, gauss_t *);
@@ -30,9 +41,11 @@ typedef struct batch_t {
     size_t n;
     size_t c;
     size_t d;
+    int nthreads;   // classify workers (0 = one per CPU)
+    size_t budget;  // samples kept for the plot (0 = PLOT_BUDGET)
     
     Disc g;    
-    FILE *fdata;
+    MAT *plot;      // kept samples + class id, grouped by class
     gauss_t **dist;
 } batch_t;
 
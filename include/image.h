@@ -3,6 +3,8 @@
 
 #define IMAGE_DIR "images/"
 #define MAX_FPATH 256
+// longest PPM/PGM header load_header reads (comments included)
+#define IMAGE_HEADER_MAX 4096
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,17 +12,31 @@
 #include <ctype.h>
 #include <string.h>
 
+// Image.mode -> who owns Image.data
+#define IMAGE_OWNED     0   // malloc'd, freed by del_image
+#define IMAGE_MAPPED    1   // private (copy-on-write) file mapping
+#define IMAGE_MAPPED_RO 2   // read-only file mapping
+#define IMAGE_BORROWED  3   // caller memory, left alone by del_image
+
 typedef struct Image {
-    uint16_t m, n, q;
+    uint32_t m, n;
+    uint16_t q;
     size_t size;
     uint8_t *data;
+
+    int mode;
+    void *map;          // start of file mapping (header included)
+    size_t map_size;
 } Image;
 
 Image *image_and(Image *a, Image *b, Image *out);
-Image *new_image(int m, int n, int q);
+Image *new_image(uint32_t m, uint32_t n, int q);
 Image *copy_image(Image* img);
 int del_image(Image *img);
 Image *load_image(const char *fname);
+Image *load_image_mode(const char *fname, int mode);
+Image *image_borrow(const uint8_t *buf, size_t len);
+int parse_header(const uint8_t *buf, size_t len, Image *img, size_t *off);
 int load_header(FILE *fp, Image *img);
 int load_data(FILE *fp, Image *img);
 int write_image(const char *fname, Image *img);
@@ -0,0 +1,33 @@
+#ifndef LUT_H
+#define LUT_H
+
+#include "headers.h"
+#include "score.h"
+#include "pool.h"
+
+// cells per compile work item
+#define LUT_BLOCK 65536
+
+typedef struct lut_t {
+    int bits;           // bits kept per RGB channel (1..8)
+    int rg;             // RG (1) or YCbCr (0) model
+    size_t cells;       // 2^(3 * bits)
+    float *lik;         // model likelihood at each cell, rounded to float
+    uint8_t *mask;      // cells at/above thresh, 1 bit per cell
+    double thresh;
+} lut_t;
+
+// cell index of an RGB triple
+#define lut_cell(t, p) \
+    ((((size_t)(p)[0] >> (8 - (t)->bits)) << (2 * (t)->bits)) | \
+     (((size_t)(p)[1] >> (8 - (t)->bits)) << (t)->bits) | \
+      ((size_t)(p)[2] >> (8 - (t)->bits)))
+
+#define lut_hit(t, c) (((t)->mask[(c) >> 3] >> ((c) & 7)) & 1)
+
+lut_t *lut_compile(gauss_t *color, int rg, int bits, double thresh);
+void lut_threshold(lut_t *t, double thresh);
+void lut_free(lut_t *t);
+Image *lut_apply(const lut_t *t, Image *img, Image *out);
+
+#endif // LUT_H
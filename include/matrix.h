@@ -34,6 +34,14 @@
 
 #define	MATRIXH	
 
+/* the library is called from worker threads (Oct 2026): workspaces are
+   per call rather than STATIC; build with -DNO_THREADSAFE for the old
+   behaviour in single-threaded programs.  Set before meminfo.h, whose
+   MEM_STAT_REG() must agree with STATIC */
+#if !defined(THREADSAFE) && !defined(NO_THREADSAFE)
+#define	THREADSAFE 1
+#endif
+
 #include	"machine.h"
 #include        "err.h"
 #include 	"meminfo.h"
@@ -207,6 +215,74 @@ extern  int bd_free(BAND *);
 
 #endif /* ANSI_C */
 
+/* Block storage behind v_get(), m_get() and px_get() (memory.c):
+   size-class free lists plus optional scoped arenas */
+
+/* alignment of MAT base storage (bytes); rows follow at stride n */
+#define	MAT_ALIGN	64
+
+typedef struct MEM_CHUNK {
+	struct MEM_CHUNK *next;
+	size_t	size, used;	/* bytes in chunk, bytes handed out */
+} MEM_CHUNK;
+
+typedef struct	{
+	MEM_CHUNK *head, *cur;
+	size_t	chunk;		/* default chunk size */
+	} MEM_ARENA;
+
+typedef struct	{
+	MEM_CHUNK *chunk;
+	size_t	used;
+	} MEM_MARK;
+
+#ifndef ANSI_C
+
+extern	void	*mem_blk_get(), *mem_blk_align(), *mem_blk_renew(),
+		mem_blk_free();
+extern	void	mem_cache_flush();
+extern	MEM_ARENA *mem_arena_get(), *mem_arena_use();
+extern	int	mem_arena_free();
+extern	MEM_MARK mem_arena_mark();
+extern	void	mem_arena_release();
+extern	void	(*mem_hook)();
+
+#else
+
+/* zeroed storage, from the thread's arena if one is in use */
+extern	void	*mem_blk_get(size_t size),
+		*mem_blk_align(size_t size, size_t align),
+		*mem_blk_renew(void *p, size_t size),	/* cf. realloc() */
+		mem_blk_free(void *p);
+/* return this thread's cached blocks to malloc() */
+extern	void	mem_cache_flush(void);
+/* new arena (chunk == 0 for default); free it and all its storage */
+extern	MEM_ARENA *mem_arena_get(size_t chunk);
+extern	int	mem_arena_free(MEM_ARENA *a);
+/* route this thread's allocations to a (NULL: heap); returns previous */
+extern	MEM_ARENA *mem_arena_use(MEM_ARENA *a);
+/* release everything allocated from a since the mark */
+extern	MEM_MARK mem_arena_mark(const MEM_ARENA *a);
+extern	void	mem_arena_release(MEM_ARENA *a, MEM_MARK mark);
+/* allocation observer (NULL: none), see MEM_EV_* */
+extern	void	(*mem_hook)(int ev, int type, void *obj, int arena);
+
+#endif /* ANSI_C */
+
+/* events passed to mem_hook for MAT, VEC and PERM objects, with
+   the TYPE_* of obj and whether its storage came from an arena */
+#define	MEM_EV_NEW	0	/* after a get (also resize of NULL) */
+#define	MEM_EV_RESIZE	1	/* after resizing an existing object */
+#define	MEM_EV_FREE	2	/* before a free */
+
+#define	BLK_NEW(type)	((type *)mem_blk_get(sizeof(type)))
+#define	BLK_NEW_A(num,type)	((type *)mem_blk_get((size_t)(num)*sizeof(type)))
+#define	BLK_NEW_AL(num,type,al) \
+    ((type *)mem_blk_align((size_t)(num)*sizeof(type),(size_t)(al)))
+#define	BLK_RENEW(var,num,type) \
+    ((var)=(type *)mem_blk_renew((void *)(var),(size_t)(num)*sizeof(type)))
+#define	BLK_FREE(p)	mem_blk_free((void *)(p))
+
 
 /* MACROS */
 
@@ -416,6 +492,8 @@ extern	VEC	*v_star(), *v_slash(), *v_sort();
 extern	double _in_prod(), __ip__();
 extern	void	__mltadd__(), __add__(), __sub__(), 
                 __smlt__(), __zero__();
+extern	char	*m_simd_isa();
+extern	int	m_simd_repro();
 #else
 
 extern	VEC	*sv_mlt(double s,const VEC *x,VEC *out),	/* out <- s.x */
@@ -465,6 +543,10 @@ extern	void	__mltadd__(Real *,const Real *,double,int),
                 __smlt__(const Real *,double,Real *,int),
 		__zero__(Real *,int);
 
+/* instruction set used by the primitives above; reproducible __ip__ */
+extern	const char	*m_simd_isa(void);
+extern	int	m_simd_repro(int flag);
+
 #endif /* ANSI_C */
 
 
@@ -506,6 +588,7 @@ extern double m_norm1(const MAT *A),
 
 extern	MAT *sm_mlt(), *m_mlt(), *mmtr_mlt(), *mtrm_mlt(), *m_add(), *m_sub(),
 		*sub_mat(), *m_transp(), *ms_mltadd();
+extern	void	m_gemm();
 
 extern  BAND *bd_transp(), *sbd_mlt(), *bds_mltadd(), *bd_zero();
 extern	MAT *px_rows(), *px_cols(), *swap_rows(), *swap_cols(),
@@ -527,6 +610,10 @@ extern	MAT	*sm_mlt(double s, const MAT *A,MAT *out), 	/* out <- s.A */
                 /* out <- A + s.B */ 
 		*ms_mltadd(const MAT *A,const MAT *B,double s,MAT *out);   
 
+/* C <- C + alpha.op(A).op(B), op(X) = X^T if tX; C is m x n, p inner */
+extern	void	m_gemm(int ta, int tb, int m, int n, int p, double alpha,
+		       Real **A, int Aj0, Real **B, int Bj0, Real **C, int Cj0);
+
 
 extern  BAND    *bd_transp(const BAND *in, BAND *out),	/* out <- A^T */
   *sbd_mlt(Real s, const BAND *A, BAND *OUT),		/* OUT <- s.A */
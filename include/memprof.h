@@ -0,0 +1,42 @@
+#ifndef MEMPROF_H
+#define MEMPROF_H
+
+/*
+ * Allocation profiler, built in with -DMEMPROF (make MEMPROF=1 from
+ * clean). It watches every MAT/VEC/PERM get, resize and free through
+ * Meschach's mem_hook. Calls in this program are labelled file:line
+ * by the macros below; objects Meschach allocates itself (NULL output
+ * arguments) are labelled by their call stack. Allocations, bytes,
+ * peak live bytes and leaks per site are reported at exit.
+ */
+
+#ifdef MEMPROF
+
+#include "matrix.h"
+
+// report file (default stderr)
+#define MPROF_ENV       "PA2_MEMPROF"
+// call sites tracked (the last one collects any overflow)
+#define MPROF_SITES     4096
+// stack frames kept for unlabelled allocations
+#define MPROF_DEPTH     6
+
+VEC *mprof_v_get(int n, const char *file, int line);
+MAT *mprof_m_get(int m, int n, const char *file, int line);
+PERM *mprof_px_get(int n, const char *file, int line);
+VEC *mprof_v_resize(VEC *v, int n, const char *file, int line);
+MAT *mprof_m_resize(MAT *a, int m, int n, const char *file, int line);
+PERM *mprof_px_resize(PERM *p, int n, const char *file, int line);
+
+void mprof_report(void);
+
+#define v_get(n)            mprof_v_get((n), __FILE__, __LINE__)
+#define m_get(m, n)         mprof_m_get((m), (n), __FILE__, __LINE__)
+#define px_get(n)           mprof_px_get((n), __FILE__, __LINE__)
+#define v_resize(v, n)      mprof_v_resize((v), (n), __FILE__, __LINE__)
+#define m_resize(a, m, n)   mprof_m_resize((a), (m), (n), __FILE__, __LINE__)
+#define px_resize(p, n)     mprof_px_resize((p), (n), __FILE__, __LINE__)
+
+#endif // MEMPROF
+
+#endif // MEMPROF_H
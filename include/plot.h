@@ -0,0 +1,52 @@
+#ifndef PLOT_H
+#define PLOT_H
+
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "headers.h"
+#include "trace.h"
+
+// gnuplot processes (one thread each) started by plot_start(0)
+#define PLOT_WORKERS 2
+
+// samples drawn per scatter figure / kept per batch plot
+#define PLOT_BUDGET 20000
+
+// density grid cells per axis behind decimated scatter plots
+#define PLOT_GRID 200
+
+// one figure: gnuplot commands with inline binary data, in order
+typedef struct plot_job_t {
+    char *buf;
+    size_t len, cap;
+    struct plot_job_t *next;
+} plot_job_t;
+
+typedef struct plot_srv_t {
+    pthread_mutex_t lock;
+    pthread_cond_t ready, idle;
+    plot_job_t *head, *tail;    // FIFO of pending jobs
+    int nworkers, busy, stop;
+    pthread_t *tid;
+    gnuplot_ctrl **gp;
+} plot_srv_t;
+
+int plot_start(int nworkers);
+void plot_wait(void);
+void plot_stop(void);
+
+plot_job_t *plot_job(void);
+void plot_cmd(plot_job_t *j, const char *fmt, ...);
+char *plot_binspec(char *buf, size_t len, size_t rows, int cols);
+void plot_rows(plot_job_t *j, const MAT *m);
+void plot_submit(plot_job_t *j);
+
+size_t plot_quota(size_t c, size_t total, size_t budget);
+int plot_keep(size_t j, size_t q, size_t c);
+MAT *plot_decimate(const MAT *data, size_t q, MAT *out);
+void plot_bounds(MAT **data, int n, double *lim);
+MAT *plot_density(const MAT *data, const double *lim, MAT *grid);
+char *plot_imgspec(char *buf, size_t len, const MAT *grid, const double *lim);
+
+#endif // PLOT_H
@@ -0,0 +1,26 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// runs block 'blk' on worker 'w' (0 <= w < nthreads)
+typedef void (*pool_fn)(void *ctx, size_t blk, int w);
+
+typedef struct pool_deque_t {
+    pthread_mutex_t lock;
+    size_t lo, hi;      // remaining blocks [lo, hi)
+} pool_deque_t;
+
+typedef struct pool_t {
+    int nthreads;
+    pool_fn fn;
+    void *ctx;
+    pool_deque_t *q;
+} pool_t;
+
+int pool_threads(int nthreads);
+int pool_run(size_t nblk, int nthreads, pool_fn fn, void *ctx);
+
+#endif // POOL_H
@@ -0,0 +1,32 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// default seed of the per-thread streams (rng_thread)
+#define RNG_SEED 0x5eed479ULL
+
+// normals produced per Box-Muller batch
+#define RNG_BLOCK 512
+
+// set to "scalar" to keep the portable Box-Muller kernel
+#define RNG_ISA_ENV "PA2_RNG_ISA"
+
+// xoshiro256** state
+typedef struct rng_t {
+    uint64_t s[4];
+} rng_t;
+
+const char *rng_isa(void);
+
+void rng_seed(rng_t *r, uint64_t seed);
+void rng_jump(rng_t *r);
+rng_t *rng_thread(void);
+
+uint64_t rng_next(rng_t *r);
+double rng_uniform(rng_t *r);
+void rng_normal(rng_t *r, double *out, size_t n);
+
+#endif // RNG_H
@@ -0,0 +1,24 @@
+#ifndef ROC_H
+#define ROC_H
+
+#include "headers.h"
+
+typedef struct roc_t {
+    size_t n;           // number of thresholds
+    double start, step; // uniform threshold spacing
+    double *thresh;     // ascending thresholds
+    size_t *pos, *neg;  // per-bin sample counts (n + 1 bins)
+    size_t npos, nneg;
+    double *fpr, *fnr;
+    size_t eer;         // index of equal-error threshold
+} roc_t;
+
+roc_t *roc_new(size_t n, double start, double step);
+void roc_free(roc_t *r);
+void roc_reset(roc_t *r);
+size_t roc_bin(roc_t *r, double score);
+void roc_add(roc_t *r, double score, int truth);
+size_t roc_finish(roc_t *r);
+MAT *roc_mat(roc_t *r, MAT *out);
+
+#endif // ROC_H
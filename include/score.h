@@ -0,0 +1,27 @@
+#ifndef SCORE_H
+#define SCORE_H
+
+#include "headers.h"
+#include "gauss.h"
+#include "disc.h"
+
+// max rows scored per call by the row-block consumers
+#define SCORE_BLOCK 4096
+
+int mat_contig(const MAT *x, size_t lo, size_t n);
+const char *score_isa(void);
+
+void gauss_quad_batch(const gauss_model_t *m, const Real *x, size_t n, size_t ld, double scale, double offset, Real *out);
+void gauss_logeval_batch(const gauss_model_t *m, const Real *x, size_t n, size_t ld, Real *out);
+void gauss_quad_soa2m(const gauss_model_t *m, const float *x0, const float *x1, size_t n, double scale, double offset, Real *out);
+void gauss_logeval_soa2m(const gauss_model_t *m, const float *x0, const float *x1, size_t n, Real *out);
+void gauss_logeval_rows(const gauss_model_t *m, const MAT *x, size_t lo, size_t n, Real *out);
+VEC *gauss_logeval_mat(const gauss_model_t *m, const MAT *x, VEC *out);
+
+void disc_batch(Disc g, gauss_t *c, const Real *x, size_t n, size_t ld, Real *out);
+void disc_rows(Disc g, gauss_t *c, const MAT *x, size_t lo, size_t n, Real *out);
+VEC *disc_mat(Disc g, gauss_t *c, const MAT *x, VEC *out);
+void disc_eval_batch(const disc_t *k, const Real *x, size_t n, size_t ld, Real *out);
+void disc_eval_rows(const disc_t *k, const MAT *x, size_t lo, size_t n, Real *out);
+
+#endif // SCORE_H
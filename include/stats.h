@@ -0,0 +1,33 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "headers.h"
+#include "pool.h"
+#include "view.h"
+#include "fixed.h"
+
+// rows per partial accumulator in mom_rows_par
+#define MOM_BLOCK 65536
+
+typedef struct moments_t {
+    size_t n;       // samples seen
+    int d;
+    VEC *mean;      // running mean
+    MAT *m2;        // sum of (x - mean)(x - mean)' (lower triangle)
+} moments_t;
+
+moments_t *mom_get(int d);
+void mom_free(moments_t *s);
+void mom_reset(moments_t *s);
+moments_t *mom_copy(const moments_t *s, moments_t *out);
+void mom_add(moments_t *s, const Real *x);
+void mom_add_rows(moments_t *s, const MAT *data, size_t lo, size_t n);
+void mom_add_view(moments_t *s, view_t v);
+moments_t *mom_merge(moments_t *a, const moments_t *b);
+void mom_prefix(const MAT *data, const size_t *lens, size_t k, int nthreads, moments_t **out);
+moments_t *mom_rows_par(const MAT *data, size_t lo, size_t n, int nthreads, moments_t *out);
+moments_t *mom_view_par(view_t v, int nthreads, moments_t *out);
+VEC *mom_mean(const moments_t *s, VEC *out);
+MAT *mom_cov(const moments_t *s, MAT *out);
+
+#endif // STATS_H
@@ -0,0 +1,32 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "headers.h"
+#include "util.h"
+#include "score.h"
+#include "roc.h"
+#include "lut.h"
+#include "feat.h"
+#include "trace.h"
+
+// default rows per band
+#define STREAM_BAND 64
+
+typedef struct stream_t {
+    const char *ifname;     // input PPM (under IMAGE_DIR)
+    const char *rfname;     // reference mask, or NULL
+    const char *ofname;     // detection output, or NULL
+    int rg;                 // RG (1) or YCbCr (0) features
+    double thresh;          // likelihood threshold for detection
+    size_t band;            // rows per band (0 -> STREAM_BAND)
+    roc_t *roc;             // optional ROC accumulator (needs rfname)
+    const lut_t *lut;       // score by color table instead of the model
+    prec_t prec;            // feature precision (PREC_F64 by default)
+
+    size_t fp, fn, tp, tn;  // detection stats vs. reference
+    double fpr, fnr;
+} stream_t;
+
+int face_stream(gauss_t *color, stream_t *st);
+
+#endif // STREAM_H
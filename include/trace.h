@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+
+// PA2_TRACE unset, empty or "0": off; "1": write TRACE_FILE; else the output path
+#define TRACE_ENV       "PA2_TRACE"
+#define TRACE_FILE      "trace.json"
+
+// spans kept (later ones are counted and dropped)
+#define TRACE_MAX       (1 << 20)
+#define TRACE_TAG       32
+
+// open span; t0 is 0 while tracing is off
+typedef struct trace_t {
+    const char *name;
+    double t0;
+} trace_t;
+
+extern int trace_enabled;
+
+void trace_init(void);
+double trace_now(void);
+void trace_record(const trace_t *t, const char *tag, size_t items, size_t bytes);
+void trace_dump(void);
+
+/**
+ * @brief Opens a timed span named after a stage (a string
+ * literal: spans with the same name are summarized together).
+ * Costs a load and a branch while tracing is off.
+ */
+static inline trace_t trace_begin(const char *name) {
+    trace_t t = { name, 0 };
+
+    if (__builtin_expect(trace_enabled, 0)) t.t0 = trace_now();
+
+    return t;
+}
+
+/**
+ * @brief Closes a span, recording what it processed.
+ *
+ * @param t - Span from trace_begin
+ * @param tag - Instance label (image, batch; copied), or NULL
+ * @param items - Items processed (pixels, samples, rows)
+ * @param bytes - Bytes read, written or sent
+ */
+static inline void trace_end(const trace_t *t, const char *tag, size_t items, size_t bytes) {
+    if (__builtin_expect(t->t0 != 0, 0)) trace_record(t, tag, items, bytes);
+}
+
+#endif // TRACE_H
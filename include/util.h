@@ -2,6 +2,9 @@
 #define UTIL_H
 
 #include "headers.h"
+#include "gauss.h"
+#include "stats.h"
+#include "dataset.h"
 
 double ranf(double m);
 double rang(double mu, double sigma);
@@ -12,10 +15,11 @@ double gauss_eval(gauss_t *g, VEC *x);
 double bhatta_err(gauss_t *c1, gauss_t *c2);
 void sample_mean(MAT *data, VEC *out);
 void sample_cov(MAT *data, VEC *mean, MAT *out);
-void compute_mle(gauss_t *g, size_t n);
+int compute_mle(gauss_t *g, size_t n);
+int apply_mle(gauss_t *g, const moments_t *s);
 
-FILE *setup_dataset(char *fname, gauss_t *dist, size_t n);
-MAT *gen_dataset(FILE *fp, MAT *m, gauss_t *dist, size_t n);
+int setup_dataset(char *fname, gauss_t *dist, size_t n);
+MAT *gen_dataset(MAT *m, gauss_t *dist, size_t n);
 size_t load_dataset(FILE *fp, MAT *data);
 size_t trim_zeros(MAT *m);
 void norm_sort(MAT *m);
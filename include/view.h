@@ -0,0 +1,24 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <stddef.h>
+
+#include "headers.h"
+
+// strided window onto Real storage (no ownership)
+typedef struct view_t {
+    Real *data;         // element (0, 0)
+    size_t m, n;        // rows, columns
+    ptrdiff_t rs, cs;   // row / column stride (elements)
+} view_t;
+
+#define view_at(v, i, j) ((v).data[(ptrdiff_t)(i) * (v).rs + (ptrdiff_t)(j) * (v).cs])
+// start of row i; its elements are contiguous when cs == 1
+#define view_row(v, i) ((v).data + (ptrdiff_t)(i) * (v).rs)
+
+view_t view_mat(const MAT *a);
+view_t view_rows(view_t v, size_t lo, size_t n);
+view_t view_cols(view_t v, size_t lo, size_t n);
+view_t view_trans(view_t v);
+
+#endif // VIEW_H
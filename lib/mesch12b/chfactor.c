@@ -38,22 +38,18 @@ static	char	rcsid[] = "$Id: chfactor.c,v 1.2 1994/01/13 05:36:36 des Exp $";
 
 /* Most matrix factorisation routines are in-situ unless otherwise specified */
 
-/* CHfactor -- Cholesky L.L' factorisation of A in-situ */
+/* ch_factor -- in-situ Cholesky L.L' factorisation of the n x n array A_ent
+	-- returns 0, or E_POSDEF if A is not positive definite */
 #ifndef ANSI_C
-MAT	*CHfactor(A)
-MAT	*A;
+static	int	ch_factor(A_ent,n)
+Real	**A_ent;
+unsigned int	n;
 #else
-MAT	*CHfactor(MAT *A)
+static	int	ch_factor(Real **A_ent, unsigned int n)
 #endif
 {
-	unsigned int	i, j, k, n;
-	Real	**A_ent, *A_piv, *A_row, sum, tmp;
-
-	if ( A==(MAT *)NULL )
-		error(E_NULL,"CHfactor");
-	if ( A->m != A->n )
-		error(E_SQUARE,"CHfactor");
-	n = A->n;	A_ent = A->me;
+	unsigned int	i, j, k;
+	Real	*A_piv, *A_row, sum, tmp;
 
 	for ( k=0; k<n; k++ )
 	{	
@@ -67,7 +63,7 @@ MAT	*CHfactor(MAT *A)
 			sum -= tmp*tmp;
 		}
 		if ( sum <= 0.0 )
-			error(E_POSDEF,"CHfactor");
+			return E_POSDEF;
 		A_ent[k][k] = sqrt(sum);
 
 		/* set values of column k */
@@ -86,9 +82,45 @@ MAT	*CHfactor(MAT *A)
 		}
 	}
 
+	return 0;
+}
+
+/* CHfactor -- Cholesky L.L' factorisation of A in-situ */
+#ifndef ANSI_C
+MAT	*CHfactor(A)
+MAT	*A;
+#else
+MAT	*CHfactor(MAT *A)
+#endif
+{
+	if ( A==(MAT *)NULL )
+		error(E_NULL,"CHfactor");
+	if ( A->m != A->n )
+		error(E_SQUARE,"CHfactor");
+	if ( ch_factor(A->me,A->n) )
+		error(E_POSDEF,"CHfactor");
+
 	return (A);
 }
 
+/* CHfactor_ec -- as CHfactor(), but failures are returned as an error
+	code rather than raised, so no setjmp()/longjmp() is involved
+	-- returns 0, E_NULL, E_SQUARE or E_POSDEF */
+#ifndef ANSI_C
+int	CHfactor_ec(A)
+MAT	*A;
+#else
+int	CHfactor_ec(MAT *A)
+#endif
+{
+	if ( A==(MAT *)NULL )
+		return E_NULL;
+	if ( A->m != A->n )
+		return E_SQUARE;
+
+	return ch_factor(A->me,A->n);
+}
+
 
 /* CHsolve -- given a CHolesky factorisation in A, solve A.x=b */
 #ifndef ANSI_C
@@ -99,7 +99,7 @@ static char *warn_mesg[] = {
 
 #define	MAX_ERRS	100
 
-jmp_buf	restart;
+ERR_TLS	jmp_buf	restart;
 
 
 /* array of pointers to lists of errors */
@@ -201,9 +201,9 @@ int err_is_list_attached(int list_num)
    return FALSE;
 }
 
-/* other local variables */
+/* other local variables -- per thread, as restart */
 
-static	int	err_flag = EF_EXIT, num_errs = 0, cnt_errs = 1;
+static	ERR_TLS	int	err_flag = EF_EXIT, num_errs = 0, cnt_errs = 1;
 
 /* set_err_flag -- sets err_flag -- returns old err_flag */
 #ifndef ANSI_C
@@ -89,6 +89,9 @@ static char	rcsid[] = "$Id: extras.c,v 1.4 1995/06/08 15:13:15 des Exp $";
 
 #define	REGISTER_RICH	1
 
+/* blocked kernel in mgemm.c (Mmm, Mmtrm, Mmmtr) */
+extern	void	m_gemm();
+
 /* mblar-1 routines */
 
 /* Mscale -- sets x <- alpha.x */
@@ -443,8 +446,11 @@ int	Aj0, Bj0, Cj0;
 	for ( k = 0; k < p; k++ )
 	    Maxpy(n,alpha*A[i][Aj0+k],&(B[k][Bj0]),&(C[i][Cj0]));
     ****************************************/
+    /****************************************
     for ( i = 0; i < m; i++ )
 	Mvm(p,n,alpha,B,Bj0,&(A[i][Aj0]),1.0,&(C[i][Cj0]));
+    ****************************************/
+    m_gemm(0,0,m,n,p,alpha,A,Aj0,B,Bj0,C,Cj0);
 }
 
 /* Mmtrm -- C <- C + alpha.A^T.B */
@@ -461,8 +467,11 @@ int	Aj0, Bj0, Cj0;
 	for ( k = 0; k < p; k++ )
 	    Maxpy(n,alpha*A[k][Aj0+i],&(B[k][Bj0]),&(C[i][Cj0]));
     ****************************************/
+    /****************************************
     for ( k = 0; k < p; k++ )
 	Mupdate(m,n,alpha,&(A[k][Aj0]),&(B[k][Bj0]),C,Cj0);
+    ****************************************/
+    m_gemm(1,0,m,n,p,alpha,A,Aj0,B,Bj0,C,Cj0);
 }
 
 /* Mmmtr -- C <- C + alpha.A.B^T */
@@ -479,8 +488,11 @@ int	Aj0, Bj0, Cj0;
 	for ( j = 0; j < n; j++ )
 	    C[i][Cj0+j] += alpha*Mdot(p,&(A[i][Aj0]),&(B[j][Bj0]));
     ****************************************/
+    /****************************************
     for ( i = 0; i < m; i++ )
 	Mmv(n,p,alpha,B,Bj0,&(A[i][Aj0]),1.0,&(C[i][Cj0]));
+    ****************************************/
+    m_gemm(0,1,m,n,p,alpha,A,Aj0,B,Bj0,C,Cj0);
 }
 
 /* Mmtrmtr -- C <- C + alpha.A^T.B^T */
@@ -40,36 +40,28 @@ static	char	rcsid[] = "$Id: lufactor.c,v 1.10 1995/05/16 17:26:44 des Exp $";
 
 /* Most matrix factorisation routines are in-situ unless otherwise specified */
 
-/* LUfactor -- gaussian elimination with scaled partial pivoting
-		-- Note: returns LU matrix which is A */
+/* lu_factor -- gaussian elimination with scaled partial pivoting on the
+		m x n array A_v, in-situ; pe gets the row permutation and
+		scale (m entries) is workspace */
 #ifndef ANSI_C
-MAT	*LUfactor(A,pivot)
-MAT	*A;
-PERM	*pivot;
+static	void	lu_factor(A_v,m,n,pe,scale)
+Real	**A_v, *scale;
+unsigned int	m, n, *pe;
 #else
-MAT	*LUfactor(MAT *A, PERM *pivot)
+static	void	lu_factor(Real **A_v, unsigned int m, unsigned int n,
+			  unsigned int *pe, Real *scale)
 #endif
 {
-	unsigned int	i, j, m, n;
+	unsigned int	i, j;
 	int	i_max, k, k_max;
-	Real	**A_v, *A_piv, *A_row;
+	Real	*A_piv, *A_row;
 	Real	max1, temp, tiny;
-	STATIC	VEC	*scale = VNULL;
-
-	if ( A==(MAT *)NULL || pivot==(PERM *)NULL )
-		error(E_NULL,"LUfactor");
-	if ( pivot->size != A->m )
-		error(E_SIZES,"LUfactor");
-	m = A->m;	n = A->n;
-	scale = v_resize(scale,A->m);
-	MEM_STAT_REG(scale,TYPE_VEC);
-	A_v = A->me;
 
 	tiny = 10.0/HUGE_VAL;
 
 	/* initialise pivot with identity permutation */
 	for ( i=0; i<m; i++ )
-		pivot->pe[i] = i;
+		pe[i] = i;
 
 	/* set scale parameters */
 	for ( i=0; i<m; i++ )
@@ -80,7 +72,7 @@ MAT	*LUfactor(MAT *A, PERM *pivot)
 			temp = fabs(A_v[i][j]);
 			max1 = max(max1,temp);
 		}
-		scale->ve[i] = max1;
+		scale[i] = max1;
 	}
 
 	/* main loop */
@@ -90,9 +82,9 @@ MAT	*LUfactor(MAT *A, PERM *pivot)
 	    /* find best pivot row */
 	    max1 = 0.0;	i_max = -1;
 	    for ( i=k; i<m; i++ )
-		if ( fabs(scale->ve[i]) >= tiny*fabs(A_v[i][k]) )
+		if ( fabs(scale[i]) >= tiny*fabs(A_v[i][k]) )
 		{
-		    temp = fabs(A_v[i][k])/scale->ve[i];
+		    temp = fabs(A_v[i][k])/scale[i];
 		    if ( temp > max1 )
 		    { max1 = temp;	i_max = i;	}
 		}
@@ -109,7 +101,7 @@ MAT	*LUfactor(MAT *A, PERM *pivot)
 	    /* do we pivot ? */
 	    if ( i_max != k )	/* yes we do... */
 	    {
-		px_transp(pivot,i_max,k);
+		i = pe[i_max];	pe[i_max] = pe[k];	pe[k] = i;
 		for ( j=0; j<n; j++ )
 		{
 		    temp = A_v[i_max][j];
@@ -131,9 +123,32 @@ MAT	*LUfactor(MAT *A, PERM *pivot)
 		  A_v[i][j] -= temp*A_v[k][j];
 		  (*A_row++) -= temp*(*A_piv++);
 		  *********************************************/
+		
 	    }
 	    
 	}
+}
+
+/* LUfactor -- gaussian elimination with scaled partial pivoting
+		-- Note: returns LU matrix which is A */
+#ifndef ANSI_C
+MAT	*LUfactor(A,pivot)
+MAT	*A;
+PERM	*pivot;
+#else
+MAT	*LUfactor(MAT *A, PERM *pivot)
+#endif
+{
+	STATIC	VEC	*scale = VNULL;
+
+	if ( A==(MAT *)NULL || pivot==(PERM *)NULL )
+		error(E_NULL,"LUfactor");
+	if ( pivot->size != A->m )
+		error(E_SIZES,"LUfactor");
+	scale = v_resize(scale,A->m);
+	MEM_STAT_REG(scale,TYPE_VEC);
+
+	lu_factor(A->me,A->m,A->n,pivot->pe,scale->ve);
 
 #ifdef	THREADSAFE
 	V_FREE(scale);
@@ -142,6 +157,39 @@ MAT	*LUfactor(MAT *A, PERM *pivot)
 	return A;
 }
 
+/* scale workspace below this size is kept on the stack by LUfactor_ec() */
+#define	LU_EC_STACK	64
+
+/* LUfactor_ec -- as LUfactor(), but failures are returned as an error
+	code rather than raised, so no setjmp()/longjmp() is involved
+	-- returns 0, E_NULL, E_SIZES or E_MEM */
+#ifndef ANSI_C
+int	LUfactor_ec(A,pivot)
+MAT	*A;
+PERM	*pivot;
+#else
+int	LUfactor_ec(MAT *A, PERM *pivot)
+#endif
+{
+	Real	sbuf[LU_EC_STACK], *scale;
+
+	if ( A==(MAT *)NULL || pivot==(PERM *)NULL )
+		return E_NULL;
+	if ( pivot->size != A->m )
+		return E_SIZES;
+
+	scale = ( A->m <= LU_EC_STACK ) ? sbuf : BLK_NEW_A(A->m,Real);
+	if ( ! scale )
+		return E_MEM;
+
+	lu_factor(A->me,A->m,A->n,pivot->pe,scale);
+
+	if ( scale != sbuf )
+		BLK_FREE(scale);
+
+	return 0;
+}
+
 
 /* LUsolve -- given an LU factorisation in A, solve Ax=b */
 #ifndef ANSI_C
@@ -236,6 +284,109 @@ MAT	*m_inverse(const MAT *A, MAT *out)
 	return out;
 }
 
+/* lu_solve -- solves LU.x = P.b for the n x n compact factorisation in
+		LU_v with row permutation pe; the same steps as px_vec(),
+		Lsolve(..,1.0) and Usolve(..,0.0), without raising errors
+		-- x and b must not overlap
+		-- returns 0, or E_SING */
+#ifndef ANSI_C
+static	int	lu_solve(LU_v,pe,n,b,x)
+Real	**LU_v, *b, *x;
+unsigned int	*pe;
+int	n;
+#else
+static	int	lu_solve(Real **LU_v, const unsigned int *pe, int n,
+			 const Real *b, Real *x)
+#endif
+{
+	int	i, i_lim;
+	Real	sum, tiny;
+
+	tiny = 10.0/HUGE_VAL;
+
+	for ( i = 0; i < n; i++ )
+	    x[i] = b[pe[i]];
+
+	/* forward elimination, unit diagonal */
+	for ( i = 0; i < n; i++ )
+	    if ( x[i] != 0.0 )
+		break;
+	i_lim = i;
+	for (    ; i < n; i++ )
+	    x[i] -= __ip__(&(LU_v[i][i_lim]),&(x[i_lim]),i-i_lim);
+
+	/* back substitution */
+	for ( i = n-1; i >= 0; i-- )
+	    if ( x[i] != 0.0 )
+		break;
+	i_lim = i;
+	for (    ; i >= 0; i-- )
+	{
+	    sum = x[i] - __ip__(&(LU_v[i][i+1]),&(x[i+1]),i_lim-i);
+	    if ( fabs(LU_v[i][i]) <= tiny*fabs(sum) )
+		return E_SING;
+	    x[i] = sum/LU_v[i][i];
+	}
+
+	return 0;
+}
+
+/* m_inverse_ec -- as m_inverse(), but into an existing out (at least
+	A->m x A->n, may be A itself) and with failures returned as an
+	error code rather than raised
+	-- returns 0, E_NULL, E_SQUARE, E_SIZES, E_MEM or E_SING */
+#ifndef ANSI_C
+int	m_inverse_ec(A,out)
+MAT	*A, *out;
+#else
+int	m_inverse_ec(const MAT *A, MAT *out)
+#endif
+{
+	Real	*work, **LU_v, *scale, *b, *x;
+	unsigned int	*pe;
+	int	i, j, n, rc;
+
+	if ( ! A || ! out )
+	    return E_NULL;
+	if ( A->m != A->n )
+	    return E_SQUARE;
+	if ( out->m < A->m || out->n < A->n )
+	    return E_SIZES;
+
+	n = A->n;
+	work = BLK_NEW_A((size_t)n*n+3*n,Real);
+	LU_v = BLK_NEW_A(n,Real *);
+	pe = BLK_NEW_A(n,unsigned int);
+	if ( ! work || ! LU_v || ! pe )
+	{
+	    BLK_FREE(work);	BLK_FREE(LU_v);	BLK_FREE(pe);
+	    return E_MEM;
+	}
+	scale = work + (size_t)n*n;	b = scale + n;	x = b + n;
+
+	for ( i = 0; i < n; i++ )
+	{
+	    LU_v[i] = work + (size_t)i*n;
+	    MEM_COPY(A->me[i],LU_v[i],n*sizeof(Real));
+	}
+	lu_factor(LU_v,n,n,pe,scale);
+
+	for ( i = 0; i < n; i++ )
+	    b[i] = 0.0;
+	for ( i = 0, rc = 0; i < n && ! rc; i++ )
+	{
+	    b[i] = 1.0;
+	    rc = lu_solve(LU_v,pe,n,b,x);
+	    b[i] = 0.0;
+	    for ( j = 0; j < n && ! rc; j++ )
+		out->me[j][i] = x[j];
+	}
+
+	BLK_FREE(work);	BLK_FREE(LU_v);	BLK_FREE(pe);
+
+	return rc;
+}
+
 /* LUcondest -- returns an estimate of the condition number of LU given the
 	LU factorisation in compact form */
 #ifndef ANSI_C
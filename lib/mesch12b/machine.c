@@ -35,13 +35,62 @@ static	char	*rcsid = "$Id: machine.c,v 1.4 1994/01/13 05:28:56 des Exp $";
 
 #include	"machine.h"
 
-/* __ip__ -- inner product */
+/*
+	The vector primitives below (__ip__, __mltadd__, __smlt__, __add__
+	and __sub__) dispatch at run time to SSE2, AVX2/FMA or AVX-512F
+	versions where the CPU has them (Real == double, GCC-compatible
+	compilers on x86).  The instruction set is chosen once, on first
+	use; the environment variable MESCHACH_ISA (c, sse2, avx2, avx512)
+	caps it.  Modified for CS479, Oct 2026.
+
+	Only __ip__ reorders floating point operations.  For results that
+	are bit-identical on every machine and instruction set, call
+	m_simd_repro(1) (or set MESCHACH_REPRO=1): __ip__ then sums in 8
+	fixed lanes without FMA and combines them in a fixed order.
+*/
+
+#if REAL == DOUBLE && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define	MACH_X86	1
+#include	<immintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__unix__) || defined(__APPLE__) || defined(__CYGWIN__))
+#define	MACH_THREADS	1
+#include	<pthread.h>
+#endif
+
+#ifdef ANSI_C
+typedef	double	(*ip_fn)(const Real *, const Real *, int);
+typedef	void	(*mltadd_fn)(Real *, const Real *, double, int);
+typedef	void	(*smlt_fn)(const Real *, double, Real *, int);
+typedef	void	(*add_fn)(const Real *, const Real *, Real *, int);
+#else
+typedef	double	(*ip_fn)();
+typedef	void	(*mltadd_fn)(), (*smlt_fn)(), (*add_fn)();
+#endif
+
+typedef	struct	{
+	char		*name;
+	ip_fn		ip, ip_repro;
+	mltadd_fn	mltadd, mltadd_repro;
+	smlt_fn		smlt;
+	add_fn		add, sub;
+} mach_ops;
+
+/* keep a*b+c as two roundings in the reproducible kernels */
+#if defined(__GNUC__) && ! defined(__clang__)
+#define	MACH_NOCONTRACT	__attribute__((optimize("fp-contract=off")))
+#else
+#define	MACH_NOCONTRACT
+#endif
+
+/* ip_c -- inner product, portable */
 #ifndef ANSI_C
-double	__ip__(dp1,dp2,len)
+static	double	ip_c(dp1,dp2,len)
 register Real	*dp1, *dp2;
 int	len;
 #else
-double	__ip__(const Real *dp1, const Real *dp2, int len)
+static	double	ip_c(const Real *dp1, const Real *dp2, int len)
 #endif
 {
 #ifdef VUNROLL
@@ -75,14 +124,14 @@ double	__ip__(const Real *dp1, const Real *dp2, int len)
     return sum;
 }
 
-/* __mltadd__ -- scalar multiply and add c.f. v_mltadd() */
+/* mltadd_c -- scalar multiply and add, portable */
 #ifndef ANSI_C
-void	__mltadd__(dp1,dp2,s,len)
+static	void	mltadd_c(dp1,dp2,s,len)
 register Real	*dp1, *dp2;
 register double s;
 register int	len;
 #else
-void	__mltadd__(Real *dp1, const Real *dp2, double s, int len)
+static	void	mltadd_c(Real *dp1, const Real *dp2, double s, int len)
 #endif
 {
     register int	i;
@@ -105,14 +154,14 @@ void	__mltadd__(Real *dp1, const Real *dp2, double s, int len)
 	dp1[i] += s*dp2[i];
 }
 
-/* __smlt__ scalar multiply array c.f. sv_mlt() */
+/* smlt_c -- scalar multiply array, portable */
 #ifndef ANSI_C
-void	__smlt__(dp,s,out,len)
+static	void	smlt_c(dp,s,out,len)
 register Real	*dp, *out;
 register double s;
 register int	len;
 #else
-void	__smlt__(const Real *dp, double s, Real *out, int len)
+static	void	smlt_c(const Real *dp, double s, Real *out, int len)
 #endif
 {
     register int	i;
@@ -120,13 +169,13 @@ void	__smlt__(const Real *dp, double s, Real *out, int len)
 	out[i] = s*dp[i];
 }
 
-/* __add__ -- add arrays c.f. v_add() */
+/* add_c -- add arrays, portable */
 #ifndef ANSI_C
-void	__add__(dp1,dp2,out,len)
+static	void	add_c(dp1,dp2,out,len)
 register Real	*dp1, *dp2, *out;
 register int	len;
 #else
-void	__add__(const Real *dp1, const Real *dp2, Real *out, int len)
+static	void	add_c(const Real *dp1, const Real *dp2, Real *out, int len)
 #endif
 {
     register int	i;
@@ -134,13 +183,13 @@ void	__add__(const Real *dp1, const Real *dp2, Real *out, int len)
 	out[i] = dp1[i] + dp2[i];
 }
 
-/* __sub__ -- subtract arrays c.f. v_sub() */
+/* sub_c -- subtract arrays, portable */
 #ifndef ANSI_C
-void	__sub__(dp1,dp2,out,len)
+static	void	sub_c(dp1,dp2,out,len)
 register Real	*dp1, *dp2, *out;
 register int	len;
 #else
-void	__sub__(const Real *dp1, const Real *dp2, Real *out, int len)
+static	void	sub_c(const Real *dp1, const Real *dp2, Real *out, int len)
 #endif
 {
     register int	i;
@@ -148,6 +197,570 @@ void	__sub__(const Real *dp1, const Real *dp2, Real *out, int len)
 	out[i] = dp1[i] - dp2[i];
 }
 
+/* ip_repro_c -- inner product summed in 8 fixed lanes without FMA:
+	lane j accumulates dp1[8i+j]*dp2[8i+j], the lanes combine as
+	((l0+l4)+(l2+l6)) + ((l1+l5)+(l3+l7)) and the tail is added in
+	order.  Every ip_repro_* kernel reproduces this bit for bit. */
+MACH_NOCONTRACT
+static	double	ip_repro_c(const Real *dp1, const Real *dp2, int len)
+{
+    Real	l[8], sum;
+    int		i, j;
+
+    for ( j = 0; j < 8; j++ )
+	l[j] = 0.0;
+    for ( i = 0; i+8 <= len; i += 8 )
+	for ( j = 0; j < 8; j++ )
+	    l[j] += dp1[i+j]*dp2[i+j];
+
+    sum = ((l[0]+l[4])+(l[2]+l[6])) + ((l[1]+l[5])+(l[3]+l[7]));
+    for ( ; i < len; i++ )
+	sum += dp1[i]*dp2[i];
+
+    return sum;
+}
+
+/* mltadd_repro_c -- scalar multiply and add, product rounded first */
+MACH_NOCONTRACT
+static	void	mltadd_repro_c(Real *dp1, const Real *dp2, double s, int len)
+{
+    int		i;
+
+    for ( i = 0; i < len; i++ )
+	dp1[i] += s*dp2[i];
+}
+
+#ifdef MACH_X86
+
+/* SSE2 kernels; these round the same as the portable ones, except
+	__ip__ which keeps 4 partial sums */
+__attribute__((target("sse2")))
+static	double	ip_sse2(const Real *dp1, const Real *dp2, int len)
+{
+    __m128d	s0, s1;
+    Real	t[2], sum;
+    int		i;
+
+    s0 = s1 = _mm_setzero_pd();
+    for ( i = 0; i+4 <= len; i += 4 )
+    {
+	s0 = _mm_add_pd(s0,_mm_mul_pd(_mm_loadu_pd(dp1+i),_mm_loadu_pd(dp2+i)));
+	s1 = _mm_add_pd(s1,_mm_mul_pd(_mm_loadu_pd(dp1+i+2),_mm_loadu_pd(dp2+i+2)));
+    }
+    _mm_storeu_pd(t,_mm_add_pd(s0,s1));
+    sum = t[0] + t[1];
+    for ( ; i < len; i++ )
+	sum += dp1[i]*dp2[i];
+
+    return sum;
+}
+
+MACH_NOCONTRACT
+__attribute__((target("sse2")))
+static	double	ip_repro_sse2(const Real *dp1, const Real *dp2, int len)
+{
+    __m128d	r0, r1, r2, r3;
+    Real	t[2], sum;
+    int		i;
+
+    r0 = r1 = r2 = r3 = _mm_setzero_pd();
+    for ( i = 0; i+8 <= len; i += 8 )
+    {
+	r0 = _mm_add_pd(r0,_mm_mul_pd(_mm_loadu_pd(dp1+i),_mm_loadu_pd(dp2+i)));
+	r1 = _mm_add_pd(r1,_mm_mul_pd(_mm_loadu_pd(dp1+i+2),_mm_loadu_pd(dp2+i+2)));
+	r2 = _mm_add_pd(r2,_mm_mul_pd(_mm_loadu_pd(dp1+i+4),_mm_loadu_pd(dp2+i+4)));
+	r3 = _mm_add_pd(r3,_mm_mul_pd(_mm_loadu_pd(dp1+i+6),_mm_loadu_pd(dp2+i+6)));
+    }
+    /* (l0+l4, l1+l5) + (l2+l6, l3+l7) */
+    _mm_storeu_pd(t,_mm_add_pd(_mm_add_pd(r0,r2),_mm_add_pd(r1,r3)));
+    sum = t[0] + t[1];
+    for ( ; i < len; i++ )
+	sum += dp1[i]*dp2[i];
+
+    return sum;
+}
+
+MACH_NOCONTRACT
+__attribute__((target("sse2")))
+static	void	mltadd_sse2(Real *dp1, const Real *dp2, double s, int len)
+{
+    __m128d	vs;
+    int		i;
+
+    vs = _mm_set1_pd(s);
+    for ( i = 0; i+2 <= len; i += 2 )
+	_mm_storeu_pd(dp1+i,_mm_add_pd(_mm_loadu_pd(dp1+i),
+				       _mm_mul_pd(vs,_mm_loadu_pd(dp2+i))));
+    for ( ; i < len; i++ )
+	dp1[i] += s*dp2[i];
+}
+
+__attribute__((target("sse2")))
+static	void	smlt_sse2(const Real *dp, double s, Real *out, int len)
+{
+    __m128d	vs;
+    int		i;
+
+    vs = _mm_set1_pd(s);
+    for ( i = 0; i+2 <= len; i += 2 )
+	_mm_storeu_pd(out+i,_mm_mul_pd(vs,_mm_loadu_pd(dp+i)));
+    for ( ; i < len; i++ )
+	out[i] = s*dp[i];
+}
+
+__attribute__((target("sse2")))
+static	void	add_sse2(const Real *dp1, const Real *dp2, Real *out, int len)
+{
+    int		i;
+
+    for ( i = 0; i+2 <= len; i += 2 )
+	_mm_storeu_pd(out+i,_mm_add_pd(_mm_loadu_pd(dp1+i),_mm_loadu_pd(dp2+i)));
+    for ( ; i < len; i++ )
+	out[i] = dp1[i] + dp2[i];
+}
+
+__attribute__((target("sse2")))
+static	void	sub_sse2(const Real *dp1, const Real *dp2, Real *out, int len)
+{
+    int		i;
+
+    for ( i = 0; i+2 <= len; i += 2 )
+	_mm_storeu_pd(out+i,_mm_sub_pd(_mm_loadu_pd(dp1+i),_mm_loadu_pd(dp2+i)));
+    for ( ; i < len; i++ )
+	out[i] = dp1[i] - dp2[i];
+}
+
+/* AVX2 kernels; __ip__ and __mltadd__ use FMA */
+__attribute__((target("avx2,fma")))
+static	double	ip_avx2(const Real *dp1, const Real *dp2, int len)
+{
+    __m256d	s0, s1, s2, s3;
+    __m128d	h;
+    Real	sum;
+    int		i;
+
+    s0 = s1 = s2 = s3 = _mm256_setzero_pd();
+    for ( i = 0; i+16 <= len; i += 16 )
+    {
+	s0 = _mm256_fmadd_pd(_mm256_loadu_pd(dp1+i),_mm256_loadu_pd(dp2+i),s0);
+	s1 = _mm256_fmadd_pd(_mm256_loadu_pd(dp1+i+4),_mm256_loadu_pd(dp2+i+4),s1);
+	s2 = _mm256_fmadd_pd(_mm256_loadu_pd(dp1+i+8),_mm256_loadu_pd(dp2+i+8),s2);
+	s3 = _mm256_fmadd_pd(_mm256_loadu_pd(dp1+i+12),_mm256_loadu_pd(dp2+i+12),s3);
+    }
+    for ( ; i+4 <= len; i += 4 )
+	s0 = _mm256_fmadd_pd(_mm256_loadu_pd(dp1+i),_mm256_loadu_pd(dp2+i),s0);
+
+    s0 = _mm256_add_pd(_mm256_add_pd(s0,s1),_mm256_add_pd(s2,s3));
+    h = _mm_add_pd(_mm256_castpd256_pd128(s0),_mm256_extractf128_pd(s0,1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(h,_mm_unpackhi_pd(h,h)));
+    _mm256_zeroupper();
+
+    for ( ; i < len; i++ )
+	sum += dp1[i]*dp2[i];
+
+    return sum;
+}
+
+MACH_NOCONTRACT
+__attribute__((target("avx2")))
+static	double	ip_repro_avx2(const Real *dp1, const Real *dp2, int len)
+{
+    __m256d	r0, r1;
+    __m128d	h;
+    Real	t[2], sum;
+    int		i;
+
+    r0 = r1 = _mm256_setzero_pd();
+    for ( i = 0; i+8 <= len; i += 8 )
+    {
+	r0 = _mm256_add_pd(r0,_mm256_mul_pd(_mm256_loadu_pd(dp1+i),_mm256_loadu_pd(dp2+i)));
+	r1 = _mm256_add_pd(r1,_mm256_mul_pd(_mm256_loadu_pd(dp1+i+4),_mm256_loadu_pd(dp2+i+4)));
+    }
+    /* (l0+l4, .., l3+l7), then halves */
+    r0 = _mm256_add_pd(r0,r1);
+    h = _mm_add_pd(_mm256_castpd256_pd128(r0),_mm256_extractf128_pd(r0,1));
+    _mm_storeu_pd(t,h);
+    _mm256_zeroupper();
+
+    sum = t[0] + t[1];
+    for ( ; i < len; i++ )
+	sum += dp1[i]*dp2[i];
+
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static	void	mltadd_avx2(Real *dp1, const Real *dp2, double s, int len)
+{
+    __m256d	vs;
+    int		i;
+
+    vs = _mm256_set1_pd(s);
+    for ( i = 0; i+4 <= len; i += 4 )
+	_mm256_storeu_pd(dp1+i,_mm256_fmadd_pd(vs,_mm256_loadu_pd(dp2+i),
+					      _mm256_loadu_pd(dp1+i)));
+    _mm256_zeroupper();
+    for ( ; i < len; i++ )
+	dp1[i] += s*dp2[i];
+}
+
+__attribute__((target("avx2")))
+static	void	smlt_avx2(const Real *dp, double s, Real *out, int len)
+{
+    __m256d	vs;
+    int		i;
+
+    vs = _mm256_set1_pd(s);
+    for ( i = 0; i+4 <= len; i += 4 )
+	_mm256_storeu_pd(out+i,_mm256_mul_pd(vs,_mm256_loadu_pd(dp+i)));
+    _mm256_zeroupper();
+    for ( ; i < len; i++ )
+	out[i] = s*dp[i];
+}
+
+__attribute__((target("avx2")))
+static	void	add_avx2(const Real *dp1, const Real *dp2, Real *out, int len)
+{
+    int		i;
+
+    for ( i = 0; i+4 <= len; i += 4 )
+	_mm256_storeu_pd(out+i,_mm256_add_pd(_mm256_loadu_pd(dp1+i),_mm256_loadu_pd(dp2+i)));
+    _mm256_zeroupper();
+    for ( ; i < len; i++ )
+	out[i] = dp1[i] + dp2[i];
+}
+
+__attribute__((target("avx2")))
+static	void	sub_avx2(const Real *dp1, const Real *dp2, Real *out, int len)
+{
+    int		i;
+
+    for ( i = 0; i+4 <= len; i += 4 )
+	_mm256_storeu_pd(out+i,_mm256_sub_pd(_mm256_loadu_pd(dp1+i),_mm256_loadu_pd(dp2+i)));
+    _mm256_zeroupper();
+    for ( ; i < len; i++ )
+	out[i] = dp1[i] - dp2[i];
+}
+
+/* AVX-512F kernels; tails use masked loads and stores */
+#define	TAIL8(r)	((__mmask8)((1u << (r)) - 1))
+
+__attribute__((target("avx512f")))
+static	double	ip_avx512(const Real *dp1, const Real *dp2, int len)
+{
+    __m512d	s0, s1;
+    __mmask8	k;
+    Real	sum;
+    int		i;
+
+    s0 = s1 = _mm512_setzero_pd();
+    for ( i = 0; i+16 <= len; i += 16 )
+    {
+	s0 = _mm512_fmadd_pd(_mm512_loadu_pd(dp1+i),_mm512_loadu_pd(dp2+i),s0);
+	s1 = _mm512_fmadd_pd(_mm512_loadu_pd(dp1+i+8),_mm512_loadu_pd(dp2+i+8),s1);
+    }
+    for ( ; i+8 <= len; i += 8 )
+	s0 = _mm512_fmadd_pd(_mm512_loadu_pd(dp1+i),_mm512_loadu_pd(dp2+i),s0);
+    if ( i < len )
+    {
+	k = TAIL8(len-i);
+	s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(k,dp1+i),
+			     _mm512_maskz_loadu_pd(k,dp2+i),s1);
+    }
+
+    sum = _mm512_reduce_add_pd(_mm512_add_pd(s0,s1));
+    _mm256_zeroupper();
+
+    return sum;
+}
+
+MACH_NOCONTRACT
+__attribute__((target("avx512f")))
+static	double	ip_repro_avx512(const Real *dp1, const Real *dp2, int len)
+{
+    __m512d	r;
+    __m256d	u;
+    __m128d	h;
+    Real	t[2], sum;
+    int		i;
+
+    r = _mm512_setzero_pd();
+    for ( i = 0; i+8 <= len; i += 8 )
+	r = _mm512_add_pd(r,_mm512_mul_pd(_mm512_loadu_pd(dp1+i),_mm512_loadu_pd(dp2+i)));
+    /* (l0+l4, .., l3+l7), then halves */
+    u = _mm256_add_pd(_mm512_castpd512_pd256(r),_mm512_extractf64x4_pd(r,1));
+    h = _mm_add_pd(_mm256_castpd256_pd128(u),_mm256_extractf128_pd(u,1));
+    _mm_storeu_pd(t,h);
+    _mm256_zeroupper();
+
+    sum = t[0] + t[1];
+    for ( ; i < len; i++ )
+	sum += dp1[i]*dp2[i];
+
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static	void	mltadd_avx512(Real *dp1, const Real *dp2, double s, int len)
+{
+    __m512d	vs;
+    __mmask8	k;
+    int		i;
+
+    vs = _mm512_set1_pd(s);
+    for ( i = 0; i+8 <= len; i += 8 )
+	_mm512_storeu_pd(dp1+i,_mm512_fmadd_pd(vs,_mm512_loadu_pd(dp2+i),
+					      _mm512_loadu_pd(dp1+i)));
+    if ( i < len )
+    {
+	k = TAIL8(len-i);
+	_mm512_mask_storeu_pd(dp1+i,k,
+		_mm512_fmadd_pd(vs,_mm512_maskz_loadu_pd(k,dp2+i),
+				_mm512_maskz_loadu_pd(k,dp1+i)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static	void	smlt_avx512(const Real *dp, double s, Real *out, int len)
+{
+    __m512d	vs;
+    __mmask8	k;
+    int		i;
+
+    vs = _mm512_set1_pd(s);
+    for ( i = 0; i+8 <= len; i += 8 )
+	_mm512_storeu_pd(out+i,_mm512_mul_pd(vs,_mm512_loadu_pd(dp+i)));
+    if ( i < len )
+    {
+	k = TAIL8(len-i);
+	_mm512_mask_storeu_pd(out+i,k,_mm512_mul_pd(vs,_mm512_maskz_loadu_pd(k,dp+i)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static	void	add_avx512(const Real *dp1, const Real *dp2, Real *out, int len)
+{
+    __mmask8	k;
+    int		i;
+
+    for ( i = 0; i+8 <= len; i += 8 )
+	_mm512_storeu_pd(out+i,_mm512_add_pd(_mm512_loadu_pd(dp1+i),_mm512_loadu_pd(dp2+i)));
+    if ( i < len )
+    {
+	k = TAIL8(len-i);
+	_mm512_mask_storeu_pd(out+i,k,_mm512_add_pd(_mm512_maskz_loadu_pd(k,dp1+i),
+						    _mm512_maskz_loadu_pd(k,dp2+i)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static	void	sub_avx512(const Real *dp1, const Real *dp2, Real *out, int len)
+{
+    __mmask8	k;
+    int		i;
+
+    for ( i = 0; i+8 <= len; i += 8 )
+	_mm512_storeu_pd(out+i,_mm512_sub_pd(_mm512_loadu_pd(dp1+i),_mm512_loadu_pd(dp2+i)));
+    if ( i < len )
+    {
+	k = TAIL8(len-i);
+	_mm512_mask_storeu_pd(out+i,k,_mm512_sub_pd(_mm512_maskz_loadu_pd(k,dp1+i),
+						    _mm512_maskz_loadu_pd(k,dp2+i)));
+    }
+    _mm256_zeroupper();
+}
+
+#endif /* MACH_X86 */
+
+/* kernel tables, lowest to highest; ip_repro and mltadd_repro
+	(the non-FMA mltadd) are used in reproducible mode */
+static	mach_ops	mach_tab[] = {
+    { "c",      ip_c,      ip_repro_c,      mltadd_c,      mltadd_repro_c,
+		smlt_c,      add_c,      sub_c },
+#ifdef MACH_X86
+    { "sse2",   ip_sse2,   ip_repro_sse2,   mltadd_sse2,   mltadd_sse2,
+		smlt_sse2,   add_sse2,   sub_sse2 },
+    { "avx2",   ip_avx2,   ip_repro_avx2,   mltadd_avx2,   mltadd_sse2,
+		smlt_avx2,   add_avx2,   sub_avx2 },
+    { "avx512", ip_avx512, ip_repro_avx512, mltadd_avx512, mltadd_sse2,
+		smlt_avx512, add_avx512, sub_avx512 },
+#endif
+};
+
+static	mach_ops	*mach_isa = (mach_ops *)NULL;	/* selected table */
+static	int		mach_repro = 0;
+static	ip_fn		mach_ip;		/* active __ip__ kernel */
+static	mltadd_fn	mach_mltadd;		/* active __mltadd__ kernel */
+
+/* mach_init -- picks the kernel table once, on first use
+	-- runs under pthread_once where threads exist; mach_isa is
+	   published last (release) and read with acquire, so a non-NULL
+	   mach_isa means the kernel pointers are set */
+#ifndef ANSI_C
+static	void	mach_init()
+#else
+static	void	mach_init(void)
+#endif
+{
+    mach_ops	*isa;
+    char	*env;
+    int		i, n, cap;
+
+    n = sizeof(mach_tab)/sizeof(mach_tab[0]);
+    cap = n-1;
+    if ( (env = getenv("MESCHACH_ISA")) != (char *)NULL )
+	for ( i = 0; i < n; i++ )
+	    if ( strcmp(env,mach_tab[i].name) == 0 )
+		cap = i;
+
+    i = 0;
+#ifdef MACH_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("sse2") )
+	i = 1;
+    if ( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") )
+	i = 2;
+    if ( __builtin_cpu_supports("avx512f") )
+	i = 3;
+#endif
+    isa = &(mach_tab[( i < cap ) ? i : cap]);
+
+    if ( (env = getenv("MESCHACH_REPRO")) != (char *)NULL && atoi(env) )
+	mach_repro = 1;
+
+    mach_ip     = mach_repro ? isa->ip_repro : isa->ip;
+    mach_mltadd = mach_repro ? isa->mltadd_repro : isa->mltadd;
+#ifdef MACH_THREADS
+    __atomic_store_n(&mach_isa,isa,__ATOMIC_RELEASE);
+#else
+    mach_isa = isa;
+#endif
+}
+
+#ifdef MACH_THREADS
+static	pthread_once_t	mach_once = PTHREAD_ONCE_INIT;
+#define	MACH_READY()	(__atomic_load_n(&mach_isa,__ATOMIC_ACQUIRE) != (mach_ops *)NULL)
+#define	MACH_START()	pthread_once(&mach_once,mach_init)
+#else
+#define	MACH_READY()	(mach_isa != (mach_ops *)NULL)
+#define	MACH_START()	mach_init()
+#endif
+
+/* m_simd_isa -- name of the instruction set the primitives use */
+#ifndef ANSI_C
+char	*m_simd_isa()
+#else
+const char	*m_simd_isa(void)
+#endif
+{
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    return mach_isa->name;
+}
+
+/* m_simd_repro -- sets reproducible (flag != 0) or fast summation
+	-- returns the previous setting */
+#ifndef ANSI_C
+int	m_simd_repro(flag)
+int	flag;
+#else
+int	m_simd_repro(int flag)
+#endif
+{
+    int		old;
+
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    old = mach_repro;
+    mach_repro = ( flag != 0 );
+    mach_ip     = mach_repro ? mach_isa->ip_repro : mach_isa->ip;
+    mach_mltadd = mach_repro ? mach_isa->mltadd_repro : mach_isa->mltadd;
+
+    return old;
+}
+
+/* __ip__ -- inner product */
+#ifndef ANSI_C
+double	__ip__(dp1,dp2,len)
+register Real	*dp1, *dp2;
+int	len;
+#else
+double	__ip__(const Real *dp1, const Real *dp2, int len)
+#endif
+{
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    return (*mach_ip)(dp1,dp2,len);
+}
+
+/* __mltadd__ -- scalar multiply and add c.f. v_mltadd() */
+#ifndef ANSI_C
+void	__mltadd__(dp1,dp2,s,len)
+register Real	*dp1, *dp2;
+register double s;
+register int	len;
+#else
+void	__mltadd__(Real *dp1, const Real *dp2, double s, int len)
+#endif
+{
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    (*mach_mltadd)(dp1,dp2,s,len);
+}
+
+/* __smlt__ scalar multiply array c.f. sv_mlt() */
+#ifndef ANSI_C
+void	__smlt__(dp,s,out,len)
+register Real	*dp, *out;
+register double s;
+register int	len;
+#else
+void	__smlt__(const Real *dp, double s, Real *out, int len)
+#endif
+{
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    (*mach_isa->smlt)(dp,s,out,len);
+}
+
+/* __add__ -- add arrays c.f. v_add() */
+#ifndef ANSI_C
+void	__add__(dp1,dp2,out,len)
+register Real	*dp1, *dp2, *out;
+register int	len;
+#else
+void	__add__(const Real *dp1, const Real *dp2, Real *out, int len)
+#endif
+{
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    (*mach_isa->add)(dp1,dp2,out,len);
+}
+
+/* __sub__ -- subtract arrays c.f. v_sub() */
+#ifndef ANSI_C
+void	__sub__(dp1,dp2,out,len)
+register Real	*dp1, *dp2, *out;
+register int	len;
+#else
+void	__sub__(const Real *dp1, const Real *dp2, Real *out, int len)
+#endif
+{
+    if ( ! MACH_READY() )
+	MACH_START();
+
+    (*mach_isa->sub)(dp1,dp2,out,len);
+}
+
 /* __zero__ -- zeros an array of floating point numbers */
 #ifndef ANSI_C
 void	__zero__(dp,len)
@@ -99,7 +99,7 @@ MAT	*A,*B,*OUT;
 MAT	*m_mlt(const MAT *A, const MAT *B, MAT *OUT)
 #endif
 {
-	unsigned int	i, /* j, */ k, m, n, p;
+	unsigned int	/* i, j, k, */ m, n, p;
 	Real	**A_v, **B_v /*, *B_row, *OUT_row, sum, tmp */;
 
 	if ( A==(MAT *)NULL || B==(MAT *)NULL )
@@ -125,17 +125,15 @@ MAT	*m_mlt(const MAT *A, const MAT *B, MAT *OUT)
 		}
 ****************************************************************/
 	m_zero(OUT);
+	/**************************************************
 	for ( i=0; i<m; i++ )
 		for ( k=0; k<n; k++ )
 		{
 		    if ( A_v[i][k] != 0.0 )
 		        __mltadd__(OUT->me[i],B_v[k],A_v[i][k],(int)p);
-		    /**************************************************
-		    B_row = B_v[k];	OUT_row = OUT->me[i];
-		    for ( j=0; j<p; j++ )
-			(*OUT_row++) += tmp*(*B_row++);
-		    **************************************************/
 		}
+	**************************************************/
+	m_gemm(0,0,(int)m,(int)p,(int)n,1.0,A_v,0,B_v,0,OUT->me,0);
 
 	return OUT;
 }
@@ -149,7 +147,7 @@ MAT	*A, *B, *OUT;
 MAT	*mmtr_mlt(const MAT *A, const MAT *B, MAT *OUT)
 #endif
 {
-	int	i, j, limit;
+	int	/* i, j, */ limit;
 	/* Real	*A_row, *B_row, sum; */
 
 	if ( ! A || ! B )
@@ -162,19 +160,13 @@ MAT	*mmtr_mlt(const MAT *A, const MAT *B, MAT *OUT)
 		OUT = m_resize(OUT,A->m,B->m);
 
 	limit = A->n;
+	/**************************************************
 	for ( i = 0; i < A->m; i++ )
 		for ( j = 0; j < B->m; j++ )
-		{
 		    OUT->me[i][j] = __ip__(A->me[i],B->me[j],(int)limit);
-		    /**************************************************
-		    sum = 0.0;
-		    A_row = A->me[i];
-		    B_row = B->me[j];
-		    for ( k = 0; k < limit; k++ )
-			sum += (*A_row++)*(*B_row++);
-		    OUT->me[i][j] = sum;
-		    **************************************************/
-		}
+	**************************************************/
+	m_zero(OUT);
+	m_gemm(0,1,(int)A->m,(int)B->m,limit,1.0,A->me,0,B->me,0,OUT->me,0);
 
 	return OUT;
 }
@@ -188,7 +180,7 @@ MAT	*A, *B, *OUT;
 MAT	*mtrm_mlt(const MAT *A, const MAT *B, MAT *OUT)
 #endif
 {
-	int	i, k, limit;
+	int	/* i, k, */ limit;
 	/* Real	*B_row, *OUT_row, multiplier; */
 
 	if ( ! A || ! B )
@@ -202,19 +194,15 @@ MAT	*mtrm_mlt(const MAT *A, const MAT *B, MAT *OUT)
 
 	limit = B->n;
 	m_zero(OUT);
+	/**************************************************
 	for ( k = 0; k < A->m; k++ )
 		for ( i = 0; i < A->n; i++ )
 		{
 		    if ( A->me[k][i] != 0.0 )
 			__mltadd__(OUT->me[i],B->me[k],A->me[k][i],(int)limit);
-		    /**************************************************
-		    multiplier = A->me[k][i];
-		    OUT_row = OUT->me[i];
-		    B_row   = B->me[k];
-		    for ( j = 0; j < limit; j++ )
-			*(OUT_row++) += multiplier*(*B_row++);
-		    **************************************************/
 		}
+	**************************************************/
+	m_gemm(1,0,(int)A->n,limit,(int)A->m,1.0,A->me,0,B->me,0,OUT->me,0);
 
 	return OUT;
 }
@@ -42,6 +42,7 @@
 extern	MAT	*BKPfactor(), *CHfactor(), *LUfactor(), *QRfactor(),
 		*QRCPfactor(), *LDLfactor(), *Hfactor(), *MCHfactor(),
 		*m_inverse();
+extern	int	CHfactor_ec(), LUfactor_ec(), m_inverse_ec();
 extern	double	LUcondest(), QRcondest();
 extern	MAT	*makeQ(), *makeR(), *makeHQ(), *makeH();
 extern	MAT	*LDLupdate(), *QRupdate();
@@ -108,6 +109,12 @@ extern	MAT	*BKPfactor(MAT *A,PERM *pivot,PERM *blocks),
                 *MCHfactor(MAT *A,double tol),
 		*m_inverse(const MAT *A,MAT *out);
 
+                /* as CHfactor(), LUfactor() and m_inverse(), but return
+                        0 or an E_* code instead of raising errors */
+extern	int	CHfactor_ec(MAT *A),
+		LUfactor_ec(MAT *A,PERM *pivot),
+		m_inverse_ec(const MAT *A,MAT *out);
+
                 /* returns condition estimate for A after LUfactor() */
 extern	double	LUcondest(const MAT *A, PERM *pivot),
                 /* returns condition estimate for Q after QRfactor() */
@@ -31,6 +31,439 @@
 
 static	char	rcsid[] = "$Id: memory.c,v 1.13 1994/04/05 02:10:37 des Exp $";
 
+/*
+	Block allocator for VEC, MAT and PERM storage.
+	Modified for CS479, Oct 2026.
+
+	Every block carries a 16 byte header giving its size class.
+	mem_blk_align() hands out blocks on a larger power-of-two
+	boundary (MAT storage uses MAT_ALIGN); they keep it when resized.
+	Blocks up to 64KB come in power-of-two classes and are cached
+	on per-class free lists when freed, so steady get/free traffic
+	does not reach malloc; larger blocks are malloc'd at their exact
+	size.  The lists are per thread
+	where __thread is available and are returned to malloc when the
+	thread exits.
+
+	A thread can also route its allocations into an arena with
+	mem_arena_use().  Arena blocks are bump-allocated from reusable
+	chunks and freeing them is a no-op.  mem_arena_release() returns
+	everything allocated since a mem_arena_mark() at once, which also
+	reclaims temporaries that were never freed.  Objects from an arena
+	must not be used after their mark is released.  A resized block
+	is reallocated from where it came from (the heap, or its own
+	arena) whatever arena is in use at the time; in a nested mark of
+	its own arena the new storage belongs to the inner mark.
+
+	If mem_hook is set, it sees every MAT, VEC and PERM get, resize
+	and free (MEM_EV_*), e.g. for an allocation profiler.
+*/
+
+#if defined(__GNUC__) && (defined(__unix__) || defined(__APPLE__) || defined(__CYGWIN__))
+#define	MEM_THREADS	1
+#include	<pthread.h>
+#define	MEM_TLS	__thread
+#else
+#define	MEM_TLS
+#endif
+
+#define	MEM_MINSHIFT	4		/* smallest class: 16 bytes */
+#define	MEM_NCACHE	13		/* classes (all cached): up to 64KB */
+#define	MEM_MAXCACHE	32		/* blocks kept per class */
+#define	MEM_CHUNK_DEF	65536		/* default arena chunk */
+
+#define	MEM_LARGE	(-1)		/* class of malloc()'d blocks */
+#define	MEM_IN_ARENA	(-2)		/* class of arena blocks */
+#define	MEM_OFFSET	(-3)		/* aligned block inside another */
+
+typedef	union	mem_hdr {
+	struct	{
+	    size_t	size;		/* usable bytes */
+	    int		cls;
+	    unsigned short	off;	/* MEM_OFFSET: bytes past the outer block */
+	    unsigned short	align;	/* alignment kept on resize */
+	}	h;
+	double	align[2];
+	union	mem_hdr	*next;		/* free list link (cached only) */
+} mem_hdr;
+
+#define	HDR(p)		((mem_hdr *)(p) - 1)
+#define	ROUND16(n)	(((n) + 15) & ~(size_t)15)
+/* chunk data starts 16 byte aligned, like malloc()'d blocks */
+#define	CHUNK_HDR	ROUND16(sizeof(MEM_CHUNK))
+/* arena blocks keep their arena in the slot before the header */
+#define	ARENA_OF(b)	(*(MEM_ARENA **)((b) - 1))
+
+static	MEM_TLS	mem_hdr		*mem_cache[MEM_NCACHE];
+static	MEM_TLS	int		mem_ncache[MEM_NCACHE];
+static	MEM_TLS	MEM_ARENA	*mem_arena = (MEM_ARENA *)NULL;
+
+#ifdef ANSI_C
+void	(*mem_hook)(int, int, void *, int) = NULL;
+#else
+void	(*mem_hook)() = NULL;
+#endif
+
+/* mem_observe -- reports an event on obj to mem_hook, if one is set */
+#ifndef ANSI_C
+static	void	mem_observe(ev,type,obj)
+int	ev, type;
+void	*obj;
+#else
+static	void	mem_observe(int ev, int type, void *obj)
+#endif
+{
+   if ( mem_hook && obj )
+      (*mem_hook)(ev,type,obj,mem_arena != (MEM_ARENA *)NULL);
+}
+
+#ifdef MEM_THREADS
+static	pthread_once_t	mem_once = PTHREAD_ONCE_INIT;
+static	pthread_key_t	mem_key;
+static	MEM_TLS	int	mem_keyed = 0;
+
+static	void	mem_thread_exit(void *arg)
+{
+   mem_cache_flush();
+}
+
+static	void	mem_key_init(void)
+{
+   pthread_key_create(&mem_key,mem_thread_exit);
+}
+#endif
+
+/* mem_cache_flush -- returns the calling thread's cached blocks to malloc */
+#ifndef ANSI_C
+void	mem_cache_flush()
+#else
+void	mem_cache_flush(void)
+#endif
+{
+   mem_hdr	*b;
+   int	c;
+
+   for ( c = 0; c < MEM_NCACHE; c++ )
+   {
+      while ( (b = mem_cache[c]) != (mem_hdr *)NULL )
+      {
+	 mem_cache[c] = b->next;
+	 free((char *)b);
+      }
+      mem_ncache[c] = 0;
+   }
+}
+
+/* mem_arena_alloc -- bump-allocates a block of size bytes from a */
+static	mem_hdr	*mem_arena_alloc(MEM_ARENA *a, size_t size)
+{
+   MEM_CHUNK	*ch;
+   mem_hdr	*b;
+   size_t	need;
+
+   need = 2*sizeof(mem_hdr) + ROUND16(size);
+   ch = a->cur;
+   while ( ch->used + need > ch->size )
+   {
+      if ( ch->next && ch->next->size >= need )
+      {	/* reuse a chunk freed by mem_arena_release() */
+	 ch = ch->next;
+	 ch->used = 0;
+	 continue;
+      }
+      /* splice in a fresh chunk after the current one */
+      {
+	 MEM_CHUNK	*nw;
+	 size_t	csize = max(a->chunk,need);
+
+	 nw = (MEM_CHUNK *)malloc(CHUNK_HDR+csize);
+	 if ( nw == (MEM_CHUNK *)NULL )
+	   return (mem_hdr *)NULL;
+	 nw->size = csize;	nw->used = 0;
+	 nw->next = ch->next;	ch->next = nw;
+	 ch = nw;
+      }
+   }
+   a->cur = ch;
+
+   b = (mem_hdr *)((char *)ch + CHUNK_HDR + ch->used) + 1;
+   ch->used += need;
+   ARENA_OF(b) = a;
+   b->h.size = ROUND16(size);
+   b->h.cls = MEM_IN_ARENA;
+   b->h.align = 16;
+
+   return b;
+}
+
+/* mem_blk_get -- gets size bytes of zeroed storage
+	-- from the thread's current arena if one is in use */
+#ifndef ANSI_C
+void	*mem_blk_get(size)
+size_t	size;
+#else
+void	*mem_blk_get(size_t size)
+#endif
+{
+   mem_hdr	*b;
+   size_t	bytes;
+   int	c;
+
+   if ( mem_arena )
+   {
+      if ( (b = mem_arena_alloc(mem_arena,size)) == (mem_hdr *)NULL )
+	return NULL;
+      MEM_ZERO((char *)(b+1),size);
+      return (void *)(b+1);
+   }
+
+   for ( c = 0, bytes = (size_t)1 << MEM_MINSHIFT;
+	 c < MEM_NCACHE && bytes < size; c++, bytes <<= 1 )
+     ;
+
+   if ( c < MEM_NCACHE && (b = mem_cache[c]) != (mem_hdr *)NULL )
+   {
+      mem_cache[c] = b->next;
+      mem_ncache[c]--;
+   }
+   else if ( c < MEM_NCACHE )
+   {
+      if ( (b = (mem_hdr *)malloc(sizeof(mem_hdr)+bytes)) == (mem_hdr *)NULL )
+	return NULL;
+   }
+   else
+   {
+      bytes = size;
+      c = MEM_LARGE;
+      if ( (b = (mem_hdr *)malloc(sizeof(mem_hdr)+bytes)) == (mem_hdr *)NULL )
+	return NULL;
+   }
+
+   b->h.size = bytes;
+   b->h.cls = c;
+   b->h.align = 16;
+   MEM_ZERO((char *)(b+1),size);
+
+   return (void *)(b+1);
+}
+
+/* mem_blk_align -- as mem_blk_get(), aligned on align bytes
+	-- align is a power of two; at most 16 gives mem_blk_get() */
+#ifndef ANSI_C
+void	*mem_blk_align(size,align)
+size_t	size, align;
+#else
+void	*mem_blk_align(size_t size, size_t align)
+#endif
+{
+   mem_hdr	*b;
+   char	*raw, *p;
+
+   if ( align <= 16 )
+     return mem_blk_get(size);
+
+   /* blocks are 16 byte aligned, so the shift is at most align-16 */
+   if ( (raw = (char *)mem_blk_get(size+align-16)) == NULL )
+     return NULL;
+   p = (char *)(((size_t)raw + align-1) & ~(align-1));
+   if ( p == raw )
+   {
+      HDR(raw)->h.align = align;
+      return (void *)raw;
+   }
+
+   /* header for the aligned block sits in the outer block's space */
+   b = HDR(p);
+   b->h.size = size;
+   b->h.cls = MEM_OFFSET;
+   b->h.off = p - raw;
+   b->h.align = align;
+
+   return (void *)p;
+}
+
+/* mem_blk_free -- returns storage from mem_blk_get()
+	-- cached for reuse if small, a no-op for arena blocks */
+#ifndef ANSI_C
+void	mem_blk_free(p)
+void	*p;
+#else
+void	mem_blk_free(void *p)
+#endif
+{
+   mem_hdr	*b;
+   int	c;
+
+   if ( p == NULL )
+     return;
+
+   b = HDR(p);
+   c = b->h.cls;
+   if ( c == MEM_IN_ARENA )
+     return;
+   if ( c == MEM_OFFSET )
+   {
+      mem_blk_free((void *)((char *)p - b->h.off));
+      return;
+   }
+
+   if ( c >= 0 && c < MEM_NCACHE && mem_ncache[c] < MEM_MAXCACHE )
+   {
+#ifdef MEM_THREADS
+      if ( ! mem_keyed )
+      {	/* flush this thread's lists when it exits */
+	 pthread_once(&mem_once,mem_key_init);
+	 pthread_setspecific(mem_key,(void *)&mem_keyed);
+	 mem_keyed = 1;
+      }
+#endif
+      b->next = mem_cache[c];
+      mem_cache[c] = b;
+      mem_ncache[c]++;
+      return;
+   }
+
+   free((char *)b);
+}
+
+/* mem_blk_renew -- resizes storage from mem_blk_get() to size bytes,
+	keeping the contents, alignment and source (cf. RENEW)
+	-- heap blocks stay on the heap and arena blocks in their arena,
+	   whichever arena the thread is using */
+#ifndef ANSI_C
+void	*mem_blk_renew(p,size)
+void	*p;
+size_t	size;
+#else
+void	*mem_blk_renew(void *p, size_t size)
+#endif
+{
+   mem_hdr	*b, *src;
+   MEM_ARENA	*old;
+   void	*nw;
+
+   if ( p == NULL )
+     return mem_blk_get(size);
+
+   b = HDR(p);
+   if ( size <= b->h.size )
+     return p;
+
+   src = ( b->h.cls == MEM_OFFSET ) ? HDR((char *)p - b->h.off) : b;
+   old = mem_arena;
+   mem_arena = ( src->h.cls == MEM_IN_ARENA ) ? ARENA_OF(src) : (MEM_ARENA *)NULL;
+   nw = mem_blk_align(size,b->h.align);
+   mem_arena = old;
+   if ( nw == NULL )
+     return NULL;
+   MEM_COPY((char *)p,(char *)nw,min(size,b->h.size));
+   mem_blk_free(p);
+
+   return nw;
+}
+
+/* mem_arena_get -- creates an arena allocating chunk bytes at a time
+	-- chunk == 0 gives the default (64KB) */
+#ifndef ANSI_C
+MEM_ARENA	*mem_arena_get(chunk)
+size_t	chunk;
+#else
+MEM_ARENA	*mem_arena_get(size_t chunk)
+#endif
+{
+   MEM_ARENA	*a;
+
+   if ( chunk == 0 )
+     chunk = MEM_CHUNK_DEF;
+
+   if ( (a = NEW(MEM_ARENA)) == (MEM_ARENA *)NULL )
+     error(E_MEM,"mem_arena_get");
+   if ( (a->head = (MEM_CHUNK *)malloc(CHUNK_HDR+chunk)) == (MEM_CHUNK *)NULL )
+   {
+      free((char *)a);
+      error(E_MEM,"mem_arena_get");
+   }
+   a->head->next = (MEM_CHUNK *)NULL;
+   a->head->size = chunk;
+   a->head->used = 0;
+   a->cur = a->head;
+   a->chunk = chunk;
+
+   return a;
+}
+
+/* mem_arena_free -- frees an arena and everything allocated from it */
+#ifndef ANSI_C
+int	mem_arena_free(a)
+MEM_ARENA	*a;
+#else
+int	mem_arena_free(MEM_ARENA *a)
+#endif
+{
+   MEM_CHUNK	*ch, *next;
+
+   if ( a == (MEM_ARENA *)NULL )
+     return (-1);
+   if ( mem_arena == a )
+     mem_arena = (MEM_ARENA *)NULL;
+
+   for ( ch = a->head; ch != (MEM_CHUNK *)NULL; ch = next )
+   {
+      next = ch->next;
+      free((char *)ch);
+   }
+   free((char *)a);
+
+   return (0);
+}
+
+/* mem_arena_use -- makes a the calling thread's allocation arena
+	(NULL for the heap) -- returns the previous one */
+#ifndef ANSI_C
+MEM_ARENA	*mem_arena_use(a)
+MEM_ARENA	*a;
+#else
+MEM_ARENA	*mem_arena_use(MEM_ARENA *a)
+#endif
+{
+   MEM_ARENA	*old;
+
+   old = mem_arena;
+   mem_arena = a;
+
+   return old;
+}
+
+/* mem_arena_mark -- current fill point of a, for mem_arena_release() */
+#ifndef ANSI_C
+MEM_MARK	mem_arena_mark(a)
+MEM_ARENA	*a;
+#else
+MEM_MARK	mem_arena_mark(const MEM_ARENA *a)
+#endif
+{
+   MEM_MARK	mk;
+
+   mk.chunk = a->cur;
+   mk.used = a->cur->used;
+
+   return mk;
+}
+
+/* mem_arena_release -- frees everything allocated from a since mark */
+#ifndef ANSI_C
+void	mem_arena_release(a,mk)
+MEM_ARENA	*a;
+MEM_MARK	mk;
+#else
+void	mem_arena_release(MEM_ARENA *a, MEM_MARK mk)
+#endif
+{
+   a->cur = mk.chunk;
+   a->cur->used = mk.used;
+}
+
+
 /* m_get -- gets an mxn matrix (in MAT form) by dynamic memory allocation
 	-- normally ALL matrices should be obtained this way
 	-- if either m or n is negative this will raise an error
@@ -48,7 +481,7 @@ MAT	*m_get(int m, int n)
    if (m < 0 || n < 0)
      error(E_NEG,"m_get");
 
-   if ((matrix=NEW(MAT)) == (MAT *)NULL )
+   if ((matrix=BLK_NEW(MAT)) == (MAT *)NULL )
      error(E_MEM,"m_get");
    else if (mem_info_is_on()) {
       mem_bytes(TYPE_MAT,0,sizeof(MAT));
@@ -58,9 +491,9 @@ MAT	*m_get(int m, int n)
    matrix->m = m;		matrix->n = matrix->max_n = n;
    matrix->max_m = m;	matrix->max_size = m*n;
 #ifndef SEGMENTED
-   if ((matrix->base = NEW_A(m*n,Real)) == (Real *)NULL )
+   if ((matrix->base = BLK_NEW_AL(m*n,Real,MAT_ALIGN)) == (Real *)NULL )
    {
-      free(matrix);
+      BLK_FREE(matrix);
       error(E_MEM,"m_get");
    }
    else if (mem_info_is_on()) {
@@ -69,9 +502,9 @@ MAT	*m_get(int m, int n)
 #else
    matrix->base = (Real *)NULL;
 #endif
-   if ((matrix->me = (Real **)calloc(m,sizeof(Real *))) == 
+   if ((matrix->me = BLK_NEW_A(m,Real *)) == 
        (Real **)NULL )
-   {	free(matrix->base);	free(matrix);
+   {	BLK_FREE(matrix->base);	BLK_FREE(matrix);
 	error(E_MEM,"m_get");
      }
    else if (mem_info_is_on()) {
@@ -84,13 +517,15 @@ MAT	*m_get(int m, int n)
      matrix->me[i] = &(matrix->base[i*n]);
 #else
    for ( i = 0; i < m; i++ )
-     if ( (matrix->me[i]=NEW_A(n,Real)) == (Real *)NULL )
+     if ( (matrix->me[i]=BLK_NEW_A(n,Real)) == (Real *)NULL )
        error(E_MEM,"m_get");
      else if (mem_info_is_on()) {
 	mem_bytes(TYPE_MAT,0,n*sizeof(Real));
        }
 #endif
    
+   mem_observe(MEM_EV_NEW,TYPE_MAT,(void *)matrix);
+
    return (matrix);
 }
 
@@ -111,7 +546,7 @@ PERM	*px_get(int size)
    if (size < 0)
      error(E_NEG,"px_get");
 
-   if ((permute=NEW(PERM)) == (PERM *)NULL )
+   if ((permute=BLK_NEW(PERM)) == (PERM *)NULL )
      error(E_MEM,"px_get");
    else if (mem_info_is_on()) {
       mem_bytes(TYPE_PERM,0,sizeof(PERM));
@@ -119,7 +554,7 @@ PERM	*px_get(int size)
    }
    
    permute->size = permute->max_size = size;
-   if ((permute->pe = NEW_A(size,unsigned int)) == (unsigned int *)NULL )
+   if ((permute->pe = BLK_NEW_A(size,unsigned int)) == (unsigned int *)NULL )
      error(E_MEM,"px_get");
    else if (mem_info_is_on()) {
       mem_bytes(TYPE_PERM,0,size*sizeof(unsigned int));
@@ -128,6 +563,8 @@ PERM	*px_get(int size)
    for ( i=0; i<size; i++ )
      permute->pe[i] = i;
    
+   mem_observe(MEM_EV_NEW,TYPE_PERM,(void *)permute);
+
    return (permute);
 }
 
@@ -145,7 +582,7 @@ VEC	*v_get(int size)
    if (size < 0)
      error(E_NEG,"v_get");
 
-   if ((vector=NEW(VEC)) == (VEC *)NULL )
+   if ((vector=BLK_NEW(VEC)) == (VEC *)NULL )
      error(E_MEM,"v_get");
    else if (mem_info_is_on()) {
       mem_bytes(TYPE_VEC,0,sizeof(VEC));
@@ -153,15 +590,17 @@ VEC	*v_get(int size)
    }
    
    vector->dim = vector->max_dim = size;
-   if ((vector->ve=NEW_A(size,Real)) == (Real *)NULL )
+   if ((vector->ve=BLK_NEW_A(size,Real)) == (Real *)NULL )
    {
-      free(vector);
+      BLK_FREE(vector);
       error(E_MEM,"v_get");
    }
    else if (mem_info_is_on()) {
       mem_bytes(TYPE_VEC,0,size*sizeof(Real));
    }
    
+   mem_observe(MEM_EV_NEW,TYPE_VEC,(void *)vector);
+
    return (vector);
 }
 
@@ -182,12 +621,14 @@ int	m_free(MAT *mat)
      /* don't trust it */
      return (-1);
    
+   mem_observe(MEM_EV_FREE,TYPE_MAT,(void *)mat);
+
 #ifndef SEGMENTED
    if ( mat->base != (Real *)NULL ) {
       if (mem_info_is_on()) {
 	 mem_bytes(TYPE_MAT,mat->max_m*mat->max_n*sizeof(Real),0);
       }
-      free((char *)(mat->base));
+      BLK_FREE(mat->base);
    }
 #else
    for ( i = 0; i < mat->max_m; i++ )
@@ -195,21 +636,21 @@ int	m_free(MAT *mat)
 	if (mem_info_is_on()) {
 	   mem_bytes(TYPE_MAT,mat->max_n*sizeof(Real),0);
 	}
-	free((char *)(mat->me[i]));
+	BLK_FREE(mat->me[i]);
      }
 #endif
    if ( mat->me != (Real **)NULL ) {
       if (mem_info_is_on()) {
 	 mem_bytes(TYPE_MAT,mat->max_m*sizeof(Real *),0);
       }
-      free((char *)(mat->me));
+      BLK_FREE(mat->me);
    }
    
    if (mem_info_is_on()) {
       mem_bytes(TYPE_MAT,sizeof(MAT),0);
       mem_numvar(TYPE_MAT,-1);
    }
-   free((char *)mat);
+   BLK_FREE(mat);
    
    return (0);
 }
@@ -228,12 +669,14 @@ int	px_free(PERM *px)
      /* don't trust it */
      return (-1);
    
+   mem_observe(MEM_EV_FREE,TYPE_PERM,(void *)px);
+
    if ( px->pe == (unsigned int *)NULL ) {
       if (mem_info_is_on()) {
 	 mem_bytes(TYPE_PERM,sizeof(PERM),0);
 	 mem_numvar(TYPE_PERM,-1);
       }      
-      free((char *)px);
+      BLK_FREE(px);
    }
    else
    {
@@ -241,8 +684,8 @@ int	px_free(PERM *px)
 	 mem_bytes(TYPE_PERM,sizeof(PERM)+px->max_size*sizeof(unsigned int),0);
 	 mem_numvar(TYPE_PERM,-1);
       }
-      free((char *)px->pe);
-      free((char *)px);
+      BLK_FREE(px->pe);
+      BLK_FREE(px);
    }
    
    return (0);
@@ -262,12 +705,14 @@ int	v_free(VEC *vec)
      /* don't trust it */
      return (-1);
    
+   mem_observe(MEM_EV_FREE,TYPE_VEC,(void *)vec);
+
    if ( vec->ve == (Real *)NULL ) {
       if (mem_info_is_on()) {
 	 mem_bytes(TYPE_VEC,sizeof(VEC),0);
 	 mem_numvar(TYPE_VEC,-1);
       }
-      free((char *)vec);
+      BLK_FREE(vec);
    }
    else
    {
@@ -275,8 +720,8 @@ int	v_free(VEC *vec)
 	 mem_bytes(TYPE_VEC,sizeof(VEC)+vec->max_dim*sizeof(Real),0);
 	 mem_numvar(TYPE_VEC,-1);
       }
-      free((char *)vec->ve);
-      free((char *)vec);
+      BLK_FREE(vec->ve);
+      BLK_FREE(vec);
    }
    
    return (0);
@@ -315,7 +760,7 @@ MAT	*m_resize(MAT *A,int new_m, int new_n)
 		      new_m*sizeof(Real *));
       }
 
-      A->me = RENEW(A->me,new_m,Real *);
+      A->me = BLK_RENEW(A->me,new_m,Real *);
       if ( ! A->me )
 	error(E_MEM,"m_resize");
    }
@@ -331,7 +776,7 @@ MAT	*m_resize(MAT *A,int new_m, int new_n)
 		      new_size*sizeof(Real));
       }
 
-      A->base = RENEW(A->base,new_size,Real);
+      A->base = BLK_RENEW(A->base,new_size,Real);
       if ( ! A->base )
 	error(E_MEM,"m_resize");
       A->max_size = new_size;
@@ -376,7 +821,7 @@ MAT	*m_resize(MAT *A,int new_m, int new_n)
 			 new_max_n*sizeof(Real));
 	 }	
 
-	 if ( (tmp = RENEW(A->me[i],new_max_n,Real)) == NULL )
+	 if ( (tmp = BLK_RENEW(A->me[i],new_max_n,Real)) == NULL )
 	   error(E_MEM,"m_resize");
 	 else {	
 	    A->me[i] = tmp;
@@ -384,7 +829,7 @@ MAT	*m_resize(MAT *A,int new_m, int new_n)
       }
       for ( i = A->max_m; i < new_max_m; i++ )
       {
-	 if ( (tmp = NEW_A(new_max_n,Real)) == NULL )
+	 if ( (tmp = BLK_NEW_A(new_max_n,Real)) == NULL )
 	   error(E_MEM,"m_resize");
 	 else {
 	    A->me[i] = tmp;
@@ -398,7 +843,7 @@ MAT	*m_resize(MAT *A,int new_m, int new_n)
    else if ( A->max_m < new_m )
    {
       for ( i = A->max_m; i < new_m; i++ ) 
-	if ( (A->me[i] = NEW_A(new_max_n,Real)) == NULL )
+	if ( (A->me[i] = BLK_NEW_A(new_max_n,Real)) == NULL )
 	  error(E_MEM,"m_resize");
 	else if (mem_info_is_on()) {
 	   mem_bytes(TYPE_MAT,0,new_max_n*sizeof(Real));
@@ -422,6 +867,8 @@ MAT	*m_resize(MAT *A,int new_m, int new_n)
    A->max_size = A->max_m*A->max_n;
    A->m = new_m;	A->n = new_n;
    
+   mem_observe(MEM_EV_RESIZE,TYPE_MAT,(void *)A);
+
    return A;
 }
 
@@ -453,7 +900,7 @@ PERM	*px_resize(PERM *px, int new_size)
 	 mem_bytes(TYPE_PERM,px->max_size*sizeof(unsigned int),
 		      new_size*sizeof(unsigned int));
       }
-      px->pe = RENEW(px->pe,new_size,unsigned int);
+      px->pe = BLK_RENEW(px->pe,new_size,unsigned int);
       if ( ! px->pe )
 	error(E_MEM,"px_resize");
       px->max_size = new_size;
@@ -468,6 +915,8 @@ PERM	*px_resize(PERM *px, int new_size)
    
    px->size = new_size;
    
+   mem_observe(MEM_EV_RESIZE,TYPE_PERM,(void *)px);
+
    return px;
 }
 
@@ -502,7 +951,7 @@ VEC	*v_resize(VEC *x, int new_dim)
 			 new_dim*sizeof(Real));
       }
 
-      x->ve = RENEW(x->ve,new_dim,Real);
+      x->ve = BLK_RENEW(x->ve,new_dim,Real);
       if ( ! x->ve )
 	error(E_MEM,"v_resize");
       x->max_dim = new_dim;
@@ -512,6 +961,8 @@ VEC	*v_resize(VEC *x, int new_dim)
      __zero__(&(x->ve[x->dim]),new_dim - x->dim);
    x->dim = new_dim;
    
+   mem_observe(MEM_EV_RESIZE,TYPE_VEC,(void *)x);
+
    return x;
 }
 
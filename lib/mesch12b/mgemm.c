@@ -0,0 +1,341 @@
+
+/**************************************************************************
+**
+** Copyright (C) 1993 David E. Steward & Zbigniew Leyk, all rights reserved.
+**
+**			     Meschach Library
+**
+** This Meschach Library is provided "as is" without any express
+** or implied warranty of any kind with respect to this software.
+** In particular the authors shall not be liable for any direct,
+** indirect, special, incidental or consequential damages arising
+** in any way from use of the software.
+**
+** Everyone is granted permission to copy, modify and redistribute this
+** Meschach Library, provided:
+**  1.  All copies contain this copyright notice.
+**  2.  All modified copies shall carry a notice stating who
+**      made the last modification and the date of such modification.
+**  3.  No charge is made for this software or works derived from it.
+**      This clause shall not be construed as constraining other software
+**      distributed on the same medium as this software, nor is a
+**      distribution fee considered a charge.
+**
+***************************************************************************/
+
+
+/*
+	mgemm.c -- packed, cache-blocked matrix-matrix multiply
+	Added for CS479 (Oct 2026); not part of the original distribution.
+
+	C <- C + alpha.op(A).op(B), op(X) = X or X^T, with the matrices
+	given as Real ** rows plus an initial column as in extras.c.
+
+	Blocking follows the usual GotoBLAS layout: a KC x NC panel of
+	op(B) is packed into NR-wide column strips, an MC x KC block of
+	op(A) into MR-high row strips (both zero padded), and an MR x NR
+	register-blocked microkernel runs over the packed strips. The
+	microkernel is AVX2/FMA when the CPU has it (chosen once at run
+	time) and portable C otherwise. Small products skip the packing.
+
+	The pack buffers are sized to the product (up to one full block
+	and panel) and kept per thread, growing only; they are freed
+	when the thread exits.
+*/
+
+#include	<stdio.h>
+#include	"matrix.h"
+
+#if defined(__GNUC__) && (defined(__unix__) || defined(__APPLE__) || defined(__CYGWIN__))
+#define	MGEMM_THREADS	1
+#include	<pthread.h>
+#define	MGEMM_TLS	__thread
+#else
+#define	MGEMM_TLS
+#endif
+
+static	char	rcsid[] = "$Id: mgemm.c,v 1.0 2026/10/17 $";
+
+#if REAL == DOUBLE && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define	MGEMM_X86	1
+#include	<immintrin.h>
+#endif
+
+#define	MR	4		/* microkernel rows */
+#define	NR	8		/* microkernel columns */
+#define	MC	96		/* rows of op(A) per packed block (~L2) */
+#define	KC	256		/* inner dimension per packed block (~L1) */
+#define	NC	2048		/* columns of op(B) per packed panel (~L3) */
+
+/* below this many multiply-adds the packing does not pay */
+#define	MGEMM_SMALL	(32*32*32)
+
+/* the calling thread's pack buffers for op(A) [0] and op(B) [1] */
+static	MGEMM_TLS	Real	*pack_buf[2];
+static	MGEMM_TLS	size_t	pack_len[2];
+
+#ifdef MGEMM_THREADS
+static	pthread_once_t	pack_once = PTHREAD_ONCE_INIT;
+static	pthread_key_t	pack_key;
+
+static	void	pack_exit(void *arg)
+{
+	free((char *)pack_buf[0]);
+	free((char *)pack_buf[1]);
+	pack_buf[0] = pack_buf[1] = (Real *)NULL;
+	pack_len[0] = pack_len[1] = 0;
+}
+
+static	void	pack_key_init(void)
+{
+	pthread_key_create(&pack_key,pack_exit);
+}
+#endif
+
+/* pack_get -- pack buffer i of at least len Reals, grown if needed */
+static	Real	*pack_get(int i, size_t len)
+{
+	if ( len <= pack_len[i] )
+	    return pack_buf[i];
+
+	free((char *)pack_buf[i]);
+	pack_len[i] = 0;
+	if ( ! (pack_buf[i] = (Real *)malloc(len*sizeof(Real))) )
+	    error(E_MEM,"m_gemm");
+	pack_len[i] = len;
+#ifdef MGEMM_THREADS
+	pthread_once(&pack_once,pack_key_init);
+	pthread_setspecific(pack_key,(void *)pack_buf);
+#endif
+
+	return pack_buf[i];
+}
+
+typedef	void	(*mgemm_kern)(int kc, const Real *a, const Real *b,
+			      double alpha, Real **C, int i0, int j0,
+			      int mr, int nr);
+
+/* op(A)[i][k] */
+#define	OPA(A,ta,j0,i,k)	((ta) ? (A)[k][(j0)+(i)] : (A)[i][(j0)+(k)])
+/* op(B)[k][j] */
+#define	OPB(B,tb,j0,k,j)	((tb) ? (B)[j][(j0)+(k)] : (B)[k][(j0)+(j)])
+
+/* pack_a -- op(A)[i0:i0+mc, k0:k0+kc] into MR-row strips, k-major */
+static	void	pack_a(int ta, Real **A, int Aj0, int i0, int k0,
+		       int mc, int kc, Real *out)
+{
+	int	i, ir, k, mr;
+
+	for ( ir = 0; ir < mc; ir += MR )
+	{
+	    mr = ( mc-ir < MR ) ? mc-ir : MR;
+	    for ( k = 0; k < kc; k++ )
+	    {
+		for ( i = 0; i < mr; i++ )
+		    *out++ = OPA(A,ta,Aj0,i0+ir+i,k0+k);
+		for ( ; i < MR; i++ )
+		    *out++ = 0.0;
+	    }
+	}
+}
+
+/* pack_b -- op(B)[k0:k0+kc, j0:j0+nc] into NR-column strips, k-major */
+static	void	pack_b(int tb, Real **B, int Bj0, int k0, int j0,
+		       int kc, int nc, Real *out)
+{
+	int	j, jr, k, nr;
+
+	for ( jr = 0; jr < nc; jr += NR )
+	{
+	    nr = ( nc-jr < NR ) ? nc-jr : NR;
+	    for ( k = 0; k < kc; k++ )
+	    {
+		if ( ! tb && nr == NR )
+		    MEM_COPY(&(B[k0+k][Bj0+j0+jr]),out,NR*sizeof(Real));
+		else
+		{
+		    for ( j = 0; j < nr; j++ )
+			out[j] = OPB(B,tb,Bj0,k0+k,j0+jr+j);
+		    for ( ; j < NR; j++ )
+			out[j] = 0.0;
+		}
+		out += NR;
+	    }
+	}
+}
+
+/* kern_c -- portable MR x NR microkernel:
+	C[i0:i0+mr, j0:j0+nr] += alpha.a.b over kc packed steps */
+static	void	kern_c(int kc, const Real *a, const Real *b, double alpha,
+		       Real **C, int i0, int j0, int mr, int nr)
+{
+	Real	acc[MR][NR];
+	int	i, j, k;
+
+	for ( i = 0; i < MR; i++ )
+	    for ( j = 0; j < NR; j++ )
+		acc[i][j] = 0.0;
+
+	for ( k = 0; k < kc; k++, a += MR, b += NR )
+	    for ( i = 0; i < MR; i++ )
+		for ( j = 0; j < NR; j++ )
+		    acc[i][j] += a[i]*b[j];
+
+	for ( i = 0; i < mr; i++ )
+	    for ( j = 0; j < nr; j++ )
+		C[i0+i][j0+j] += alpha*acc[i][j];
+}
+
+#ifdef MGEMM_X86
+/* kern_avx2 -- AVX2/FMA MR x NR microkernel, 8 accumulators */
+__attribute__((target("avx2,fma")))
+static	void	kern_avx2(int kc, const Real *a, const Real *b, double alpha,
+			  Real **C, int i0, int j0, int mr, int nr)
+{
+	__m256d	c00, c01, c10, c11, c20, c21, c30, c31, b0, b1, t, va;
+	Real	acc[MR][NR];
+	Real	*c;
+	int	i, j, k;
+
+	c00 = c01 = c10 = c11 = _mm256_setzero_pd();
+	c20 = c21 = c30 = c31 = _mm256_setzero_pd();
+
+	for ( k = 0; k < kc; k++, a += MR, b += NR )
+	{
+	    b0 = _mm256_loadu_pd(b);
+	    b1 = _mm256_loadu_pd(b+4);
+	    t = _mm256_broadcast_sd(a);
+	    c00 = _mm256_fmadd_pd(t,b0,c00);	c01 = _mm256_fmadd_pd(t,b1,c01);
+	    t = _mm256_broadcast_sd(a+1);
+	    c10 = _mm256_fmadd_pd(t,b0,c10);	c11 = _mm256_fmadd_pd(t,b1,c11);
+	    t = _mm256_broadcast_sd(a+2);
+	    c20 = _mm256_fmadd_pd(t,b0,c20);	c21 = _mm256_fmadd_pd(t,b1,c21);
+	    t = _mm256_broadcast_sd(a+3);
+	    c30 = _mm256_fmadd_pd(t,b0,c30);	c31 = _mm256_fmadd_pd(t,b1,c31);
+	}
+
+	va = _mm256_set1_pd(alpha);
+	if ( mr == MR && nr == NR )
+	{
+	    c = &(C[i0][j0]);
+	    _mm256_storeu_pd(c,_mm256_fmadd_pd(va,c00,_mm256_loadu_pd(c)));
+	    _mm256_storeu_pd(c+4,_mm256_fmadd_pd(va,c01,_mm256_loadu_pd(c+4)));
+	    c = &(C[i0+1][j0]);
+	    _mm256_storeu_pd(c,_mm256_fmadd_pd(va,c10,_mm256_loadu_pd(c)));
+	    _mm256_storeu_pd(c+4,_mm256_fmadd_pd(va,c11,_mm256_loadu_pd(c+4)));
+	    c = &(C[i0+2][j0]);
+	    _mm256_storeu_pd(c,_mm256_fmadd_pd(va,c20,_mm256_loadu_pd(c)));
+	    _mm256_storeu_pd(c+4,_mm256_fmadd_pd(va,c21,_mm256_loadu_pd(c+4)));
+	    c = &(C[i0+3][j0]);
+	    _mm256_storeu_pd(c,_mm256_fmadd_pd(va,c30,_mm256_loadu_pd(c)));
+	    _mm256_storeu_pd(c+4,_mm256_fmadd_pd(va,c31,_mm256_loadu_pd(c+4)));
+	    _mm256_zeroupper();
+	    return;
+	}
+
+	/* edge tile: spill and add the valid part */
+	_mm256_storeu_pd(acc[0],c00);	_mm256_storeu_pd(acc[0]+4,c01);
+	_mm256_storeu_pd(acc[1],c10);	_mm256_storeu_pd(acc[1]+4,c11);
+	_mm256_storeu_pd(acc[2],c20);	_mm256_storeu_pd(acc[2]+4,c21);
+	_mm256_storeu_pd(acc[3],c30);	_mm256_storeu_pd(acc[3]+4,c31);
+	_mm256_zeroupper();
+
+	for ( i = 0; i < mr; i++ )
+	    for ( j = 0; j < nr; j++ )
+		C[i0+i][j0+j] += alpha*acc[i][j];
+}
+#endif
+
+static	mgemm_kern	kern_pick()
+{
+#ifdef MGEMM_X86
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") )
+	    return kern_avx2;
+#endif
+	return kern_c;
+}
+
+/* the microkernel, picked once per process */
+static	mgemm_kern	kern = NULL;
+
+static	void	kern_init(void)
+{
+	kern = kern_pick();
+}
+
+#ifdef MGEMM_THREADS
+static	pthread_once_t	kern_once = PTHREAD_ONCE_INIT;
+#define	KERN_START()	pthread_once(&kern_once,kern_init)
+#else
+#define	KERN_START()	if ( ! kern ) kern_init()
+#endif
+
+/* m_gemm -- C <- C + alpha.op(A).op(B)
+	-- C is m x n, p is the inner dimension
+	-- op(A) = A^T if ta, op(B) = B^T if tb
+	-- A, B and C (from their initial columns) must not overlap */
+#ifndef ANSI_C
+void	m_gemm(ta,tb,m,n,p,alpha,A,Aj0,B,Bj0,C,Cj0)
+int	ta, tb, m, n, p;
+double	alpha;
+Real	**A, **B, **C;
+int	Aj0, Bj0, Cj0;
+#else
+void	m_gemm(int ta, int tb, int m, int n, int p, double alpha,
+	       Real **A, int Aj0, Real **B, int Bj0, Real **C, int Cj0)
+#endif
+{
+	Real	*Ap, *Bp, *Crow, tmp;
+	int	i, j, k, ic, jc, pc, ir, jr, mc, nc, kc;
+
+	if ( m <= 0 || n <= 0 || p <= 0 || alpha == 0.0 )
+	    return;
+
+	if ( (double)m*n*p < MGEMM_SMALL )
+	{
+	    /* row-at-a-time axpy form, as the old m_mlt */
+	    for ( i = 0; i < m; i++ )
+	    {
+		Crow = &(C[i][Cj0]);
+		for ( k = 0; k < p; k++ )
+		{
+		    tmp = alpha*OPA(A,ta,Aj0,i,k);
+		    if ( tb )
+			for ( j = 0; j < n; j++ )
+			    Crow[j] += tmp*B[j][Bj0+k];
+		    else
+			__mltadd__(Crow,&(B[k][Bj0]),tmp,n);
+		}
+	    }
+	    return;
+	}
+
+	KERN_START();
+
+	/* strips are padded to MR rows / NR columns */
+	Ap = pack_get(0,(size_t)(( m < MC ? m : MC )+MR)*KC);
+	Bp = pack_get(1,(size_t)(( n < NC ? n : NC )+NR)*KC);
+
+	for ( jc = 0; jc < n; jc += NC )
+	{
+	    nc = ( n-jc < NC ) ? n-jc : NC;
+	    for ( pc = 0; pc < p; pc += KC )
+	    {
+		kc = ( p-pc < KC ) ? p-pc : KC;
+		pack_b(tb,B,Bj0,pc,jc,kc,nc,Bp);
+
+		for ( ic = 0; ic < m; ic += MC )
+		{
+		    mc = ( m-ic < MC ) ? m-ic : MC;
+		    pack_a(ta,A,Aj0,ic,pc,mc,kc,Ap);
+
+		    for ( jr = 0; jr < nc; jr += NR )
+			for ( ir = 0; ir < mc; ir += MR )
+			    kern(kc,Ap+ir*kc,Bp+jr*kc,alpha,C,ic+ir,Cj0+jc+jr,
+				 ( mc-ir < MR ) ? mc-ir : MR,
+				 ( nc-jr < NR ) ? nc-jr : NR);
+		}
+	    }
+	}
+}
@@ -152,8 +152,8 @@ MAT	*sub_mat(const MAT *old,
      error(E_RANGE,"sub_mat");
    if ( new==(MAT *)NULL || new->m < row2-row1+1 )
    {
-      new = NEW(MAT);
-      new->me = NEW_A(row2-row1+1,Real *);
+      new = BLK_NEW(MAT);
+      new->me = BLK_NEW_A(row2-row1+1,Real *);
       if ( new==(MAT *)NULL || new->me==(Real **)NULL )
 	error(E_MEM,"sub_mat");
       else if (mem_info_is_on()) {
@@ -191,7 +191,7 @@ VEC	*sub_vec(const VEC *old, int i1, int i2, VEC *new)
      error(E_RANGE,"sub_vec");
    
    if ( new == (VEC *)NULL )
-     new = NEW(VEC);
+     new = BLK_NEW(VEC);
    if ( new == (VEC *)NULL )
      error(E_MEM,"sub_vec");
    else if (mem_info_is_on()) {
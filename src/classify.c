@@ -0,0 +1,96 @@
+#include "classify.h"
+
+static void classify_block(void *arg, size_t blk, int w) {
+    classify_ctx_t *ctx = (classify_ctx_t*)arg;
+    batch_t *batch = ctx->batch;
+    Real *p = ctx->scores[w];
+    size_t i, j, k, l, pm;
+
+    i = blk * CLASSIFY_BLOCK;
+    l = (batch->n - i < CLASSIFY_BLOCK) ? batch->n - i : CLASSIFY_BLOCK;
+
+    // two classes: one difference discriminant, last minimum wins ties
+    if (ctx->tab && batch->c == 2) {
+        disc_eval_rows(&ctx->tab->diff, ctx->data, i, l, p);
+
+        for (j = 0; j < l; j += 1) {
+            pm = (p[j] >= 0);
+            ctx->counts[w][pm] += 1;
+            if (ctx->labels) ctx->labels[i + j] = pm;
+        }
+        return;
+    }
+
+    // compute likelihood of block against each class
+    for (k = 0; k < batch->c; k += 1) {
+        if (ctx->tab) disc_eval_rows(&ctx->tab->k[k], ctx->data, i, l, p + k * CLASSIFY_BLOCK);
+        else disc_rows(batch->g, batch->dist[k], ctx->data, i, l, p + k * CLASSIFY_BLOCK);
+    }
+
+    for (j = 0; j < l; j += 1) {
+        // keep track of greatest likelihood
+        for (k = 0, pm = 0; k < batch->c; k += 1) {
+            if (p[k * CLASSIFY_BLOCK + j] <= p[pm * CLASSIFY_BLOCK + j]) pm = k;
+        }
+
+        ctx->counts[w][pm] += 1;
+        if (ctx->labels) ctx->labels[i + j] = pm;
+    }
+}
+
+/**
+ * @brief Classifies the first batch->n rows of data against
+ * every class in the batch. Rows are split into CLASSIFY_BLOCK
+ * sized blocks spread over batch->nthreads work-stealing workers.
+ * Each sample's decision depends only on its own row, so counts
+ * and labels are identical for any thread count.
+ *
+ * @param batch - Classification batch (classes, discriminant)
+ * @param data - Samples, one per row
+ * @param counts - Output samples assigned per class (batch->c)
+ * @param labels - Output class index per sample, or IVNULL
+ * @return int - 0 on success, 1 if a class covariance is not
+ * positive definite (outputs untouched)
+ */
+int classify_run(batch_t *batch, MAT *data, size_t *counts, IVEC *labels) {
+    classify_ctx_t ctx;
+    disc_tab_t tab = { 0 };
+    size_t k, nblk;
+    int w, nw;
+
+    // compile class models and discriminants up front; workers only read them
+    for (k = 0; k < batch->c; k += 1) {
+        if (!gauss_compile(batch->dist[k])) return 1;
+    }
+    ctx.tab = disc_tab_compile(batch, &tab) ? NULL : &tab;
+
+    nblk = (batch->n + CLASSIFY_BLOCK - 1) / CLASSIFY_BLOCK;
+    nw = pool_threads(batch->nthreads);
+
+    ctx.batch = batch;
+    ctx.data = data;
+    ctx.labels = labels ? iv_resize(labels, batch->n)->ive : NULL;
+    ctx.scores = (Real**) malloc(sizeof(Real*) * nw);
+    ctx.counts = (size_t**) malloc(sizeof(size_t*) * nw);
+
+    for (w = 0; w < nw; w += 1) {
+        ctx.scores[w] = (Real*) malloc(sizeof(Real) * batch->c * CLASSIFY_BLOCK);
+        ctx.counts[w] = (size_t*) calloc(batch->c, sizeof(size_t));
+    }
+
+    pool_run(nblk, nw, classify_block, &ctx);
+
+    // integer sums: same totals whatever the block schedule
+    for (k = 0; k < batch->c; k += 1) {
+        for (w = 0, counts[k] = 0; w < nw; w += 1) counts[k] += ctx.counts[w][k];
+    }
+
+    for (w = 0; w < nw; w += 1) {
+        free(ctx.scores[w]);
+        free(ctx.counts[w]);
+    }
+    free(ctx.scores); free(ctx.counts);
+    disc_tab_free(&tab);
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include "dataset.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int host_le(void) {
+    const uint16_t one = 1;
+    return *(const uint8_t*)&one;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    int i;
+    for (i = 0; i < 4; i += 1) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    int i;
+    for (i = 0; i < 8; i += 1) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    int i;
+    for (i = 3; i >= 0; i -= 1) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    int i;
+    for (i = 7; i >= 0; i -= 1) v = (v << 8) | p[i];
+    return v;
+}
+
+/**
+ * @brief Copies n bytes of one sample, reversing them on
+ * big-endian hosts (file samples are little-endian).
+ */
+static void sample_copy(void *dst, const void *src, size_t n) {
+    const uint8_t *s = (const uint8_t*)src;
+    uint8_t *d = (uint8_t*)dst;
+    size_t i;
+
+    if (host_le()) {
+        memcpy(dst, src, n);
+    } else {
+        for (i = 0; i < n; i += 1) d[i] = s[n - 1 - i];
+    }
+}
+
+static size_t dtype_size(uint32_t dtype) {
+    return (dtype == DSET_F64) ? sizeof(double) : (dtype == DSET_F32) ? sizeof(float) : 0;
+}
+
+/**
+ * @brief Whether the header's columns fit in size bytes, checked
+ * by division so crafted counts cannot overflow the arithmetic:
+ * column 0 at offset, the rest stride apart, each rows * es long.
+ * The shape must also fit a Meschach MAT (int dimensions).
+ */
+static int dset_fits(const dset_t *d, size_t es, uint64_t size) {
+    uint64_t avail, col;
+
+    if (d->offset > size) return 0;
+    if (d->cols > INT_MAX || d->rows > INT_MAX) return 0;
+    if (d->cols && d->rows > INT_MAX / d->cols) return 0;
+    if (!d->cols) return 1;
+
+    avail = size - d->offset;
+    if (d->rows > avail / es) return 0;
+    col = d->rows * es;
+    if (d->stride < col) return 0;
+
+    // columns 1..cols-1 start stride apart after column 0
+    return d->stride == 0 || d->cols - 1 <= (avail - col) / d->stride;
+}
+
+/**
+ * @brief Binary dataset path for a (text) dataset name: the
+ * extension is replaced by ".bin" ("data/x.mat" -> "data/x.bin").
+ *
+ * @param fname - Dataset path
+ * @param out - Output buffer
+ * @param len - Size of out
+ * @return char* - out
+ */
+char *dset_path(const char *fname, char *out, size_t len) {
+    const char *dot = strrchr(fname, '.'), *sep = strrchr(fname, '/');
+    int n;
+
+    n = (dot && (!sep || dot > sep)) ? (int)(dot - fname) : (int)strlen(fname);
+    snprintf(out, len, "%.*s.bin", n, fname);
+
+    return out;
+}
+
+/**
+ * @brief Writes a matrix as a binary dataset: a fixed header
+ * then one DSET_ALIGN-aligned column of doubles per matrix
+ * column, all little-endian. The file is written as <path>.tmp
+ * and renamed into place, so an interrupted write never leaves a
+ * truncated dataset under path.
+ *
+ * @param path - Destination file
+ * @param m - Samples (one per row)
+ * @param label - Class label stored in the header
+ * @return int - 0 on success, 1 on error
+ */
+int dset_write(const char *path, const MAT *m, int label) {
+    uint8_t hdr[DSET_ALIGN] = { 0 };
+    char tmp[MAX_FPATH];
+    uint64_t stride;
+    double *col;
+    size_t i, j, pad;
+    FILE *fp;
+    int ret = 0;
+
+    if (snprintf(tmp, MAX_FPATH, "%s.tmp", path) >= MAX_FPATH || !(fp = fopen(tmp, "wb"))) {
+        fprintf(stderr, "Error opening destination file '%s'.\n", path);
+        return 1;
+    }
+
+    stride = ((uint64_t)m->m * sizeof(double) + DSET_ALIGN - 1) / DSET_ALIGN * DSET_ALIGN;
+
+    memcpy(hdr, DSET_MAGIC, sizeof(DSET_MAGIC));
+    put_u32(hdr + 8, DSET_VERSION);
+    put_u32(hdr + 12, DSET_F64);
+    put_u64(hdr + 16, m->m);
+    put_u32(hdr + 24, m->n);
+    put_u32(hdr + 28, (uint32_t)label);
+    put_u64(hdr + 32, DSET_ALIGN);
+    put_u64(hdr + 40, stride);
+
+    col = (double*) calloc(stride / sizeof(double), sizeof(double));
+    pad = stride - m->m * sizeof(double);
+
+    if (!col && stride) ret = 1;
+    if (!ret && fwrite(hdr, 1, DSET_ALIGN, fp) != DSET_ALIGN) ret = 1;
+
+    for (j = 0; j < m->n && !ret; j += 1) {
+        for (i = 0; i < m->m; i += 1) sample_copy(col + i, &m->me[i][j], sizeof(double));
+        // padding stays zero from calloc
+        if (fwrite(col, 1, m->m * sizeof(double) + pad, fp) != m->m * sizeof(double) + pad) ret = 1;
+    }
+
+    if (fclose(fp)) ret = 1;
+    if (!ret && rename(tmp, path)) ret = 1;
+    if (ret) {
+        fprintf(stderr, "Error writing dataset '%s'.\n", path);
+        remove(tmp);
+    }
+    free(col);
+
+    return ret;
+}
+
+/**
+ * @brief Maps a binary dataset read-only and checks its header.
+ * Columns are read straight from the mapping (dset_col /
+ * dset_mat) until dset_close.
+ *
+ * @param path - Dataset file
+ * @param d - Receives the header and mapping
+ * @return int - 0 on success, -1 if the file does not exist,
+ * 1 if it is unreadable or malformed
+ */
+int dset_open(const char *path, dset_t *d) {
+    const uint8_t *p;
+    struct stat st;
+    size_t es;
+    int fd;
+
+    memset(d, 0, sizeof(dset_t));
+
+    if ((fd = open(path, O_RDONLY)) < 0) return -1;
+
+    if (fstat(fd, &st) || st.st_size < DSET_HDR_LEN) {
+        fprintf(stderr, "Error reading size of '%s'.\n", path);
+        close(fd);
+        return 1;
+    }
+
+    d->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (d->map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping '%s'.\n", path);
+        d->map = NULL;
+        return 1;
+    }
+    d->map_size = st.st_size;
+
+    p = (const uint8_t*)d->map;
+    d->version = get_u32(p + 8);
+    d->dtype = get_u32(p + 12);
+    d->rows = get_u64(p + 16);
+    d->cols = get_u32(p + 24);
+    d->label = (int32_t)get_u32(p + 28);
+    d->offset = get_u64(p + 32);
+    d->stride = get_u64(p + 40);
+
+    es = dtype_size(d->dtype);
+
+    if (memcmp(p, DSET_MAGIC, sizeof(DSET_MAGIC)) || d->version != DSET_VERSION || !es
+        || d->offset < DSET_HDR_LEN || d->offset % DSET_ALIGN || d->stride % DSET_ALIGN
+        || !dset_fits(d, es, d->map_size)) {
+        fprintf(stderr, "Error. '%s' is not a valid dataset file.\n", path);
+        dset_close(d);
+        return 1;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    madvise(d->map, d->map_size, MADV_SEQUENTIAL);
+#endif
+
+    return 0;
+}
+
+/**
+ * @brief Start of column j inside the mapping (d->rows raw
+ * little-endian samples of type d->dtype).
+ */
+const void *dset_col(const dset_t *d, uint32_t j) {
+    return (const uint8_t*)d->map + d->offset + j * d->stride;
+}
+
+/**
+ * @brief Copies a mapped dataset into a (row-major) MAT. No
+ * parsing: on little-endian hosts double columns are read
+ * directly.
+ *
+ * @param d - Open dataset
+ * @param out - Matrix to fill (resized), or MNULL
+ * @return MAT* - Samples, one per row
+ */
+MAT *dset_mat(const dset_t *d, MAT *out) {
+    const uint8_t *c;
+    const double *x;
+    size_t i, j;
+    float f;
+
+    out = m_resize(out, d->rows, d->cols);
+
+    for (j = 0; j < d->cols; j += 1) {
+        c = (const uint8_t*)dset_col(d, j);
+
+        if (d->dtype == DSET_F64 && host_le()) {
+            x = (const double*)c;
+            for (i = 0; i < d->rows; i += 1) out->me[i][j] = x[i];
+        } else if (d->dtype == DSET_F64) {
+            for (i = 0; i < d->rows; i += 1) sample_copy(&out->me[i][j], c + i * sizeof(double), sizeof(double));
+        } else {
+            for (i = 0; i < d->rows; i += 1) {
+                sample_copy(&f, c + i * sizeof(float), sizeof(float));
+                out->me[i][j] = f;
+            }
+        }
+    }
+
+    return out;
+}
+
+void dset_close(dset_t *d) {
+    if (d->map) munmap(d->map, d->map_size);
+    d->map = NULL;
+    d->map_size = 0;
+}
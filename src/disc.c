@@ -12,7 +12,11 @@
  */
 double euclid_disc(VEC *x, gauss_t *g) {
     VEC *diff = v_sub(x, g->mu, VNULL);
-    return -1 * in_prod(diff, diff);
+    double n = -1 * in_prod(diff, diff);
+
+    v_free(diff);
+
+    return n;
 }
 
 /**
@@ -39,6 +43,38 @@ double case1_disc(VEC *x, gauss_t *g) {
 
     n = in_prod(w, x) + w0;
 
+    v_free(w);
+
+    return n;
+}
+
+/**
+ * @brief Optimum classifier for m.v. Gaussian classes
+ * sharing one arbitrary covariance matrix (each class' sigma
+ * is taken to be the shared one). Linear decision boundary.
+ * 
+ * @param x - Feature vector
+ * @param g - Class/Category distribution
+ * @return double - (-1) * dist_from_boundary
+ */
+double case2_disc(VEC *x, gauss_t *g) {
+
+    // g(x) = wT.x + w0
+
+    double n, w0;
+    MAT *inv;
+    VEC *w;
+
+    inv = fx_inverse(g->sigma, MNULL);
+    w = mv_mlt(inv, g->mu, VNULL);
+
+    w0 = -0.5 * in_prod(g->mu, w) + log(g->prior);
+
+    n = in_prod(w, x) + w0;
+
+    m_free(inv);
+    v_free(w);
+
     return n;
 }
 
@@ -59,7 +95,7 @@ double case3_disc(VEC *x, gauss_t *g) {
     MAT *W, *inv;
     VEC *w, *a;
 
-    inv = m_inverse(g->sigma, MNULL);
+    inv = fx_inverse(g->sigma, MNULL);
     W = sm_mlt(-0.5, inv, MNULL);
 
     w = mv_mlt(inv, g->mu, VNULL);
@@ -76,4 +112,134 @@ double case3_disc(VEC *x, gauss_t *g) {
     v_free(w); v_free(a);
 
     return n;
+}
+
+/**
+ * @brief Compiles one class for a discriminant into its
+ * (W, w, w0) form, so that g(x) = x'.W.x + w'.x + w0 needs no
+ * per-sample inverse, determinant or allocation.
+ * 
+ *   euclid: W = -I,           w = 2 mu,      w0 = -mu'.mu
+ *   case 1: W = 0,            w = mu / s^2,  w0 = -mu'.mu / 2s^2 + ln P
+ *   case 2: W = 0,            w = S^-1 mu,   w0 = -mu'.w / 2 + ln P
+ *   case 3: W = -S^-1 / 2,    w = S^-1 mu,   w0 = -mu'.w / 2 - ln|S| / 2 + ln P
+ * 
+ * @param g - Discriminant (one of the above)
+ * @param c - Class/Category distribution
+ * @param out - Compiled form (storage reused)
+ * @return int - 0 on success, 1 if g has no compiled form or
+ * needs the inverse of a sigma that is not positive definite
+ */
+int disc_compile(Disc g, gauss_t *c, disc_t *out) {
+    gauss_model_t *m = NULL;
+    double ss;
+    int d = c->mu->dim;
+
+    if (g != euclid_disc && g != case1_disc && g != case2_disc && g != case3_disc) return 1;
+
+    out->d = d;
+    out->quad = (g == euclid_disc || g == case3_disc);
+    out->W = m_resize(out->W, d, d);
+    out->w = v_resize(out->w, d);
+    m_zero(out->W);
+
+    if ((g == case2_disc || g == case3_disc) && !(m = gauss_compile(c))) return 1;
+
+    if (g == euclid_disc) {
+        m_ident(out->W);
+        sm_mlt(-1, out->W, out->W);
+        sv_mlt(2, c->mu, out->w);
+        out->w0 = -in_prod(c->mu, c->mu);
+    } else if (g == case1_disc) {
+        ss = c->sigma->me[0][0] * c->sigma->me[0][0];
+        sv_mlt(1 / ss, c->mu, out->w);
+        out->w0 = (-1 / (2 * ss)) * in_prod(c->mu, c->mu) + log(c->prior);
+    } else {
+        mv_mlt(m->prec, c->mu, out->w);
+        out->w0 = -0.5 * in_prod(c->mu, out->w) + log(c->prior);
+
+        if (g == case3_disc) {
+            sm_mlt(-0.5, m->prec, out->W);
+            out->w0 += -0.5 * m->logdet;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Difference discriminant a - b. For two classes the
+ * decision is its sign, so one quadratic form per sample
+ * replaces two (W cancels entirely for shared-W cases).
+ */
+void disc_sub(const disc_t *a, const disc_t *b, disc_t *out) {
+    out->d = a->d;
+    out->W = m_sub(a->W, b->W, out->W);
+    out->w = v_sub(a->w, b->w, out->w);
+    out->w0 = a->w0 - b->w0;
+    out->quad = (a->quad || b->quad) && m_norm_inf(out->W) != 0;
+}
+
+/**
+ * @brief Evaluates a compiled discriminant at x (k->d
+ * contiguous values).
+ */
+double disc_eval(const disc_t *k, const Real *x) {
+    Real **W = k->W->me, *w = k->w->ve;
+    double q, s;
+    int i, j;
+
+    for (i = 0, q = k->w0; i < k->d; i += 1) {
+        s = w[i];
+        if (k->quad) {
+            // symmetric: diagonal term plus twice the lower triangle
+            for (j = 0, s += W[i][i] * x[i]; j < i; j += 1) s += 2 * W[i][j] * x[j];
+        }
+        q += s * x[i];
+    }
+
+    return q;
+}
+
+void disc_free(disc_t *k) {
+    m_free(k->W); v_free(k->w);
+    k->W = MNULL;
+    k->w = VNULL;
+}
+
+/**
+ * @brief Compiles every class of a batch for b->g, plus the
+ * k[0] - k[1] difference when the batch has two classes.
+ * 
+ * @param b - Classification batch
+ * @param t - Table (zeroed before first use; storage reused)
+ * @return int - 0 on success, 1 if b->g has no compiled form
+ */
+int disc_tab_compile(batch_t *b, disc_tab_t *t) {
+    size_t k;
+
+    if (t->c != b->c) {
+        disc_tab_free(t);
+        t->k = (disc_t*) calloc(b->c, sizeof(disc_t));
+        t->c = b->c;
+    }
+    t->g = b->g;
+
+    for (k = 0; k < b->c; k += 1) {
+        if (disc_compile(b->g, b->dist[k], &t->k[k])) return 1;
+    }
+
+    if (b->c == 2) disc_sub(&t->k[0], &t->k[1], &t->diff);
+
+    return 0;
+}
+
+void disc_tab_free(disc_tab_t *t) {
+    size_t k;
+
+    for (k = 0; k < t->c && t->k; k += 1) disc_free(&t->k[k]);
+    free(t->k);
+    disc_free(&t->diff);
+    t->k = NULL;
+    t->c = 0;
 }
\ No newline at end of file
@@ -0,0 +1,475 @@
+#include "exp.h"
+
+void plot_roc(MAT *data, char *fname, char *title) {
+    trace_t t = trace_begin("plot_roc");
+    plot_job_t *plot;
+    size_t i, len;
+    char spec[64];
+
+    plot = plot_job();
+
+    plot_cmd(plot, "set terminal pngcairo size 800,600 enhanced font 'Consolas,12'");
+    plot_cmd(plot, "set output '%s%s.png'", PLOT_DIR, fname);
+
+    plot_cmd(plot, "set xlabel \"FP\"");
+    plot_cmd(plot, "set ylabel \"FN\"");
+    plot_cmd(plot, "set title \"%s\"", title);
+
+    plot_cmd(plot, "set style line 1 lc rgb \"red\" linetype 1 linewidth 2 pointtype 7 pointsize 1.5 notitle");
+    plot_cmd(plot, "set style textbox opaque");
+
+    // threshold labels as commands: the table is only sent once
+    for (i = 0; i < data->m; i += 1) {
+        plot_cmd(plot, "set label %zu \"%lf\" at %.17g,%.17g center boxed front", i + 1, data->me[i][2], data->me[i][0], data->me[i][1]);
+    }
+
+    plot_cmd(plot, "plot '-' %s using 1:2 with linespoints linestyle 1 notitle", plot_binspec(spec, sizeof(spec), data->m, data->n));
+    plot_rows(plot, data);
+
+    len = plot->len;
+    plot_submit(plot);
+
+    trace_end(&t, fname, data->m, len);
+}
+
+void face_validate(Image *img, Image *ref, double *fpr, double *fnr) {
+    trace_t t = trace_begin("face_validate");
+    size_t i, s, m, r;
+    double fp, fn, tp, tn;
+
+    fp = 0; fn = 0; tp = 0; tn = 0;
+    for (i = 0, *fpr = 0, *fnr = 0; i < img->size; i += 3) {
+        for (s = 0, m = 0, r = 0; s < 3; s += 1) {
+            m += img->data[i + s];
+            r += ref->data[i + s];
+        }
+
+        if (m && !r) {          // false positive
+            fp += 1;
+        } else if (!m && r) {   // false negative
+            fn += 1;
+        } else if (!m && !r) {  // true negative
+            tn += 1;
+        } else if (m && r) {    // true positive
+            tp += 1;
+        }
+    }
+
+    *fpr = fp / (fp + tn);
+    *fnr = fn / (fn + tp);
+
+    trace_end(&t, NULL, img->size / 3, 2 * img->size);
+}
+
+void face_test(gauss_t *color, Image *out, Image *img, const feats_t *data, double thresh) {
+    trace_t t = trace_begin("face_test");
+    size_t i, k, l, s;
+    Real *d;
+
+    if (!gauss_compile(color)) {
+        fprintf(stderr, "Error. Color covariance is not positive definite.\n");
+        trace_end(&t, NULL, 0, 0);
+        return;
+    }
+
+    d = (Real*) malloc(sizeof(Real) * SCORE_BLOCK);
+    // iterate blocks of RG vectors
+    for (k = 0; k < data->n; k += l) {
+        l = (data->n - k < SCORE_BLOCK) ? data->n - k : SCORE_BLOCK;
+        // test block of RG vectors against model (in data's precision)
+        feats_logeval(color->model, data, k, l, d);
+        for (i = 0; i < l; i += 1) {
+            // if likelihood above threshold
+            if (exp(d[i]) >= thresh) {
+                // copy over RGB values to output image
+                for (s = 0; s < 3; s += 1) {
+                    out->data[(k + i) * 3 + s] = img->data[(k + i) * 3 + s];
+                }
+            }
+        }
+    }
+
+    free(d);
+
+    trace_end(&t, NULL, data->n, 3 * data->n);
+}
+
+void face_detect(gauss_t *color, char *ifname, char *rfname, size_t n, double step, int rg, const lut_t *lut, prec_t prec) {
+    trace_t t = trace_begin("face_detect");
+    MAT *roc;
+    FILE *fp;
+    roc_t *r;
+    stream_t st;
+    size_t e, px;
+    char fnbuf[MAX_FPATH], tbuf[MAX_FPATH];
+
+    printf("Testing '%s' %s vectors over %llu thresholds with threshold-step of %lf...\n", ifname, rg ? "RG" : "YCbCr", n, step);
+    // stream the image once, binning every pixel against all thresholds
+    r = roc_new(n, step, step);
+    st = (stream_t) {
+        .ifname = ifname,
+        .rfname = rfname,
+        .rg = rg,
+        .thresh = HUGE_VAL,
+        .roc = r,
+        .lut = lut,
+        .prec = prec
+    };
+    if (face_stream(color, &st)) {
+        roc_free(r);
+        trace_end(&t, ifname, 0, 0);
+        return;
+    }
+    px = st.tp + st.fp + st.tn + st.fn;
+
+    // compute ROC stats for every threshold in one sweep
+    e = roc_finish(r);
+
+    // build ROC curve dataset -> [ fn, fp, threshold ]
+    roc = roc_mat(r, MNULL);
+
+    // second pass writes the equal-error detection image
+    sprintf(fnbuf, "err_thresh_%s_%s", rg ? "RG" : "YCbCr", ifname);
+    st = (stream_t) {
+        .ifname = ifname,
+        .ofname = fnbuf,
+        .rg = rg,
+        .thresh = m_get_val(roc, e, 2),
+        .lut = lut,
+        .prec = prec
+    };
+    face_stream(color, &st);
+    
+    sprintf(fnbuf, "roc_data_%s_%s.mat", rg ? "RG" : "YCbCr",  ifname);
+    fp = fopen(fnbuf, "w+");
+    m_foutput(fp, roc);
+
+    printf("Plotting ROC curve for '%s' test batch (n = %llu, step = %lf)...\n", ifname, n, step);
+    // plot ROC curve
+    sprintf(fnbuf, "roc_%s_%s", ifname, rg ? "RG" : "YCbCr");
+    sprintf(tbuf, "ROC for %s (n = %llu, step = %.02lf) %s", ifname, n, step, rg ? "RG" : "YCbCr");
+    plot_roc(roc, fnbuf, tbuf);
+
+    m_free(roc);
+    roc_free(r);
+    fclose(fp);
+
+    trace_end(&t, ifname, px, 0);
+}
+
+void face_train(gauss_t *color, char *ifname, char *rfname, int rg) {
+    trace_t tr = trace_begin("face_train");
+    size_t i, s;
+    double d, t;
+    char fnbuf[32];
+    Image *img, *ref, *out;
+    
+    // load input and refrence-mask
+    img = load_image(ifname);
+    ref = load_image(rfname);
+
+    // mask input for MLE
+    out = image_and(img, ref, NULL);
+
+    // write masked image
+    sprintf(fnbuf, "%s_masked.ppm", ifname);
+    write_image(fnbuf, out);
+
+    printf("Getting '%s' %s vectors for training...\n", rfname, rg ? "RG" : "YCrCb");
+    // get masked RG dataset
+    if (rg)
+        color->dataset = image_rgmat(out, color->dataset);
+    else 
+        color->dataset = image_ycbcrmat(out, color->dataset);
+
+    // trim zero data
+    trim_zeros(color->dataset);
+
+    printf("Estimating color distribution for %llu samples...\n", color->dataset->m);
+    // estimate distribution over masked dataset
+    if (compute_mle(color, color->dataset->m)) {
+        printf("Color covariance is not positive definite.\n");
+    }
+
+    trace_end(&tr, ifname, color->dataset->m, img->size + ref->size);
+
+    del_image(img); del_image(ref); del_image(out);
+}
+
+void face_exp(int rg) {
+    gauss_t color = {
+        .id = 420,
+        .mu = v_get(2),
+        .sigma = m_get(2, 2),
+        .dataset = MNULL
+    };
+    trace_t t = trace_begin("face_exp");
+    lut_t *lut = NULL;
+    double c;
+
+    face_train(&color, "train1.ppm", "ref1.ppm", rg);
+
+    c = 1 / (2 * M_PI * sqrt(m_det(color.sigma)));
+
+    // one table serves both test images and every threshold
+    if (FACE_LUT_BITS) lut = lut_compile(&color, rg, FACE_LUT_BITS, c / 20);
+
+    face_detect(&color, "train3.ppm", "ref3.ppm", 20, c / 20, rg, lut, FACE_PREC);
+    face_detect(&color, "train6.ppm", "ref6.ppm", 20, c / 20, rg, lut, FACE_PREC);
+
+    lut_free(lut);
+
+    v_free(color.mu); m_free(color.sigma);
+    m_free(color.dataset);
+    gauss_model_free(color.model);
+
+    trace_end(&t, rg ? "RG" : "YCbCr", 0, 0);
+}
+
+void mle_exp(MAT **datasets, batch_t *batch, int it) {
+    size_t t, c, s, l;
+    int i, k, j;
+    double pct;
+    char fnbuf[32], tbuf[48];
+    size_t lens[5];
+    moments_t *mom[batch->c][5];
+    trace_t tr = trace_begin("mle_exp");
+
+    printf("Plotting datasets...\n");
+    for (i = 0; i < batch->c; i += 1) {
+        printf("\tDataset %c -> ", 'A' + i);
+        sprintf(fnbuf, "plot_%d%c", it, 'A' + i);
+        sprintf(tbuf, "DATASET %c - CLASS %d", 'A' + i, batch->dist[i]->id);
+        plot_data(&datasets[i], 1, fnbuf, tbuf);
+        printf("Done\n");
+    }
+
+    printf("\tAll Datasets -> ");
+    sprintf(fnbuf, "plot_%dALL", it);
+    sprintf(tbuf, "DATASETS A thru %c - ALL CLASSES", 'A' + batch->c - 1);
+    plot_data(datasets, batch->c, fnbuf, tbuf);
+    printf("Done\n");
+
+    // all nested fractions of each dataset from one pass per class
+    for (i = 0; i < batch->c; i += 1) {
+        for (k = 0, pct = 1; k < 5; k += 1, pct *= 0.1) {
+            lens[k] = pct * batch->dist[i]->dataset->m;
+            mom[i][k] = NULL;
+        }
+        mom_prefix(batch->dist[i]->dataset, lens, 5, 0, mom[i]);
+    }
+
+    // ML estimation for exp 1 w/ differing amounts of data
+    for (k = 0, pct = 1; k <= 5; k += 1) {
+        if (k) {
+            printf("\n============ <MLE ESTIMATES %.02lf%% data> ============\n\n", pct * 100);
+
+            // compute ML estimations over each class and associated dataset
+            for (i = 0; i < batch->c; i += 1) {
+                l = mom[i][k - 1]->n;
+                printf("Dataset %d: %llu samples\n", batch->dist[i]->id, l);
+
+                if (apply_mle(batch->dist[i], mom[i][k - 1])) {
+                    printf("Covariance of class %d is not positive definite.\n", batch->dist[i]->id);
+                }
+
+                printf("\n~~~ MEAN (c = %d) ~~~\n", batch->dist[i]->id);
+                v_output(batch->dist[i]->mu);
+                printf("~~~ COVARIANCE (c = %d) ~~~\n", batch->dist[i]->id);
+                m_output(batch->dist[i]->sigma);
+                printf("\n");
+            }
+
+            pct *= 0.1;
+        }
+
+        // classify each class' dataset with estimated dist-parameters
+        for (i = 0, t = 0, s = 0; i < batch->c; i += 1) {
+            sprintf(batch->bname, "batch_%d%c-%d", it, 'A' + i, k);
+            batch->n = datasets[i]->m;
+            c = classify(batch, datasets[i], batch->dist[i]->id);
+            t += c;
+            s += datasets[i]->m;
+            plot_batch(batch);
+        }
+
+        printf("\nCorrectly classified %llu of %llu (%lf%%) in total\n", t, s, 100 * (double)t / s);
+    }
+
+    for (i = 0; i < batch->c; i += 1) {
+        for (k = 0; k < 5; k += 1) mom_free(mom[i][k]);
+    }
+
+    sprintf(tbuf, "exp %d", it);
+    trace_end(&tr, tbuf, 0, 0);
+}
+
+size_t classify(batch_t *batch, MAT *data, int class) {
+    trace_t t = trace_begin("classify");
+    size_t *counts = calloc(sizeof(size_t), batch->c);
+    size_t *quota = calloc(sizeof(size_t), batch->c);
+    size_t *seen = calloc(sizeof(size_t), batch->c);
+    size_t *row = calloc(sizeof(size_t), batch->c);
+    size_t i, j, k, ct, len;
+    IVEC *labels;
+
+    // classify all samples across worker threads
+    labels = iv_get(batch->n);
+    if (classify_run(batch, data, counts, labels)) {
+        printf("%s: a class covariance is not positive definite\n", batch->bname);
+        iv_free(labels);
+        free(counts); free(quota); free(seen); free(row);
+        trace_end(&t, batch->bname, 0, 0);
+        return 0;
+    }
+
+    // correct-count: samples whose max. likelihood == correct-class id
+    for (k = 0, ct = 0; k < batch->c; k += 1) {
+        if (batch->dist[k]->id == class) ct += counts[k];
+    }
+
+    // stratified per assigned class: the plot stays within budget
+    for (k = 0, len = 0; k < batch->c; k += 1) {
+        quota[k] = plot_quota(counts[k], batch->n, batch->budget ? batch->budget : PLOT_BUDGET);
+        row[k] = len;
+        len += quota[k];
+    }
+
+    // kept samples grouped by assigned class, for plot_batch
+    batch->plot = m_resize(batch->plot, len, data->n + 1);
+
+    for (i = 0; i < batch->n; i += 1) {
+        k = labels->ive[i];
+        if (!plot_keep(seen[k]++, quota[k], counts[k])) continue;
+
+        // record sample classification
+        for (j = 0; j < data->n; j += 1) batch->plot->me[row[k]][j] = data->me[i][j];
+        batch->plot->me[row[k]++][data->n] = batch->dist[k]->id;
+    }
+
+    len *= sizeof(Real) * (data->n + 1);
+    iv_free(labels);
+    free(counts); free(quota); free(seen); free(row);
+
+    printf("%s correctly classified %llu of %llu (%lf%%)\n", batch->bname, ct, batch->n, 100 * (double)ct / batch->n);
+
+    trace_end(&t, batch->bname, batch->n, len);
+
+    return ct;
+}
+
+void plot_data(MAT **data, int n, char *fname, char *title) {
+    trace_t t = trace_begin("plot_data");
+    plot_job_t *plot;
+    MAT *grid = MNULL, *pts = MNULL;
+    size_t l, total, len, q[n];
+    double lim[4];
+    char spec[160];
+    int dense;
+
+    plot = plot_job();
+
+    plot_cmd(plot, "set terminal pngcairo size 800,600 enhanced font 'Consolas,12'");
+    plot_cmd(plot, "set output '%s%s.png'", PLOT_DIR, fname);
+
+    plot_cmd(plot, "set xlabel \"X\"");
+    plot_cmd(plot, "set ylabel \"Y\"");
+    plot_cmd(plot, "set title \"%s\"", title);
+
+    qsort(data, n, sizeof(MAT *), dataset_len_cmp);
+
+    for (l = 0, total = 0; l < n; l += 1) total += data[l]->m;
+    for (l = 0; l < n; l += 1) q[l] = plot_quota(data[l]->m, total, PLOT_BUDGET);
+
+    // over budget: full density as a heatmap under decimated points
+    if ((dense = total > PLOT_BUDGET)) {
+        plot_bounds(data, n, lim);
+        for (l = 0; l < n; l += 1) grid = plot_density(data[l], lim, grid);
+
+        plot_cmd(plot, "set palette defined (0 '#f7fbff', 1 '#6baed6', 2 '#08306b')");
+        plot_cmd(plot, "set logscale cb");
+        plot_cmd(plot, "set cblabel \"samples / cell\"");
+        plot_cmd(plot, "plot '-' %s with image notitle,\\", plot_imgspec(spec, sizeof(spec), grid, lim));
+    }
+    
+    for (l = 0; l < n; l += 1) {
+        plot_cmd(plot, "%s'-' %s using 1:%d title \"%d\" with points pointtype %d pointsize 1%s", \
+                        (l == 0 && !dense) ? "plot " : " ",
+                        plot_binspec(spec, sizeof(spec), q[l], data[l]->n),
+                        data[l]->n,
+                        l + 1,
+                        l + 4,
+                        (n > 1 && l < n - 1) ? ",\\" : "");
+    }
+
+    // binary blocks follow the plot command in element order
+    if (dense) plot_rows(plot, grid);
+    for (l = 0; l < n; l += 1) {
+        pts = plot_decimate(data[l], q[l], pts);
+        plot_rows(plot, pts);
+    }
+
+    len = plot->len;
+    plot_submit(plot);
+
+    m_free(grid); m_free(pts);
+
+    trace_end(&t, fname, total, len);
+}
+
+/**
+ * @brief Scatter plot of the samples classify() kept in b->plot,
+ * one element per assigned class. The rows go inline with the
+ * job (no file for gnuplot to read later), so b->plot may be
+ * refilled as soon as this returns.
+ */
+void plot_batch(batch_t *b) {
+    trace_t t = trace_begin("plot_batch");
+    plot_job_t *plot;
+    MAT *p = b->plot, run;
+    size_t lo[b->c + 1], len, i, k, nk;
+    char spec[160];
+    int id;
+
+    if (!p || !p->m) {
+        trace_end(&t, b->bname, 0, 0);
+        return;
+    }
+
+    plot = plot_job();
+    plot_cmd(plot, "set terminal pngcairo size 800,600 enhanced font 'Consolas,12'");
+    plot_cmd(plot, "set output '%s%s.png'", PLOT_DIR, b->bname);
+
+    plot_cmd(plot, "set xlabel \"X\"");
+    plot_cmd(plot, "set ylabel \"Y\"");
+    plot_cmd(plot, "set title \"%s\"", b->bname);
+
+    // row ranges of the classes present (rows are grouped by class)
+    for (i = 0, nk = 0; i < p->m; i += 1) {
+        if (!i || p->me[i][p->n - 1] != p->me[i - 1][p->n - 1]) lo[nk++] = i;
+    }
+    lo[nk] = p->m;
+
+    for (k = 0; k < nk; k += 1) {
+        id = (int)p->me[lo[k]][p->n - 1];
+        plot_cmd(plot, "%s'-' %s using 1:%d title \"Class %d\" with points pointtype %d pointsize 2%s", \
+                        k == 0 ? "plot " : " ",
+                        plot_binspec(spec, sizeof(spec), lo[k + 1] - lo[k], p->n),
+                        b->d,
+                        id,
+                        id + 1,
+                        (k < nk - 1) ? ",\\" : "");
+    }
+
+    // binary blocks follow the plot command in element order
+    for (k = 0, run = *p; k < nk; k += 1) {
+        run.m = lo[k + 1] - lo[k];
+        run.me = p->me + lo[k];
+        plot_rows(plot, &run);
+    }
+
+    len = plot->len;
+    plot_submit(plot);
+
+    trace_end(&t, b->bname, 0, len);
+}
@@ -0,0 +1,242 @@
+#include "feat.h"
+
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FEAT_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*feat_fn)(const uint8_t *, size_t, float *, float *);
+
+/**
+ * @brief RGB -> normalized (r, g) chromaticity, same transform
+ * as image_rgmat; black pixels map to (0, 0).
+ */
+static void rg_scalar(const uint8_t *rgb, size_t n, float *x0, float *x1) {
+    size_t i;
+    float s;
+
+    for (i = 0; i < n; i += 1, rgb += 3) {
+        s = (float)rgb[0] + rgb[1] + rgb[2];
+        x0[i] = (s > 0) ? rgb[0] / s : 0;
+        x1[i] = (s > 0) ? rgb[1] / s : 0;
+    }
+}
+
+/**
+ * @brief RGB -> (Cb, Cr), same transform as image_ycbcrmat.
+ */
+static void ycbcr_scalar(const uint8_t *rgb, size_t n, float *x0, float *x1) {
+    size_t i;
+
+    for (i = 0; i < n; i += 1, rgb += 3) {
+        x0[i] = -0.169f * rgb[0] - 0.332f * rgb[1] + 0.5f * rgb[2];
+        x1[i] = 0.5f * rgb[0] - 0.419f * rgb[1] - 0.081f * rgb[2];
+    }
+}
+
+#ifdef FEAT_X86
+
+/**
+ * @brief Splits 8 interleaved RGB pixels (exactly 24 bytes read)
+ * into three float vectors. pshufb gathers each channel from the
+ * low 16 and high 8 bytes, then the bytes widen to float.
+ */
+__attribute__((target("avx2")))
+static inline void rgb8_load(const uint8_t *p, __m256 *r, __m256 *g, __m256 *b) {
+    const __m128i rlo = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i rhi = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i glo = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i ghi = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i blo = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i bhi = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i lo = _mm_loadu_si128((const __m128i*)p);
+    __m128i hi = _mm_loadl_epi64((const __m128i*)(p + 16));
+
+    *r = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, rlo), _mm_shuffle_epi8(hi, rhi))));
+    *g = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, glo), _mm_shuffle_epi8(hi, ghi))));
+    *b = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, blo), _mm_shuffle_epi8(hi, bhi))));
+}
+
+__attribute__((target("avx2,fma")))
+static void rg_avx2(const uint8_t *rgb, size_t n, float *x0, float *x1) {
+    const __m256 two = _mm256_set1_ps(2), zero = _mm256_setzero_ps();
+    __m256 r, g, b, s, inv, nz;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8, rgb += 24) {
+        rgb8_load(rgb, &r, &g, &b);
+        s = _mm256_add_ps(_mm256_add_ps(r, g), b);
+
+        // reciprocal estimate plus one Newton step (~23 bits)
+        inv = _mm256_rcp_ps(s);
+        inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(s, inv, two));
+
+        // black pixels: rcp(0) = inf, masked back to 0
+        nz = _mm256_cmp_ps(s, zero, _CMP_GT_OQ);
+        _mm256_storeu_ps(x0 + i, _mm256_and_ps(nz, _mm256_mul_ps(r, inv)));
+        _mm256_storeu_ps(x1 + i, _mm256_and_ps(nz, _mm256_mul_ps(g, inv)));
+    }
+
+    _mm256_zeroupper();
+    rg_scalar(rgb, n - i, x0 + i, x1 + i);
+}
+
+__attribute__((target("avx2,fma")))
+static void ycbcr_avx2(const uint8_t *rgb, size_t n, float *x0, float *x1) {
+    const __m256 cr = _mm256_set1_ps(-0.169f), cg = _mm256_set1_ps(-0.332f), cb = _mm256_set1_ps(0.5f);
+    const __m256 dr = _mm256_set1_ps(0.5f), dg = _mm256_set1_ps(-0.419f), db = _mm256_set1_ps(-0.081f);
+    __m256 r, g, b;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8, rgb += 24) {
+        rgb8_load(rgb, &r, &g, &b);
+        _mm256_storeu_ps(x0 + i, _mm256_fmadd_ps(cb, b, _mm256_fmadd_ps(cg, g, _mm256_mul_ps(cr, r))));
+        _mm256_storeu_ps(x1 + i, _mm256_fmadd_ps(db, b, _mm256_fmadd_ps(dg, g, _mm256_mul_ps(dr, r))));
+    }
+
+    _mm256_zeroupper();
+    ycbcr_scalar(rgb, n - i, x0 + i, x1 + i);
+}
+
+#endif // FEAT_X86
+
+static feat_fn rg_fn, ycbcr_fn;
+static const char *isa;
+static pthread_once_t feat_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Picks the conversion kernels once under feat_once, so
+ * every feature worker converts with the same kernel (the scalar
+ * and AVX2 divisions do not round alike).
+ */
+static void feat_pick(void) {
+    isa = "scalar";
+    ycbcr_fn = ycbcr_scalar;
+    rg_fn = rg_scalar;
+
+#ifdef FEAT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        isa = "avx2";
+        ycbcr_fn = ycbcr_avx2;
+        rg_fn = rg_avx2;
+    }
+#endif
+}
+
+static void feat_init(void) {
+    pthread_once(&feat_once, feat_pick);
+}
+
+const char *feat_isa(void) {
+    feat_init();
+    return isa;
+}
+
+/**
+ * @brief Converts n interleaved 8-bit RGB pixels to RG
+ * chromaticity planes (structure of arrays, float32).
+ *
+ * @param rgb - 3n bytes of RGB
+ * @param n - Number of pixels
+ * @param x0 - Output r plane
+ * @param x1 - Output g plane
+ */
+void feat_rg_f32(const uint8_t *rgb, size_t n, float *x0, float *x1) {
+    feat_init();
+    rg_fn(rgb, n, x0, x1);
+}
+
+/**
+ * @brief Converts n interleaved 8-bit RGB pixels to Cb/Cr
+ * planes (structure of arrays, float32).
+ *
+ * @param rgb - 3n bytes of RGB
+ * @param n - Number of pixels
+ * @param x0 - Output Cb plane
+ * @param x1 - Output Cr plane
+ */
+void feat_ycbcr_f32(const uint8_t *rgb, size_t n, float *x0, float *x1) {
+    feat_init();
+    ycbcr_fn(rgb, n, x0, x1);
+}
+
+/**
+ * @brief Builds the RG or CbCr features of an image in the given
+ * precision. PREC_F64 fills a MAT exactly as image_rgmat /
+ * image_ycbcrmat; PREC_F32 fills float32 planes at half the
+ * memory traffic. A passed-in set is reused (and may switch
+ * precision); NULL allocates a new one.
+ *
+ * @param img - RGB image
+ * @param rg - RG (1) or CbCr (0) features
+ * @param prec - Storage precision
+ * @param f - Feature set to refill, or NULL
+ * @return feats_t* - Filled feature set, NULL if out of memory
+ * (a passed-in set is then left empty but still the caller's)
+ */
+feats_t *feats_image(Image *img, int rg, prec_t prec, feats_t *f) {
+    feats_t *nf = NULL;
+    size_t n;
+
+    if (!img) return NULL;
+    if (!f && !(f = nf = (feats_t*) calloc(1, sizeof(feats_t)))) return NULL;
+
+    n = img->size / 3;
+    f->prec = prec;
+    f->n = n;
+
+    if (prec == PREC_F64) {
+        f->x = rg ? image_rgmat(img, f->x) : image_ycbcrmat(img, f->x);
+        return f;
+    }
+
+    if (f->cap < n) {
+        free(f->x0); free(f->x1);
+        f->x0 = (float*) malloc(sizeof(float) * n);
+        f->x1 = (float*) malloc(sizeof(float) * n);
+        f->cap = n;
+
+        if (!f->x0 || !f->x1) {
+            free(f->x0); free(f->x1);
+            f->x0 = f->x1 = NULL;
+            f->cap = f->n = 0;
+            feats_free(nf);
+            return NULL;
+        }
+    }
+
+    if (rg)
+        feat_rg_f32(img->data, n, f->x0, f->x1);
+    else
+        feat_ycbcr_f32(img->data, n, f->x0, f->x1);
+
+    return f;
+}
+
+/**
+ * @brief Log-likelihood of feature rows [lo, lo + n) in the set's
+ * precision; results are double either way.
+ *
+ * @param m - Compiled 2-D model
+ * @param f - Feature set
+ * @param lo - First row
+ * @param n - Number of rows
+ * @param out - n log-likelihoods
+ */
+void feats_logeval(const gauss_model_t *m, const feats_t *f, size_t lo, size_t n, Real *out) {
+    if (f->prec == PREC_F32)
+        gauss_logeval_soa2m(m, f->x0 + lo, f->x1 + lo, n, out);
+    else
+        gauss_logeval_rows(m, f->x, lo, n, out);
+}
+
+void feats_free(feats_t *f) {
+    if (!f) return;
+
+    m_free(f->x);
+    free(f->x0); free(f->x1);
+    free(f);
+}
@@ -0,0 +1,280 @@
+#include "fixed.h"
+
+/*
+ * Kernels for feature dimensions 1..FX_MAX_D. Each FX_DEFINE(D)
+ * instantiates the same code with D a compile-time constant, so
+ * the loops unroll completely and operands live in registers /
+ * local arrays instead of behind Meschach's row pointers. The
+ * arithmetic is done in the same order as the generic routines
+ * they replace (mom_add, sample_cov, gauss_maha, disc_eval,
+ * sample_block), so routed results are unchanged.
+ */
+#define FX_DEFINE(D)                                                            \
+                                                                                \
+/* determinant by elimination with partial pivoting */                         \
+static double fx_det_##D(Real **a) {                                            \
+    double t[D][D], det = 1, f, tmp;                                            \
+    int i, j, k, p;                                                             \
+                                                                                \
+    for (i = 0; i < D; i += 1) for (j = 0; j < D; j += 1) t[i][j] = a[i][j];    \
+                                                                                \
+    for (k = 0; k < D; k += 1) {                                                \
+        for (i = k + 1, p = k; i < D; i += 1) if (fabs(t[i][k]) > fabs(t[p][k])) p = i; \
+        if (t[p][k] == 0) return 0;                                             \
+        if (p != k) {                                                           \
+            for (j = 0; j < D; j += 1) { tmp = t[k][j]; t[k][j] = t[p][j]; t[p][j] = tmp; } \
+            det = -det;                                                         \
+        }                                                                       \
+        det *= t[k][k];                                                         \
+        for (i = k + 1; i < D; i += 1) {                                        \
+            f = t[i][k] / t[k][k];                                              \
+            for (j = k + 1; j < D; j += 1) t[i][j] -= f * t[k][j];              \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    return det;                                                                 \
+}                                                                               \
+                                                                                \
+/* Gauss-Jordan inverse with partial pivoting; 1 if singular */                \
+static int fx_inv_##D(Real **a, Real **out) {                                   \
+    double t[D][D], v[D][D], f, tmp;                                            \
+    int i, j, k, p;                                                             \
+                                                                                \
+    for (i = 0; i < D; i += 1) {                                                \
+        for (j = 0; j < D; j += 1) { t[i][j] = a[i][j]; v[i][j] = (i == j); }   \
+    }                                                                           \
+                                                                                \
+    for (k = 0; k < D; k += 1) {                                                \
+        for (i = k + 1, p = k; i < D; i += 1) if (fabs(t[i][k]) > fabs(t[p][k])) p = i; \
+        if (t[p][k] == 0) return 1;                                             \
+        for (j = 0; j < D; j += 1) {                                            \
+            tmp = t[k][j]; t[k][j] = t[p][j]; t[p][j] = tmp;                    \
+            tmp = v[k][j]; v[k][j] = v[p][j]; v[p][j] = tmp;                    \
+        }                                                                       \
+        for (f = 1 / t[k][k], j = 0; j < D; j += 1) { t[k][j] *= f; v[k][j] *= f; } \
+        for (i = 0; i < D; i += 1) {                                            \
+            if (i == k) continue;                                               \
+            for (f = t[i][k], j = 0; j < D; j += 1) {                           \
+                t[i][j] -= f * t[k][j];                                         \
+                v[i][j] -= f * v[k][j];                                         \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    for (i = 0; i < D; i += 1) for (j = 0; j < D; j += 1) out[i][j] = v[i][j];  \
+                                                                                \
+    return 0;                                                                   \
+}                                                                               \
+                                                                                \
+/* Welford updates over n rows (as mom_add) */                                 \
+static void fx_mom_##D(const Real *x, size_t n, ptrdiff_t ld, size_t *cnt, Real *mu, Real **m2) { \
+    double u[D], s[D][D], delta[D], inv;                                        \
+    size_t c = *cnt, r;                                                         \
+    int i, k;                                                                   \
+                                                                                \
+    for (i = 0; i < D; i += 1) {                                                \
+        u[i] = mu[i];                                                           \
+        for (k = 0; k <= i; k += 1) s[i][k] = m2[i][k];                         \
+    }                                                                           \
+                                                                                \
+    for (r = 0; r < n; r += 1, x += ld) {                                       \
+        c += 1;                                                                 \
+        inv = 1.0 / c;                                                          \
+        for (i = 0; i < D; i += 1) {                                            \
+            delta[i] = x[i] - u[i];                                             \
+            u[i] += delta[i] * inv;                                             \
+        }                                                                       \
+        for (i = 0; i < D; i += 1) {                                            \
+            for (k = 0; k <= i; k += 1) s[i][k] += delta[i] * (x[k] - u[k]);    \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    for (i = 0; i < D; i += 1) {                                                \
+        mu[i] = u[i];                                                           \
+        for (k = 0; k <= i; k += 1) m2[i][k] = s[i][k];                         \
+    }                                                                           \
+    *cnt = c;                                                                   \
+}                                                                               \
+                                                                                \
+/* unbiased covariance about a given mean (as sample_cov) */                   \
+static void fx_cov_##D(const Real *x, size_t n, ptrdiff_t ld, const Real *mu, Real **out) { \
+    double s[D][D] = { { 0 } }, d[D];                                           \
+    size_t r;                                                                   \
+    int i, k;                                                                   \
+                                                                                \
+    for (r = 0; r < n; r += 1, x += ld) {                                       \
+        for (i = 0; i < D; i += 1) d[i] = x[i] - mu[i];                         \
+        for (i = 0; i < D; i += 1) {                                            \
+            for (k = 0; k <= i; k += 1) s[i][k] += d[i] * d[k];                 \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    for (i = 0; i < D; i += 1) {                                                \
+        for (k = 0; k <= i; k += 1) out[i][k] = out[k][i] = s[i][k] / (n - 1);  \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* offset + scale * (x - mu)' P (x - mu), P symmetric (as gauss_maha) */       \
+static void fx_quad_##D(const Real *mu, Real **p, const Real *x, size_t n, ptrdiff_t ld, double scale, double offset, Real *out) { \
+    double u[D], a[D][D], d[D], q, s;                                           \
+    size_t r;                                                                   \
+    int i, k;                                                                   \
+                                                                                \
+    for (i = 0; i < D; i += 1) {                                                \
+        u[i] = mu[i];                                                           \
+        for (k = 0; k <= i; k += 1) a[i][k] = p[i][k];                          \
+    }                                                                           \
+                                                                                \
+    for (r = 0; r < n; r += 1, x += ld) {                                       \
+        for (i = 0, q = 0; i < D; i += 1) {                                     \
+            d[i] = x[i] - u[i];                                                 \
+            for (k = 0, s = 0; k < i; k += 1) s += a[i][k] * d[k];              \
+            q += d[i] * (a[i][i] * d[i] + 2 * s);                               \
+        }                                                                       \
+        out[r] = offset + scale * q;                                            \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* x'.W.x + w'.x + w0, W symmetric (as disc_eval) */                           \
+static void fx_disc_##D(Real **W, const Real *w, double w0, int quad, const Real *x, size_t n, ptrdiff_t ld, Real *out) { \
+    double a[D][D], b[D], q, s;                                                 \
+    size_t r;                                                                   \
+    int i, j;                                                                   \
+                                                                                \
+    for (i = 0; i < D; i += 1) {                                                \
+        b[i] = w[i];                                                            \
+        for (j = 0; j <= i; j += 1) a[i][j] = W[i][j];                          \
+    }                                                                           \
+                                                                                \
+    for (r = 0; r < n; r += 1, x += ld) {                                       \
+        for (i = 0, q = w0; i < D; i += 1) {                                    \
+            s = b[i];                                                           \
+            if (quad) {                                                         \
+                for (j = 0, s += a[i][i] * x[i]; j < i; j += 1) s += 2 * a[i][j] * x[j]; \
+            }                                                                   \
+            q += s * x[i];                                                      \
+        }                                                                       \
+        out[r] = q;                                                             \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* out[r] = mu + L z_r, L lower triangular (as sample_block) */                \
+static void fx_sample_##D(Real **L, const Real *mu, const double *z, size_t n, Real **out) { \
+    double l[D][D], u[D], s;                                                    \
+    size_t r;                                                                   \
+    int j, k;                                                                   \
+                                                                                \
+    for (j = 0; j < D; j += 1) {                                                \
+        u[j] = mu[j];                                                           \
+        for (k = 0; k <= j; k += 1) l[j][k] = L[j][k];                          \
+    }                                                                           \
+                                                                                \
+    for (r = 0; r < n; r += 1, z += D) {                                        \
+        for (j = 0; j < D; j += 1) {                                            \
+            for (k = 0, s = 0; k <= j; k += 1) s += l[j][k] * z[k];             \
+            out[r][j] = u[j] + s;                                               \
+        }                                                                       \
+    }                                                                           \
+}
+
+FX_DEFINE(1)
+FX_DEFINE(2)
+FX_DEFINE(3)
+FX_DEFINE(4)
+
+// switch over the instantiated dimensions
+#define FX_CASES(call)                                                          \
+    switch (d) {                                                                \
+        case 1: call(1); break;                                                 \
+        case 2: call(2); break;                                                 \
+        case 3: call(3); break;                                                 \
+        case 4: call(4); break;                                                 \
+    }
+
+/**
+ * @brief Determinant of a square matrix of dimension
+ * 1..FX_MAX_D (callers check fx_has).
+ */
+double fx_det(const MAT *a) {
+    double det = 0;
+    int d = a->m;
+
+#define FX_CALL(D) det = fx_det_##D(a->me)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+
+    return det;
+}
+
+/**
+ * @brief Matrix inverse; dimensions 1..FX_MAX_D use the fixed
+ * kernels, anything else m_inverse.
+ *
+ * @param a - Square matrix
+ * @param out - Inverse (resized), or MNULL
+ * @return MAT* - out
+ */
+MAT *fx_inverse(const MAT *a, MAT *out) {
+    int d = a->m, rc = 0;
+
+    if (a->m != a->n || !fx_has(d)) return m_inverse(a, out);
+
+    out = m_resize(out, d, d);
+
+#define FX_CALL(D) rc = fx_inv_##D(a->me, out->me)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+
+    if (rc) error(E_SING, "fx_inverse");
+
+    return out;
+}
+
+/**
+ * @brief Welford accumulation of n rows (stride ld) into a
+ * running count, mean and lower-triangular M2.
+ */
+void fx_mom(int d, const Real *x, size_t n, ptrdiff_t ld, size_t *cnt, Real *mu, Real **m2) {
+#define FX_CALL(D) fx_mom_##D(x, n, ld, cnt, mu, m2)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+}
+
+/**
+ * @brief Unbiased covariance of n rows about mu (full, symmetric).
+ */
+void fx_cov(int d, const Real *x, size_t n, ptrdiff_t ld, const Real *mu, Real **out) {
+#define FX_CALL(D) fx_cov_##D(x, n, ld, mu, out)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+}
+
+/**
+ * @brief out[i] = offset + scale * (x_i - mu)' P (x_i - mu) over
+ * n rows, reading only P's lower triangle.
+ */
+void fx_quad(int d, const Real *mu, Real **p, const Real *x, size_t n, ptrdiff_t ld, double scale, double offset, Real *out) {
+#define FX_CALL(D) fx_quad_##D(mu, p, x, n, ld, scale, offset, out)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+}
+
+/**
+ * @brief out[i] = x_i'.W.x_i + w'.x_i + w0 over n rows, reading
+ * only W's lower triangle (skipped when !quad).
+ */
+void fx_disc(int d, Real **W, const Real *w, double w0, int quad, const Real *x, size_t n, ptrdiff_t ld, Real *out) {
+#define FX_CALL(D) fx_disc_##D(W, w, w0, quad, x, n, ld, out)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+}
+
+/**
+ * @brief n samples out[i] = mu + L z_i from packed normals z
+ * (d per sample), L lower triangular.
+ */
+void fx_sample(int d, Real **L, const Real *mu, const double *z, size_t n, Real **out) {
+#define FX_CALL(D) fx_sample_##D(L, mu, z, n, out)
+    FX_CASES(FX_CALL)
+#undef FX_CALL
+}
@@ -0,0 +1,186 @@
+#include "gauss.h"
+
+typedef struct sample_ctx_t {
+    gauss_model_t *model;
+    rng_t *rng;         // one stream per block
+    size_t n;
+    MAT *out;
+} sample_ctx_t;
+
+/**
+ * @brief Compiles a class distribution into its evaluation
+ * form. Factors sigma once (Cholesky) and caches the precision
+ * matrix, log-determinant and log-normalizer in g->model, which
+ * is (re)used in place on later compiles. Must be called again
+ * whenever g->mu or g->sigma change. Nothing is raised, so it may
+ * run on worker threads.
+ *
+ * @param g - Class/Category distribution
+ * @return gauss_model_t* - Compiled model (g->model), NULL if
+ * sigma is not positive definite (g->model is then unusable)
+ */
+gauss_model_t *gauss_compile(gauss_t *g) {
+    gauss_model_t *m;
+    VEC *e, *col;
+    size_t i, k;
+    int d;
+
+    d = g->mu->dim;
+
+    if (!(m = g->model)) {
+        m = (gauss_model_t*) calloc(1, sizeof(gauss_model_t));
+        g->model = m;
+    }
+
+    m->d = d;
+    m->mu = v_copy(g->mu, m->mu);
+    m->chol = m_copy(g->sigma, m->chol);
+    if (CHfactor_ec(m->chol)) return NULL;
+    m->prec = m_resize(m->prec, d, d);
+
+    // precision matrix column-by-column from the factor
+    e = v_get(d);
+    col = v_get(d);
+    for (k = 0; k < d; k += 1) {
+        v_zero(e);
+        e->ve[k] = 1;
+        CHsolve(m->chol, e, col);
+        for (i = 0; i < d; i += 1) m->prec->me[i][k] = col->ve[i];
+    }
+
+    // log |sigma| = 2 * sum(log L_ii)
+    for (i = 0, m->logdet = 0; i < d; i += 1) {
+        m->logdet += 2 * log(m->chol->me[i][i]);
+    }
+
+    m->lognorm = -0.5 * (d * log(2 * M_PI) + m->logdet);
+
+    v_free(e); v_free(col);
+
+    return m;
+}
+
+void gauss_model_free(gauss_model_t *m) {
+    if (!m) return;
+
+    v_free(m->mu);
+    m_free(m->chol); m_free(m->prec);
+    free(m);
+}
+
+/**
+ * @brief Squared Mahalanobis distance (x - mu)' sigma^-1 (x - mu).
+ * Allocation free; x is read as m->d contiguous values (a VEC's
+ * ve or a MAT's row).
+ *
+ * @param m - Compiled model
+ * @param x - Feature vector
+ * @return double - Squared Mahalanobis distance
+ */
+double gauss_maha(const gauss_model_t *m, const Real *x) {
+    const Real *mu = m->mu->ve;
+    Real **p = m->prec->me;
+    double q, s, di;
+    int i, k;
+
+    if (fx_has(m->d)) {
+        fx_quad(m->d, mu, p, x, 1, m->d, 1, 0, &q);
+        return q;
+    }
+
+    for (i = 0, q = 0; i < m->d; i += 1) {
+        di = x[i] - mu[i];
+        // symmetric: diagonal term plus twice the lower triangle
+        for (k = 0, s = 0; k < i; k += 1) s += p[i][k] * (x[k] - mu[k]);
+        q += di * (p[i][i] * di + 2 * s);
+    }
+
+    return q;
+}
+
+double gauss_logeval(const gauss_model_t *m, const Real *x) {
+    return m->lognorm - 0.5 * gauss_maha(m, x);
+}
+
+double gauss_model_eval(const gauss_model_t *m, const Real *x) {
+    return exp(gauss_logeval(m, x));
+}
+
+/**
+ * @brief Draws one block of samples x = mu + L z, z ~ N(0, I),
+ * from the block's own stream. Normals are generated about
+ * RNG_BLOCK at a time and consumed d per sample.
+ */
+static void sample_block(void *arg, size_t blk, int w) {
+    sample_ctx_t *ctx = (sample_ctx_t*)arg;
+    const gauss_model_t *m = ctx->model;
+    Real **L = m->chol->me, *mu = m->mu->ve, *x;
+    double *z, *zr, s;
+    size_t i, l, r, c, t, chunk;
+    int j, k, d = m->d;
+
+    i = blk * GAUSS_SAMPLE_BLOCK;
+    l = (ctx->n - i < GAUSS_SAMPLE_BLOCK) ? ctx->n - i : GAUSS_SAMPLE_BLOCK;
+    chunk = (d < RNG_BLOCK) ? RNG_BLOCK / d : 1;
+    z = (double*) malloc(sizeof(double) * chunk * d);
+
+    for (r = 0; r < l; r += chunk) {
+        c = (l - r < chunk) ? l - r : chunk;
+        rng_normal(&ctx->rng[blk], z, c * d);
+
+        if (fx_has(d)) {
+            fx_sample(d, L, mu, z, c, &ctx->out->me[i + r]);
+            continue;
+        }
+
+        for (t = 0; t < c; t += 1) {
+            x = ctx->out->me[i + r + t];
+            zr = z + t * d;
+            // lower triangle only: CHfactor leaves the upper one as is
+            for (j = 0; j < d; j += 1) {
+                for (k = 0, s = 0; k <= j; k += 1) s += L[j][k] * zr[k];
+                x[j] = mu[j] + s;
+            }
+        }
+    }
+
+    free(z);
+}
+
+/**
+ * @brief Draws n samples of N(mu, sigma) with the full (correlated)
+ * covariance, via the Cholesky factor of the compiled model.
+ * Block b of GAUSS_SAMPLE_BLOCK rows uses the stream *rng jumped
+ * b times, so the output depends only on *rng and n, never on
+ * the thread count or schedule. *rng itself is not advanced.
+ *
+ * @param g - Class/Category distribution (compiled here)
+ * @param n - Number of samples
+ * @param rng - Base stream
+ * @param nthreads - Worker threads (< 1: one per CPU)
+ * @param out - Output matrix (resized to n x d), or MNULL
+ * @return MAT* - Samples, one per row; MNULL if sigma is not
+ * positive definite (out is then left as it was)
+ */
+MAT *gauss_sample(gauss_t *g, size_t n, const rng_t *rng, int nthreads, MAT *out) {
+    sample_ctx_t ctx;
+    size_t b, nblk;
+
+    if (!(ctx.model = gauss_compile(g))) return MNULL;
+    ctx.n = n;
+    ctx.out = out = m_resize(out, n, ctx.model->d);
+
+    nblk = (n + GAUSS_SAMPLE_BLOCK - 1) / GAUSS_SAMPLE_BLOCK;
+    ctx.rng = (rng_t*) malloc(sizeof(rng_t) * (nblk ? nblk : 1));
+
+    for (b = 0; b < nblk; b += 1) {
+        ctx.rng[b] = b ? ctx.rng[b - 1] : *rng;
+        if (b) rng_jump(&ctx.rng[b]);
+    }
+
+    pool_run(nblk, pool_threads(nthreads), sample_block, &ctx);
+
+    free(ctx.rng);
+
+    return out;
+}
@@ -1,5 +1,10 @@
 #include "image.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 Image *image_and(Image *a, Image *b, Image *out) {
     Image *result;
 
@@ -13,15 +18,18 @@ Image *image_and(Image *a, Image *b, Image *out) {
     return result;
 }
 
-Image *new_image(int m, int n, int q) {
+Image *new_image(uint32_t m, uint32_t n, int q) {
     Image *ret = (Image*)malloc(sizeof(Image));
 
     ret->m = m;
     ret->n = n;
     ret->q = q;
-    ret->size = m * n * 3;
+    ret->size = (size_t)m * n * 3;
 
     ret->data = (uint8_t*) calloc(ret->size, sizeof(uint8_t));
+    ret->mode = IMAGE_OWNED;
+    ret->map = NULL;
+    ret->map_size = 0;
 
     return ret;
 }
@@ -46,7 +54,16 @@ int del_image(Image *img) {
         return 1;
     }
 
-    free(img->data);
+    switch (img->mode) {
+    case IMAGE_MAPPED:
+    case IMAGE_MAPPED_RO:
+        munmap(img->map, img->map_size);
+        break;
+    case IMAGE_BORROWED:
+        break;
+    default:
+        free(img->data);
+    }
 
     free(img);
 
@@ -54,83 +71,213 @@ int del_image(Image *img) {
 }
 
 Image *load_image(const char *fname) {
-    char fpath[64];    
-
-    sprintf(fpath, "%s%s", IMAGE_DIR, fname);
-
-    Image *img = (Image*) malloc(sizeof(Image));
-    FILE *fp = fopen(fpath, "r");
+    return load_image_mode(fname, IMAGE_MAPPED);
+}
 
-    if (!fp) { 
-        fprintf(stderr, "Error opening '%s'.\n", fname); 
+/**
+ * @brief Loads a binary PPM (P6) / PGM (P5) from IMAGE_DIR by
+ * mapping the file and parsing the header in place. In the
+ * mapped modes Image.data points straight into the mapping
+ * (IMAGE_MAPPED is copy-on-write, IMAGE_MAPPED_RO faults on
+ * writes); IMAGE_OWNED copies the raster out once and unmaps.
+ *
+ * @param fname - File name under IMAGE_DIR
+ * @param mode - IMAGE_MAPPED, IMAGE_MAPPED_RO or IMAGE_OWNED
+ * @return Image* - Loaded image, NULL on error
+ */
+Image *load_image_mode(const char *fname, int mode) {
+    char fpath[MAX_FPATH];
+    struct stat st;
+    Image *img;
+    size_t off;
+    void *map;
+    int fd;
+
+    snprintf(fpath, MAX_FPATH, "%s%s", IMAGE_DIR, fname);
+
+    if ((fd = open(fpath, O_RDONLY)) < 0) {
+        fprintf(stderr, "Error opening '%s'.\n", fname);
         return NULL;
     }
 
-    // gets file size
-    fseek(fp, 0, SEEK_END);
-    size_t fsize = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
+    if (fstat(fd, &st) || st.st_size <= 0) {
+        fprintf(stderr, "Error reading size of '%s'.\n", fname);
+        close(fd);
+        return NULL;
+    }
 
-    uint8_t *fbuf = (uint8_t*) malloc(sizeof(uint8_t) * fsize);
+    map = mmap(NULL, st.st_size, (mode == IMAGE_MAPPED_RO) ? PROT_READ : PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // the mapping outlives the descriptor
+    close(fd);
 
-    // loads entire file into memory
-    if (!fread(fbuf, sizeof(uint8_t), fsize, fp)) {
-        fprintf(stderr, "Error loading file into buffer.\n");
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping '%s'.\n", fname);
         return NULL;
     }
 
-    // opens filestream on file buffer
-    FILE *fbuf_stream = fmemopen(fbuf, fsize, "r");
+    img = (Image*) malloc(sizeof(Image));
 
-    // extracts header information from file buffer
-    if (load_header(fbuf_stream, img)) {
+    // extracts header information from the mapping
+    if (parse_header((const uint8_t*)map, st.st_size, img, &off)) {
         fprintf(stderr, "Error loading file header.\n");
+        munmap(map, st.st_size);
+        free(img);
         return NULL;
     }
 
-    if (load_data(fbuf_stream, img)) {
-        fprintf(stderr, "Error loading file data.\n");
-        return NULL;
+#ifdef MADV_SEQUENTIAL
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    if (mode == IMAGE_OWNED) {
+        img->data = (uint8_t*) malloc(sizeof(uint8_t) * img->size);
+        memcpy(img->data, (uint8_t*)map + off, img->size);
+        munmap(map, st.st_size);
+        img->map = NULL;
+        img->map_size = 0;
+    } else {
+        img->data = (uint8_t*)map + off;
+        img->map = map;
+        img->map_size = st.st_size;
     }
-    
-    free(fbuf);
-    fclose(fp);
+    img->mode = mode;
 
     return img;
 }
 
-int load_header(FILE *fp, Image *img) {
-    char *rbuf = (char*) malloc(sizeof(char) * 64);
-    int rgb = 0;
-
-    fgets(rbuf, 64, fp);
+/**
+ * @brief Wraps a PPM/PGM file image already in memory without
+ * copying. Image.data points into buf, which must outlive the
+ * Image; del_image only frees the Image itself.
+ *
+ * @param buf - Complete file contents
+ * @param len - Length of buf
+ * @return Image* - Borrowed image, NULL on error
+ */
+Image *image_borrow(const uint8_t *buf, size_t len) {
+    Image *img = (Image*) malloc(sizeof(Image));
+    size_t off;
 
-    if (strcmp(rbuf, "P6\n") == 0) {
-        rgb = 1;
+    if (parse_header(buf, len, img, &off)) {
+        fprintf(stderr, "Error loading file header.\n");
+        free(img);
+        return NULL;
     }
 
-    do { fgets(rbuf, 64, fp); } while (rbuf[0] == '#');
+    img->data = (uint8_t*)(buf + off);
+    img->mode = IMAGE_BORROWED;
+    img->map = NULL;
+    img->map_size = 0;
+
+    return img;
+}
+
+/**
+ * @brief Scans a binary PPM/PGM header ("P6"/"P5", width,
+ * height, maxval, '#' comments allowed) at the start of buf.
+ * Does not look past the header, so buf may be just a prefix
+ * of the file: a header cut short by len is rejected.
+ *
+ * @param buf - Start of the file
+ * @param len - Length of buf
+ * @param img - Receives m, n, q and size
+ * @param off - Receives offset of the raster in the file
+ * @return int - 0 on success, 1 on malformed/truncated header
+ */
+static int scan_header(const uint8_t *buf, size_t len, Image *img, size_t *off) {
+    size_t i, k, v[3];
+    int rgb;
+
+    if (len < 2 || buf[0] != 'P' || (buf[1] != '5' && buf[1] != '6')) return 1;
+    rgb = (buf[1] == '6');
+
+    for (k = 0, i = 2; k < 3; k += 1) {
+        // skip whitespace and comment lines
+        while (i < len && (isspace(buf[i]) || buf[i] == '#')) {
+            if (buf[i] == '#') {
+                while (i < len && buf[i] != '\n') i += 1;
+            } else {
+                i += 1;
+            }
+        }
+
+        if (i >= len || !isdigit(buf[i])) return 1;
+        for (v[k] = 0; i < len && isdigit(buf[i]); i += 1) {
+            v[k] = v[k] * 10 + (buf[i] - '0');
+            if (v[k] > UINT32_MAX) return 1;
+        }
+    }
 
-    sscanf(rbuf, "%hu %hu\n", &img->m, &img->n);
+    // exactly one whitespace byte precedes the raster
+    if (i >= len || !isspace(buf[i])) return 1;
+    i += 1;
 
-    fscanf(fp, "%hu\n", &img->q);
+    if (v[2] == 0 || v[2] > UINT8_MAX) return 1;
 
-    img->size = img->m * img->n * ((rgb) ? 3 : 1);
+    img->m = v[0];
+    img->n = v[1];
+    img->q = v[2];
+    img->size = (size_t)img->m * img->n * ((rgb) ? 3 : 1);
 
-    free(rbuf);
+    *off = i;
 
     return 0;
 }
 
+/**
+ * @brief Parses a binary PPM/PGM header from memory and checks
+ * the raster fits in the buffer.
+ *
+ * @param buf - File contents
+ * @param len - Length of buf
+ * @param img - Receives m, n, q and size
+ * @param off - Receives offset of the raster in buf
+ * @return int - 0 on success, 1 on malformed/truncated input
+ */
+int parse_header(const uint8_t *buf, size_t len, Image *img, size_t *off) {
+    if (scan_header(buf, len, img, off)) return 1;
+
+    return (len - *off < img->size);
+}
+
+/**
+ * @brief Reads a PPM/PGM header from an open file with the same
+ * grammar as parse_header, from a bounded read of at most
+ * IMAGE_HEADER_MAX bytes, and leaves fp at the start of the
+ * raster. For regular files the raster must fit in the file.
+ *
+ * @param fp - File opened for binary reading, at its start
+ * @param img - Receives m, n, q and size
+ * @return int - 0 on success, 1 on malformed/truncated input
+ */
+int load_header(FILE *fp, Image *img) {
+    uint8_t buf[IMAGE_HEADER_MAX];
+    struct stat st;
+    size_t len, off;
+
+    len = fread(buf, 1, sizeof(buf), fp);
+    if (scan_header(buf, len, img, &off)) return 1;
+
+    if (!fstat(fileno(fp), &st) && S_ISREG(st.st_mode)) {
+        if ((size_t)st.st_size < off || (size_t)st.st_size - off < img->size) return 1;
+    }
+
+    return fseek(fp, (long)off, SEEK_SET) != 0;
+}
+
 int load_data(FILE *fp, Image *img) {
     uint8_t *img_data = (uint8_t*) malloc(sizeof(uint8_t) * img->size);
 
-    if (!fread(img_data, sizeof(uint8_t), img->size, fp)) {
-        fprintf(stderr, "Error. Image is not %d by %d.\n", img->m, img->n);
+    if (fread(img_data, sizeof(uint8_t), img->size, fp) != img->size) {
+        fprintf(stderr, "Error. Image is not %" PRIu32 " by %" PRIu32 ".\n", img->m, img->n);
+        free(img_data);
         return 1;
     }
 
     img->data = img_data;
+    img->mode = IMAGE_OWNED;
+    img->map = NULL;
+    img->map_size = 0;
 
     return 0;
 }
@@ -145,7 +292,7 @@ int write_image(const char *fname, Image *img) {
     if (!fp) { fprintf(stderr, "Error opening destination file '%s'.\n", fname); return 1; }
 
     // writes header
-    fprintf(fp, "P%d\n%d %d\n%d\n", (img->size > img->m * img->n) ? 6 : 5, img->m, img->n, img->q);
+    fprintf(fp, "P%d\n%" PRIu32 " %" PRIu32 "\n%d\n", (img->size > (size_t)img->m * img->n) ? 6 : 5, img->m, img->n, img->q);
 
     // writes data
     size_t wsize = fwrite(img->data, sizeof(uint8_t), img->size, fp);
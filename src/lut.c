@@ -0,0 +1,151 @@
+#include "lut.h"
+
+typedef struct lut_ctx_t {
+    lut_t *t;
+    gauss_model_t *model;
+    Real **x, **d;      // per-worker feature/score buffers
+} lut_ctx_t;
+
+/**
+ * @brief Scores one block of cells. Each cell is evaluated at
+ * its center color (exactly the color at 8 bits) with the same
+ * feature transform as image_rgmat / image_ycbcrmat.
+ */
+static void lut_block(void *arg, size_t blk, int w) {
+    lut_ctx_t *ctx = (lut_ctx_t*)arg;
+    lut_t *t = ctx->t;
+    Real *x = ctx->x[w], *d = ctx->d[w];
+    size_t c, i, l, lo, mask;
+    double r, g, b, n, half;
+    int bits = t->bits;
+
+    lo = blk * LUT_BLOCK;
+    l = (t->cells - lo < LUT_BLOCK) ? t->cells - lo : LUT_BLOCK;
+    mask = ((size_t)1 << bits) - 1;
+    half = (bits < 8) ? (1 << (7 - bits)) : 0;
+
+    for (i = 0; i < l; i += 1) {
+        c = lo + i;
+        r = ((c >> (2 * bits)) << (8 - bits)) + half;
+        g = (((c >> bits) & mask) << (8 - bits)) + half;
+        b = ((c & mask) << (8 - bits)) + half;
+
+        if (t->rg) {
+            n = r + g + b;
+            x[2 * i] = (n > 0) ? r / n : 0;
+            x[2 * i + 1] = (n > 0) ? g / n : 0;
+        } else {
+            x[2 * i] = -0.169 * r - 0.332 * g + 0.5 * b;
+            x[2 * i + 1] = 0.5 * r - 0.419 * g - 0.081 * b;
+        }
+    }
+
+    gauss_logeval_batch(ctx->model, x, l, 2, d);
+
+    for (i = 0; i < l; i += 1) t->lik[lo + i] = (float)exp(d[i]);
+
+    // pure black is never a detection
+    if (lo == 0 && bits == 8) t->lik[0] = 0;
+}
+
+/**
+ * @brief Compiles a trained 2-D color model into a lookup table
+ * over the RGB cube quantized to 'bits' bits per channel. The
+ * likelihood of every cell is kept (as float) so the detection
+ * bitmap can be rebuilt for a new threshold without touching the
+ * model. At 6 bits the bitmap is 32 KiB and the likelihoods 1 MiB.
+ *
+ * @param color - Trained RG or YCbCr distribution
+ * @param rg - RG (1) or YCbCr (0) features
+ * @param bits - Bits per channel (1..8)
+ * @param thresh - Detection threshold (likelihood)
+ * @return lut_t* - Compiled table, NULL on bad arguments or a
+ * covariance that is not positive definite
+ */
+lut_t *lut_compile(gauss_t *color, int rg, int bits, double thresh) {
+    lut_ctx_t ctx;
+    lut_t *t;
+    int w, nw;
+
+    if (bits < 1 || bits > 8 || color->mu->dim != 2) return NULL;
+    if (!(ctx.model = gauss_compile(color))) return NULL;
+
+    t = (lut_t*) malloc(sizeof(lut_t));
+    t->bits = bits;
+    t->rg = rg;
+    t->cells = (size_t)1 << (3 * bits);
+    t->lik = (float*) malloc(sizeof(float) * t->cells);
+    t->mask = (uint8_t*) malloc((t->cells + 7) / 8);
+
+    nw = pool_threads(0);
+    ctx.t = t;
+    ctx.x = (Real**) malloc(sizeof(Real*) * nw);
+    ctx.d = (Real**) malloc(sizeof(Real*) * nw);
+    for (w = 0; w < nw; w += 1) {
+        ctx.x[w] = (Real*) malloc(sizeof(Real) * 2 * LUT_BLOCK);
+        ctx.d[w] = (Real*) malloc(sizeof(Real) * LUT_BLOCK);
+    }
+
+    pool_run((t->cells + LUT_BLOCK - 1) / LUT_BLOCK, nw, lut_block, &ctx);
+
+    for (w = 0; w < nw; w += 1) { free(ctx.x[w]); free(ctx.d[w]); }
+    free(ctx.x); free(ctx.d);
+
+    lut_threshold(t, thresh);
+
+    return t;
+}
+
+/**
+ * @brief Rebuilds the detection bitmap for a new threshold
+ * from the stored cell likelihoods.
+ */
+void lut_threshold(lut_t *t, double thresh) {
+    size_t c, k;
+    uint8_t bits;
+
+    t->thresh = thresh;
+
+    for (c = 0; c < t->cells; c += 8) {
+        for (k = 0, bits = 0; k < 8 && c + k < t->cells; k += 1) {
+            bits |= (t->lik[c + k] >= thresh) << k;
+        }
+        t->mask[c >> 3] = bits;
+    }
+}
+
+void lut_free(lut_t *t) {
+    if (!t) return;
+
+    free(t->lik);
+    free(t->mask);
+    free(t);
+}
+
+/**
+ * @brief Skin detection by table lookup: copies the pixels whose
+ * cell is set in the bitmap, zeroes the rest.
+ *
+ * @param t - Compiled table
+ * @param img - RGB input
+ * @param out - Output image (same size) or NULL
+ * @return Image* - Detection image
+ */
+Image *lut_apply(const lut_t *t, Image *img, Image *out) {
+    size_t i, c;
+
+    if (!out) out = new_image(img->m, img->n, img->q);
+
+    for (i = 0; i < img->size; i += 3) {
+        c = lut_cell(t, img->data + i);
+        if (lut_hit(t, c)) {
+            out->data[i] = img->data[i];
+            out->data[i + 1] = img->data[i + 1];
+            out->data[i + 2] = img->data[i + 2];
+        } else {
+            out->data[i] = 0; out->data[i + 1] = 0; out->data[i + 2] = 0;
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,447 @@
+#define _GNU_SOURCE     // dladdr
+
+#include "memprof.h"
+
+#ifdef MEMPROF
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <link.h>
+
+// frames shown per unlabelled site (after Meschach's allocator)
+#define MPROF_SHOW      3
+
+typedef struct mprof_site_t {
+    const char *file;           // labelled call: file:line
+    int line;
+    void *pc[MPROF_DEPTH];      // otherwise: return addresses, innermost first
+    size_t allocs, bytes;       // gets and growing resizes, bytes they added
+    size_t arena;               // of allocs, arena storage (reclaimed on release)
+    size_t live, peak, nlive;   // live bytes, their peak, live objects
+} mprof_site_t;
+
+typedef struct mprof_obj_t {
+    void *obj;                  // NULL: empty slot
+    size_t bytes;
+    int site;
+} mprof_obj_t;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static mprof_site_t sites[MPROF_SITES];
+static int slot[2 * MPROF_SITES];   // site hash: index + 1, 0 if empty
+static int nsite = 0;
+static mprof_obj_t *objs = NULL;    // live objects, open addressing
+static size_t ocap = 0, nobj = 0;
+static size_t live = 0, peak = 0, untracked = 0;
+
+// label of this thread's current wrapper call
+static __thread const char *at_file = NULL;
+static __thread int at_line = 0;
+
+static size_t obj_bytes(int type, const void *obj) {
+    const MAT *a;
+
+    switch (type) {
+        case TYPE_MAT:
+            a = (const MAT*)obj;
+            return sizeof(MAT) + sizeof(Real) * a->max_size + sizeof(Real*) * a->max_m;
+        case TYPE_VEC:
+            return sizeof(VEC) + sizeof(Real) * ((const VEC*)obj)->max_dim;
+        case TYPE_PERM:
+            return sizeof(PERM) + sizeof(unsigned int) * ((const PERM*)obj)->max_size;
+    }
+
+    return 0;
+}
+
+static int site_get(const char *file, int line, void *const *pc) {
+    uint64_t h = (uintptr_t)file * 0x9e3779b97f4a7c15ULL ^ line;
+    size_t i, mask = 2 * MPROF_SITES - 1;
+    mprof_site_t *s;
+    int k;
+
+    for (k = 0; pc && k < MPROF_DEPTH; k += 1) h = (h ^ (uintptr_t)pc[k]) * 0x100000001b3ULL;
+
+    for (i = h & mask; slot[i]; i = (i + 1) & mask) {
+        s = &sites[slot[i] - 1];
+        if (s->file == file && s->line == line && (!pc || !memcmp(s->pc, pc, sizeof(s->pc)))) return slot[i] - 1;
+    }
+
+    if (nsite == MPROF_SITES - 1) return MPROF_SITES - 1;
+
+    s = &sites[nsite];
+    s->file = file;
+    s->line = line;
+    if (pc) memcpy(s->pc, pc, sizeof(s->pc));
+    slot[i] = nsite + 1;
+
+    return nsite++;
+}
+
+static size_t obj_hash(const void *p) {
+    return (size_t)(((uintptr_t)p >> 4) * 0x9e3779b97f4a7c15ULL);
+}
+
+static mprof_obj_t *obj_find(const void *p) {
+    size_t i;
+
+    if (!ocap) return NULL;
+
+    for (i = obj_hash(p) & (ocap - 1); objs[i].obj; i = (i + 1) & (ocap - 1)) {
+        if (objs[i].obj == p) return &objs[i];
+    }
+
+    return NULL;
+}
+
+static void obj_put(void *p, size_t bytes, int site) {
+    mprof_obj_t *old = objs;
+    size_t i, k, n = ocap;
+
+    // grow at half full
+    if (2 * (nobj + 1) > ocap) {
+        ocap = ocap ? 2 * ocap : 4096;
+        objs = (mprof_obj_t*) calloc(ocap, sizeof(mprof_obj_t));
+        for (k = 0, nobj = 0; k < n; k += 1) {
+            if (old[k].obj) obj_put(old[k].obj, old[k].bytes, old[k].site);
+        }
+        free(old);
+    }
+
+    for (i = obj_hash(p) & (ocap - 1); objs[i].obj; i = (i + 1) & (ocap - 1));
+
+    objs[i] = (mprof_obj_t) { p, bytes, site };
+    nobj += 1;
+}
+
+// removes a slot, shifting back later entries of its probe run
+static void obj_del(mprof_obj_t *e) {
+    size_t i = e - objs, j, h, mask = ocap - 1;
+
+    for (j = (i + 1) & mask; objs[j].obj; j = (j + 1) & mask) {
+        h = obj_hash(objs[j].obj) & mask;
+        if ((j > i) ? (h <= i || h > j) : (h <= i && h > j)) {
+            objs[i] = objs[j];
+            i = j;
+        }
+    }
+
+    objs[i].obj = NULL;
+    nobj -= 1;
+}
+
+static void charge(mprof_site_t *s, size_t bytes) {
+    s->live += bytes;
+    s->nlive += 1;
+    if (s->live > s->peak) s->peak = s->live;
+
+    live += bytes;
+    if (live > peak) peak = live;
+}
+
+static void discharge(mprof_site_t *s, size_t bytes) {
+    s->live -= bytes;
+    s->nlive -= 1;
+    live -= bytes;
+}
+
+/**
+ * @brief mem_hook: keeps the live-object table and per-site
+ * counts. New objects take the calling wrapper's label, else
+ * the call stack (captured before taking the lock).
+ */
+static void mprof_hook(int ev, int type, void *obj, int arena) {
+    void *pc[MPROF_DEPTH + 1] = { 0 };
+    mprof_site_t *s, *o;
+    mprof_obj_t *e;
+    size_t bytes;
+
+    if (ev == MEM_EV_NEW && !at_file) backtrace(pc, MPROF_DEPTH + 1);
+
+    pthread_mutex_lock(&lock);
+
+    switch (ev) {
+        case MEM_EV_NEW:
+            // frame 0 is this hook
+            s = &sites[at_file ? site_get(at_file, at_line, NULL) : site_get(NULL, 0, pc + 1)];
+            bytes = obj_bytes(type, obj);
+            s->allocs += 1;
+            s->bytes += bytes;
+
+            // arena storage goes back with mem_arena_release, freed or not
+            if (arena) {
+                s->arena += 1;
+                break;
+            }
+
+            obj_put(obj, bytes, s - sites);
+            charge(s, bytes);
+            break;
+
+        case MEM_EV_RESIZE:
+            if (!(e = obj_find(obj))) break;
+
+            bytes = obj_bytes(type, obj);
+            o = &sites[e->site];
+            // a labelled resize takes the object over
+            s = at_file ? &sites[site_get(at_file, at_line, NULL)] : o;
+
+            if (bytes > e->bytes) {
+                s->allocs += 1;
+                s->bytes += bytes - e->bytes;
+            }
+
+            discharge(o, e->bytes);
+            charge(s, bytes);
+            e->bytes = bytes;
+            e->site = s - sites;
+            break;
+
+        case MEM_EV_FREE:
+            if (!(e = obj_find(obj))) {
+                if (!arena) untracked += 1;
+                break;
+            }
+
+            discharge(&sites[e->site], e->bytes);
+            obj_del(e);
+            break;
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+VEC *mprof_v_get(int n, const char *file, int line) {
+    VEC *v;
+
+    at_file = file; at_line = line;
+    v = (v_get)(n);
+    at_file = NULL;
+
+    return v;
+}
+
+MAT *mprof_m_get(int m, int n, const char *file, int line) {
+    MAT *a;
+
+    at_file = file; at_line = line;
+    a = (m_get)(m, n);
+    at_file = NULL;
+
+    return a;
+}
+
+PERM *mprof_px_get(int n, const char *file, int line) {
+    PERM *p;
+
+    at_file = file; at_line = line;
+    p = (px_get)(n);
+    at_file = NULL;
+
+    return p;
+}
+
+VEC *mprof_v_resize(VEC *v, int n, const char *file, int line) {
+    at_file = file; at_line = line;
+    v = (v_resize)(v, n);
+    at_file = NULL;
+
+    return v;
+}
+
+MAT *mprof_m_resize(MAT *a, int m, int n, const char *file, int line) {
+    at_file = file; at_line = line;
+    a = (m_resize)(a, m, n);
+    at_file = NULL;
+
+    return a;
+}
+
+PERM *mprof_px_resize(PERM *p, int n, const char *file, int line) {
+    at_file = file; at_line = line;
+    p = (px_resize)(p, n);
+    at_file = NULL;
+
+    return p;
+}
+
+/**
+ * @brief Names the stack of each unlabelled site with
+ * addr2line, "fn (file:line)" per frame; frames addr2line
+ * cannot place keep their raw address.
+ *
+ * @param name - nsite x MPROF_DEPTH strings to fill (malloc'd)
+ */
+static void symbolize(char **name) {
+    char exe[512], cmd[4096], fn[256], loc[256];
+    size_t l, *at, n, i, j, b;
+    Dl_info self, info;
+    uintptr_t off;
+    ssize_t len;
+    FILE *p;
+    int s, k;
+
+    len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    exe[len > 0 ? len : 0] = '\0';
+    dladdr((void*)mprof_report, &self);
+
+    // frames inside this executable (name index), raw addresses for the rest
+    at = (size_t*) malloc(sizeof(size_t) * ((size_t)nsite * MPROF_DEPTH + 1));
+    for (s = 0, n = 0; s < nsite; s += 1) {
+        for (k = 0; k < MPROF_DEPTH && !sites[s].file && sites[s].pc[k]; k += 1) {
+            name[s * MPROF_DEPTH + k] = (char*) malloc(24);
+            snprintf(name[s * MPROF_DEPTH + k], 24, "%p", sites[s].pc[k]);
+            if (*exe && dladdr((char*)sites[s].pc[k] - 1, &info) && info.dli_fbase == self.dli_fbase) {
+                at[n++] = s * MPROF_DEPTH + k;
+            }
+        }
+    }
+
+    for (b = 0; b < n; b += 64) {
+        l = snprintf(cmd, sizeof(cmd), "addr2line -f -s -e '%s'", exe);
+        for (i = b; i < n && i < b + 64; i += 1) {
+            // return addresses point past the call
+            off = (uintptr_t)sites[at[i] / MPROF_DEPTH].pc[at[i] % MPROF_DEPTH] - 1;
+            if (((const ElfW(Ehdr)*)self.dli_fbase)->e_type == ET_DYN) off -= (uintptr_t)self.dli_fbase;
+            l += snprintf(cmd + l, sizeof(cmd) - l, " %#lx", (unsigned long)off);
+        }
+
+        if (!(p = popen(cmd, "r"))) break;
+
+        for (j = b; j < i && fgets(fn, sizeof(fn), p) && fgets(loc, sizeof(loc), p); j += 1) {
+            fn[strcspn(fn, "\n")] = '\0';
+            // drops " (discriminator n)"
+            loc[strcspn(loc, " \n")] = '\0';
+            if (!strcmp(fn, "??")) continue;
+
+            l = strlen(fn) + strlen(loc) + 4;
+            name[at[j]] = (char*) realloc(name[at[j]], l);
+            snprintf(name[at[j]], l, "%s (%s)", fn, loc);
+        }
+
+        pclose(p);
+    }
+
+    free(at);
+}
+
+// Meschach allocator and profiler frames, skipped in stack labels
+static int alloc_frame(const char *f) {
+    static const char *fns[] = { "mprof_", "mem_observe", "v_get", "m_get", "px_get", "v_resize", "m_resize", "px_resize" };
+    size_t k, l;
+
+    for (k = 0; k < sizeof(fns) / sizeof(fns[0]); k += 1) {
+        l = strlen(fns[k]);
+        if (!strncmp(f, fns[k], l) && (f[l] == ' ' || fns[k][l - 1] == '_')) return 1;
+    }
+
+    return 0;
+}
+
+static int site_cmp(const void *a, const void *b) {
+    size_t l = sites[*(const int*)a].bytes, r = sites[*(const int*)b].bytes;
+
+    return (l < r) - (l > r);
+}
+
+static int live_cmp(const void *a, const void *b) {
+    size_t l = sites[*(const int*)a].live, r = sites[*(const int*)b].live;
+
+    return (l < r) - (l > r);
+}
+
+// site label: file:line, or the first MPROF_SHOW frames past the allocator
+static void site_label(FILE *fp, int s, char **name) {
+    const char *f;
+    int k, shown;
+
+    if (sites[s].file) {
+        fprintf(fp, "%s:%d", sites[s].file, sites[s].line);
+        return;
+    }
+
+    for (k = 0, shown = 0; k < MPROF_DEPTH && shown < MPROF_SHOW && sites[s].pc[k]; k += 1) {
+        f = name[s * MPROF_DEPTH + k];
+        if (!shown && alloc_frame(f)) continue;
+        fprintf(fp, "%s%s", shown ? " < " : "", f);
+        shown += 1;
+    }
+}
+
+/**
+ * @brief Writes the profile (to $PA2_MEMPROF, else stderr):
+ * per site allocations, bytes, peak live bytes and objects
+ * still live, busiest first, then the leaks at exit. Runs at
+ * exit; observing stops here.
+ */
+void mprof_report(void) {
+    const char *path = getenv(MPROF_ENV);
+    char **name;
+    int *order, s, n, nleak;
+    size_t allocs, bytes;
+    FILE *fp = stderr;
+
+    pthread_mutex_lock(&lock);
+    mem_hook = NULL;
+
+    if (path && *path && !(fp = fopen(path, "w"))) {
+        fprintf(stderr, "Error opening '%s', profile goes to stderr.\n", path);
+        fp = stderr;
+    }
+
+    name = (char**) calloc((size_t)nsite * MPROF_DEPTH + 1, sizeof(char*));
+    order = (int*) malloc(sizeof(int) * (nsite + 1));
+    symbolize(name);
+
+    for (s = 0, n = 0, allocs = 0, bytes = 0; s < MPROF_SITES; s += 1) {
+        if (!sites[s].allocs) continue;
+        order[n++] = s;
+        allocs += sites[s].allocs;
+        bytes += sites[s].bytes;
+    }
+
+    fprintf(fp, "\nallocation profile: %d sites, %zu allocations, %.2f MB; peak live %.2f MB; live at exit %.2f MB in %zu objects\n",
+            n, allocs, bytes * 1e-6, peak * 1e-6, live * 1e-6, nobj);
+    fprintf(fp, "%10s %12s %9s %12s %9s  %s\n", "allocs", "total MB", "arena", "peak MB", "live", "site");
+
+    qsort(order, n, sizeof(int), site_cmp);
+    for (s = 0; s < n; s += 1) {
+        fprintf(fp, "%10zu %12.3f %9zu %12.3f %9zu  ", sites[order[s]].allocs, sites[order[s]].bytes * 1e-6,
+                sites[order[s]].arena, sites[order[s]].peak * 1e-6, sites[order[s]].nlive);
+        site_label(fp, order[s], name);
+        fprintf(fp, "\n");
+    }
+
+    qsort(order, n, sizeof(int), live_cmp);
+    for (s = 0, nleak = 0; s < n && sites[order[s]].nlive; s += 1, nleak += 1);
+
+    fprintf(fp, "\nleaks: %d sites with objects live at exit\n", nleak);
+    for (s = 0; s < nleak; s += 1) {
+        fprintf(fp, "%10zu objects %12zu bytes  ", sites[order[s]].nlive, sites[order[s]].live);
+        site_label(fp, order[s], name);
+        fprintf(fp, "\n");
+    }
+
+    if (untracked) fprintf(fp, "(%zu frees of objects allocated before profiling)\n", untracked);
+
+    for (s = 0; s < nsite * MPROF_DEPTH; s += 1) free(name[s]);
+    free(name); free(order);
+    if (fp != stderr) fclose(fp);
+
+    pthread_mutex_unlock(&lock);
+}
+
+// installs the hook before main, so the report (at exit) comes last
+__attribute__((constructor)) static void mprof_init(void) {
+    sites[MPROF_SITES - 1].file = "(other sites)";
+    mem_hook = mprof_hook;
+    atexit(mprof_report);
+}
+
+#endif // MEMPROF
@@ -0,0 +1,364 @@
+#include "plot.h"
+
+#include <signal.h>
+
+static plot_srv_t srv = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .ready = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER
+};
+
+/**
+ * @brief Worker loop: writes queued jobs, whole, to its own
+ * gnuplot process until the service stops and the queue is
+ * empty.
+ */
+static void *plot_worker(void *arg) {
+    gnuplot_ctrl *gp = (gnuplot_ctrl*)arg;
+    plot_job_t *j;
+    trace_t t;
+    sigset_t set;
+
+    // a dead gnuplot fails the write instead of killing the program
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    pthread_mutex_lock(&srv.lock);
+
+    for (;;) {
+        while (!srv.head && !srv.stop) pthread_cond_wait(&srv.ready, &srv.lock);
+        if (!(j = srv.head)) break;
+
+        if (!(srv.head = j->next)) srv.tail = NULL;
+        srv.busy += 1;
+        pthread_mutex_unlock(&srv.lock);
+
+        t = trace_begin("plot_send");
+        if (fwrite(j->buf, 1, j->len, gp->gnucmd) != j->len || fflush(gp->gnucmd)) {
+            fprintf(stderr, "Error. Failed to send plot to gnuplot.\n");
+        }
+        trace_end(&t, NULL, 0, j->len);
+        free(j->buf);
+        free(j);
+
+        pthread_mutex_lock(&srv.lock);
+        srv.busy -= 1;
+        if (!srv.head && !srv.busy) pthread_cond_broadcast(&srv.idle);
+    }
+
+    pthread_mutex_unlock(&srv.lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Starts the plotting service: nworkers persistent
+ * gnuplot processes, each fed by its own thread from one job
+ * queue. Called lazily by plot_submit; plot_stop runs at exit.
+ *
+ * @param nworkers - gnuplot processes (< 1 for PLOT_WORKERS)
+ * @return int - Number of workers running
+ */
+int plot_start(int nworkers) {
+    int w, n;
+
+    pthread_mutex_lock(&srv.lock);
+
+    if (srv.nworkers) {
+        pthread_mutex_unlock(&srv.lock);
+        return srv.nworkers;
+    }
+
+    if (nworkers < 1) nworkers = PLOT_WORKERS;
+
+    srv.tid = (pthread_t*) malloc(sizeof(pthread_t) * nworkers);
+    srv.gp = (gnuplot_ctrl**) malloc(sizeof(gnuplot_ctrl*) * nworkers);
+    srv.stop = 0;
+
+    for (w = 0, n = 0; w < nworkers; w += 1) {
+        if (!(srv.gp[n] = gnuplot_init())) continue;
+
+        if (pthread_create(&srv.tid[n], NULL, plot_worker, srv.gp[n])) {
+            fprintf(stderr, "Error. Failed to start plot worker %d.\n", w);
+            gnuplot_close(srv.gp[n]);
+            continue;
+        }
+        n += 1;
+    }
+
+    srv.nworkers = n;
+    pthread_mutex_unlock(&srv.lock);
+
+    if (n) atexit(plot_stop);
+
+    return n;
+}
+
+/**
+ * @brief Blocks until every submitted job has been handed to
+ * gnuplot (rendering may still be in progress; see plot_stop).
+ */
+void plot_wait(void) {
+    pthread_mutex_lock(&srv.lock);
+    while (srv.nworkers && (srv.head || srv.busy)) pthread_cond_wait(&srv.idle, &srv.lock);
+    pthread_mutex_unlock(&srv.lock);
+}
+
+/**
+ * @brief Drains the queue and closes every gnuplot process,
+ * which waits for them to finish writing their figures.
+ */
+void plot_stop(void) {
+    int w;
+
+    pthread_mutex_lock(&srv.lock);
+    srv.stop = 1;
+    pthread_cond_broadcast(&srv.ready);
+    pthread_mutex_unlock(&srv.lock);
+
+    for (w = 0; w < srv.nworkers; w += 1) {
+        pthread_join(srv.tid[w], NULL);
+        gnuplot_close(srv.gp[w]);
+    }
+
+    free(srv.tid); free(srv.gp);
+    srv.tid = NULL;
+    srv.gp = NULL;
+    srv.nworkers = 0;
+}
+
+static void plot_put(plot_job_t *j, const void *src, size_t n) {
+    if (j->len + n > j->cap) {
+        while (j->len + n > j->cap) j->cap = j->cap ? 2 * j->cap : 4096;
+        j->buf = (char*) realloc(j->buf, j->cap);
+    }
+
+    memcpy(j->buf + j->len, src, n);
+    j->len += n;
+}
+
+/**
+ * @brief New, empty job. Each job starts from a clean gnuplot
+ * state (reset), since the processes are shared.
+ */
+plot_job_t *plot_job(void) {
+    plot_job_t *j = (plot_job_t*) calloc(1, sizeof(plot_job_t));
+
+    plot_cmd(j, "reset");
+
+    return j;
+}
+
+/**
+ * @brief Appends one printf-style gnuplot command (newline
+ * terminated) to a job.
+ */
+void plot_cmd(plot_job_t *j, const char *fmt, ...) {
+    va_list ap;
+    char *s;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    s = (char*) malloc(n + 2);
+    va_start(ap, fmt);
+    vsnprintf(s, n + 1, fmt, ap);
+    va_end(ap);
+    s[n] = '\n';
+
+    plot_put(j, s, n + 1);
+    free(s);
+}
+
+/**
+ * @brief Data-file modifiers for an inline binary block of rows
+ * records of cols doubles, for use after '-' in a plot command:
+ * "binary record=(rows) format='%double...'".
+ *
+ * @param buf - Output buffer
+ * @param len - Size of buf
+ * @param rows - Records in the block
+ * @param cols - Doubles per record
+ * @return char* - buf
+ */
+char *plot_binspec(char *buf, size_t len, size_t rows, int cols) {
+    size_t l;
+    int k;
+
+    l = snprintf(buf, len, "binary record=(%zu) format='", rows);
+    for (k = 0; k < cols && l < len; k += 1) l += snprintf(buf + l, len - l, "%%double");
+    if (l < len) snprintf(buf + l, len - l, "'");
+
+    return buf;
+}
+
+/**
+ * @brief Appends a matrix as the raw (native double) inline data
+ * of a '-' plot element declared with plot_binspec(m->m, m->n).
+ * The rows are copied, so m may change once this returns.
+ */
+void plot_rows(plot_job_t *j, const MAT *m) {
+    size_t i;
+
+    for (i = 0; i < m->m; i += 1) plot_put(j, m->me[i], sizeof(Real) * m->n);
+}
+
+/**
+ * @brief Queues a finished job for the next free gnuplot worker
+ * and returns immediately. The job is owned and freed by the
+ * service. Output files are complete after plot_stop.
+ */
+void plot_submit(plot_job_t *j) {
+    // figure must be flushed before the process moves on
+    plot_cmd(j, "unset output");
+
+    if (!plot_start(0)) {
+        fprintf(stderr, "Error. No gnuplot worker, plot dropped.\n");
+        free(j->buf);
+        free(j);
+        return;
+    }
+
+    pthread_mutex_lock(&srv.lock);
+    j->next = NULL;
+    if (srv.tail) srv.tail->next = j;
+    else srv.head = j;
+    srv.tail = j;
+    pthread_cond_signal(&srv.ready);
+    pthread_mutex_unlock(&srv.lock);
+}
+
+/**
+ * @brief Samples kept from a stratum (class) of c samples when
+ * total samples are cut down to budget, in proportion to the
+ * stratum's size (rounded up, so no class disappears).
+ *
+ * @param c - Stratum size
+ * @param total - Samples over all strata
+ * @param budget - Samples to keep overall (0 keeps all)
+ * @return size_t - Samples to keep from this stratum
+ */
+size_t plot_quota(size_t c, size_t total, size_t budget) {
+    size_t q;
+
+    if (!budget || total <= budget) return c;
+
+    q = (c * budget + total - 1) / total;
+
+    return (q < c) ? q : c;
+}
+
+/**
+ * @brief Whether the j-th sample of a c-sample stratum is one of
+ * its q evenly spaced picks. Exactly q of j = 0..c-1 are kept,
+ * so the stratum's density is thinned uniformly.
+ */
+int plot_keep(size_t j, size_t q, size_t c) {
+    return (j + 1) * q / c != j * q / c;
+}
+
+/**
+ * @brief Stratified decimation of one dataset: the q evenly
+ * spaced rows chosen by plot_keep.
+ *
+ * @param data - Samples, one per row
+ * @param q - Rows to keep (plot_quota)
+ * @param out - Output matrix (resized), or MNULL
+ * @return MAT* - Kept rows
+ */
+MAT *plot_decimate(const MAT *data, size_t q, MAT *out) {
+    size_t i, k;
+
+    out = m_resize(out, q, data->n);
+
+    for (i = 0, k = 0; i < data->m && k < q; i += 1) {
+        if (plot_keep(i, q, data->m)) memcpy(out->me[k++], data->me[i], sizeof(Real) * data->n);
+    }
+
+    return out;
+}
+
+/**
+ * @brief Common plot range of n datasets: lim = { xmin, xmax,
+ * ymin, ymax } over the first (x) and last (y) column.
+ */
+void plot_bounds(MAT **data, int n, double *lim) {
+    size_t i, l;
+    double x, y;
+
+    lim[0] = lim[2] = HUGE_VAL;
+    lim[1] = lim[3] = -HUGE_VAL;
+
+    for (l = 0; l < n; l += 1) {
+        for (i = 0; i < data[l]->m; i += 1) {
+            x = data[l]->me[i][0];
+            y = data[l]->me[i][data[l]->n - 1];
+            if (x < lim[0]) lim[0] = x;
+            if (x > lim[1]) lim[1] = x;
+            if (y < lim[2]) lim[2] = y;
+            if (y > lim[3]) lim[3] = y;
+        }
+    }
+
+    // degenerate ranges still get a cell width
+    if (!(lim[1] > lim[0])) { lim[0] -= 0.5; lim[1] += 0.5; }
+    if (!(lim[3] > lim[2])) { lim[2] -= 0.5; lim[3] += 0.5; }
+}
+
+/**
+ * @brief Adds a dataset's (x, y) = (first, last column) samples
+ * to a 2-D histogram over lim. The grid is ny x nx (row = y), so
+ * its rows are the array plot_imgspec describes.
+ *
+ * @param data - Samples, one per row
+ * @param lim - { xmin, xmax, ymin, ymax }
+ * @param grid - Counts to add to (PLOT_GRID square if MNULL)
+ * @return MAT* - grid
+ */
+MAT *plot_density(const MAT *data, const double *lim, MAT *grid) {
+    double sx, sy;
+    size_t i;
+    long cx, cy, nx, ny;
+
+    if (!grid) grid = m_get(PLOT_GRID, PLOT_GRID);
+    nx = grid->n;
+    ny = grid->m;
+
+    sx = nx / (lim[1] - lim[0]);
+    sy = ny / (lim[3] - lim[2]);
+
+    for (i = 0; i < data->m; i += 1) {
+        cx = (long)((data->me[i][0] - lim[0]) * sx);
+        cy = (long)((data->me[i][data->n - 1] - lim[2]) * sy);
+        // max edge falls in the last cell
+        if (cx == nx) cx -= 1;
+        if (cy == ny) cy -= 1;
+        if (cx < 0 || cy < 0 || cx >= nx || cy >= ny) continue;
+        grid->me[cy][cx] += 1;
+    }
+
+    return grid;
+}
+
+/**
+ * @brief Data-file modifiers for a density grid sent with
+ * plot_rows and drawn "with image": one double per cell, cell
+ * centers spread over lim.
+ *
+ * @param buf - Output buffer
+ * @param len - Size of buf
+ * @param grid - Density grid (plot_density)
+ * @param lim - { xmin, xmax, ymin, ymax }
+ * @return char* - buf
+ */
+char *plot_imgspec(char *buf, size_t len, const MAT *grid, const double *lim) {
+    double dx = (lim[1] - lim[0]) / grid->n, dy = (lim[3] - lim[2]) / grid->m;
+
+    snprintf(buf, len, "binary array=(%u,%u) format='%%double' origin=(%.17g,%.17g) dx=%.17g dy=%.17g",
+             grid->n, grid->m, lim[0] + 0.5 * dx, lim[2] + 0.5 * dy, dx, dy);
+
+    return buf;
+}
@@ -0,0 +1,148 @@
+#include "pool.h"
+
+#include <unistd.h>
+
+typedef struct pool_arg_t {
+    pool_t *pool;
+    int w;
+} pool_arg_t;
+
+/**
+ * @brief Resolves a requested thread count; values < 1 mean
+ * one thread per online CPU.
+ */
+int pool_threads(int nthreads) {
+    long n;
+
+    if (nthreads > 0) return nthreads;
+
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (n > 0) ? (int)n : 1;
+}
+
+/**
+ * @brief Takes the next block off the front of worker w's
+ * own range.
+ */
+static int pool_pop(pool_t *p, int w, size_t *blk) {
+    pool_deque_t *q = &p->q[w];
+    int ok = 0;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->lo < q->hi) { *blk = q->lo++; ok = 1; }
+    pthread_mutex_unlock(&q->lock);
+
+    return ok;
+}
+
+/**
+ * @brief Steals the back half of the first non-empty range
+ * found among the other workers and makes it worker w's
+ * range. Ranges only ever shrink, so once every range is
+ * empty the run is done.
+ */
+static int pool_steal(pool_t *p, int w) {
+    pool_deque_t *v, *q = &p->q[w];
+    size_t mid;
+    int i;
+
+    for (i = 1; i < p->nthreads; i += 1) {
+        v = &p->q[(w + i) % p->nthreads];
+
+        pthread_mutex_lock(&v->lock);
+        if (v->lo < v->hi) {
+            mid = v->hi - (v->hi - v->lo + 1) / 2;
+
+            pthread_mutex_lock(&q->lock);
+            q->lo = mid; q->hi = v->hi;
+            pthread_mutex_unlock(&q->lock);
+
+            v->hi = mid;
+            pthread_mutex_unlock(&v->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&v->lock);
+    }
+
+    return 0;
+}
+
+static void *pool_worker(void *arg) {
+    pool_arg_t *a = (pool_arg_t*)arg;
+    pool_t *p = a->pool;
+    size_t blk;
+
+    do {
+        while (pool_pop(p, a->w, &blk)) p->fn(p->ctx, blk, a->w);
+    } while (pool_steal(p, a->w));
+
+    return NULL;
+}
+
+/**
+ * @brief Runs fn over blocks [0, nblk) on a work-stealing
+ * pool. Each worker starts on a contiguous share of the
+ * blocks and steals half of another worker's remainder when
+ * it runs dry. Block-to-worker assignment is not fixed, so
+ * fn must write results per block (or reduce them in an
+ * order-independent way) for deterministic output.
+ *
+ * @param nblk - Number of blocks
+ * @param nthreads - Worker count (< 1 for one per CPU)
+ * @param fn - Block callback
+ * @param ctx - Callback context
+ * @return int - Number of workers used
+ */
+int pool_run(size_t nblk, int nthreads, pool_fn fn, void *ctx) {
+    pthread_t *tid;
+    pool_arg_t *args;
+    pool_t p;
+    size_t b;
+    int w;
+
+    nthreads = pool_threads(nthreads);
+    if (nthreads > nblk) nthreads = (nblk > 0) ? (int)nblk : 1;
+
+    // not worth spinning up threads
+    if (nthreads == 1) {
+        for (b = 0; b < nblk; b += 1) fn(ctx, b, 0);
+        return 1;
+    }
+
+    p.nthreads = nthreads;
+    p.fn = fn;
+    p.ctx = ctx;
+    p.q = (pool_deque_t*) malloc(sizeof(pool_deque_t) * nthreads);
+    tid = (pthread_t*) malloc(sizeof(pthread_t) * nthreads);
+    args = (pool_arg_t*) malloc(sizeof(pool_arg_t) * nthreads);
+
+    for (w = 0; w < nthreads; w += 1) {
+        pthread_mutex_init(&p.q[w].lock, NULL);
+        p.q[w].lo = nblk * w / nthreads;
+        p.q[w].hi = nblk * (w + 1) / nthreads;
+        args[w].pool = &p;
+        args[w].w = w;
+    }
+
+    // worker 0 runs on the calling thread
+    for (w = 1; w < nthreads; w += 1) {
+        if (pthread_create(&tid[w], NULL, pool_worker, &args[w])) {
+            // its blocks get stolen by the running workers
+            fprintf(stderr, "Error. Failed to start pool worker %d.\n", w);
+            args[w].pool = NULL;
+        }
+    }
+
+    pool_worker(&args[0]);
+
+    for (w = 1; w < nthreads; w += 1) {
+        if (args[w].pool) pthread_join(tid[w], NULL);
+    }
+
+    for (w = 0; w < nthreads; w += 1) pthread_mutex_destroy(&p.q[w].lock);
+
+    free(p.q); free(tid); free(args);
+
+    return nthreads;
+}
@@ -0,0 +1,312 @@
+#include "rng.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RNG_X86 1
+#include <immintrin.h>
+#endif
+
+// keep mul + add separate so every kernel rounds alike
+#ifdef __GNUC__
+#define RNG_NOCONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define RNG_NOCONTRACT
+#endif
+
+typedef void (*bm_fn)(const double *, const double *, size_t, double *, double *);
+
+// ln 2 split so e * LN2_HI is exact
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+#define TWO_PI 6.28318530717958647693
+
+// 2 atanh(s) = 2s (1 + s^2 / 3 + s^4 / 5 + ...), s^2 < 0.03
+static const double log_c[] = {
+    1.0 / 3, 1.0 / 5, 1.0 / 7, 1.0 / 9, 1.0 / 11, 1.0 / 13,
+    1.0 / 15, 1.0 / 17, 1.0 / 19, 1.0 / 21, 1.0 / 23
+};
+#define LOG_N (sizeof(log_c) / sizeof(log_c[0]))
+
+// Taylor terms of sin / cos on [-pi/4, pi/4]
+static const double sin_c[] = {
+    -1.0 / 6, 1.0 / 120, -1.0 / 5040, 1.0 / 362880, -1.0 / 39916800,
+    1.0 / 6227020800.0, -1.0 / 1307674368000.0
+};
+static const double cos_c[] = {
+    -1.0 / 2, 1.0 / 24, -1.0 / 720, 1.0 / 40320, -1.0 / 3628800,
+    1.0 / 479001600, -1.0 / 87178291200.0, 1.0 / 20922789888000.0
+};
+#define SIN_N (sizeof(sin_c) / sizeof(sin_c[0]))
+#define COS_N (sizeof(cos_c) / sizeof(cos_c[0]))
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Seeds a stream; the 256-bit state is expanded from the
+ * 64-bit seed with splitmix64 (never all zero).
+ */
+void rng_seed(rng_t *r, uint64_t seed) {
+    int i;
+
+    for (i = 0; i < 4; i += 1) r->s[i] = splitmix64(&seed);
+}
+
+/**
+ * @brief Next 64 random bits (xoshiro256**).
+ */
+uint64_t rng_next(rng_t *r) {
+    uint64_t *s = r->s;
+    uint64_t x = rotl(s[1] * 5, 7) * 9, t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return x;
+}
+
+/**
+ * @brief Advances a stream by 2^128 draws. Streams split off by
+ * successive jumps never overlap in practice, which makes them
+ * the per-thread / per-block streams.
+ */
+void rng_jump(rng_t *r) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    uint64_t t[4] = { 0 };
+    int i, b;
+
+    for (i = 0; i < 4; i += 1) {
+        for (b = 0; b < 64; b += 1) {
+            if (jump[i] & (1ULL << b)) {
+                t[0] ^= r->s[0]; t[1] ^= r->s[1];
+                t[2] ^= r->s[2]; t[3] ^= r->s[3];
+            }
+            rng_next(r);
+        }
+    }
+
+    memcpy(r->s, t, sizeof(t));
+}
+
+/**
+ * @brief The calling thread's own stream: RNG_SEED jumped once
+ * per thread that asked before it.
+ */
+rng_t *rng_thread(void) {
+    static __thread rng_t r;
+    static __thread int init = 0;
+    static int nthreads = 0;
+    int k;
+
+    if (!init) {
+        rng_seed(&r, RNG_SEED);
+        for (k = __sync_fetch_and_add(&nthreads, 1); k > 0; k -= 1) rng_jump(&r);
+        init = 1;
+    }
+
+    return &r;
+}
+
+/**
+ * @brief Uniform double in (0, 1] from the top 53 bits (never 0,
+ * so safe under log).
+ */
+double rng_uniform(rng_t *r) {
+    return ((rng_next(r) >> 11) + 1) * 0x1.0p-53;
+}
+
+/**
+ * @brief Box-Muller over n pairs of uniforms in (0, 1]:
+ * c[i] = sqrt(-2 ln u1[i]) cos(2 pi u2[i]) and s[i] likewise
+ * with sin. The log and sin/cos are the polynomial forms the
+ * SIMD kernels evaluate, in the same order, so every kernel
+ * gives the same normals.
+ */
+RNG_NOCONTRACT
+static void bm_scalar(const double *u1, const double *u2, size_t n, double *c, double *s) {
+    double m, e, t, z, p, rad, q, f, sn, cs, tmp;
+    uint64_t bits;
+    size_t i;
+    int k;
+
+    for (i = 0; i < n; i += 1) {
+        // ln u1 = e ln 2 + ln m, m in [sqrt(1/2), sqrt(2))
+        memcpy(&bits, &u1[i], sizeof(bits));
+        e = (double)(bits >> 52) - 1023;
+        bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+        memcpy(&m, &bits, sizeof(m));
+        if (m > M_SQRT2) { m = m * 0.5; e = e + 1; }
+
+        t = (m - 1) / (m + 1);
+        z = t * t;
+        for (k = LOG_N - 1, p = log_c[k]; k > 0; k -= 1) p = log_c[k - 1] + z * p;
+        p = e * LN2_HI + ((t + t) + ((t + t) * z * p + e * LN2_LO));
+
+        rad = sqrt(-2 * p);
+
+        // 2 pi u2 = q pi / 2 + 2 pi f, |f| <= 1/8
+        q = nearbyint(4 * u2[i]);
+        f = u2[i] - 0.25 * q;
+        t = TWO_PI * f;
+        z = t * t;
+        for (k = SIN_N - 1, p = sin_c[k]; k > 0; k -= 1) p = sin_c[k - 1] + z * p;
+        sn = t + t * z * p;
+        for (k = COS_N - 1, p = cos_c[k]; k > 0; k -= 1) p = cos_c[k - 1] + z * p;
+        cs = 1 + z * p;
+
+        q = q - 4 * floor(q * 0.25);
+        if (q == 1 || q == 3) { tmp = cs; cs = sn; sn = tmp; }
+        if (q == 1 || q == 2) cs = -cs;
+        if (q == 2 || q == 3) sn = -sn;
+
+        c[i] = rad * cs;
+        s[i] = rad * sn;
+    }
+}
+
+#ifdef RNG_X86
+
+// target avx2 without fma: no contraction, same rounding as bm_scalar
+__attribute__((target("avx2")))
+static void bm_avx2(const double *u1, const double *u2, size_t n, double *c, double *s) {
+    const __m256i mant = _mm256_set1_epi64x(0x000fffffffffffffLL), one_b = _mm256_set1_epi64x(0x3ff0000000000000LL);
+    const __m256i magic_b = _mm256_set1_epi64x(0x4330000000000000LL);
+    const __m256d magic = _mm256_set1_pd(0x1.0p52), bias = _mm256_set1_pd(1023);
+    const __m256d one = _mm256_set1_pd(1), half = _mm256_set1_pd(0.5), sqrt2 = _mm256_set1_pd(M_SQRT2);
+    const __m256d ln2hi = _mm256_set1_pd(LN2_HI), ln2lo = _mm256_set1_pd(LN2_LO), m2 = _mm256_set1_pd(-2);
+    const __m256d four = _mm256_set1_pd(4), quarter = _mm256_set1_pd(0.25), twopi = _mm256_set1_pd(TWO_PI);
+    const __m256d sgn = _mm256_set1_pd(-0.0);
+    __m256d m, e, t, z, p, rad, q, f, sn, cs, big, odd, tmp;
+    __m256i bits;
+    size_t i;
+    int k;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        bits = _mm256_castpd_si256(_mm256_loadu_pd(u1 + i));
+        // biased exponent (0..2047) to double via the 2^52 trick
+        e = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic_b));
+        e = _mm256_sub_pd(_mm256_sub_pd(e, magic), bias);
+        m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mant), one_b));
+        big = _mm256_cmp_pd(m, sqrt2, _CMP_GT_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), big);
+        e = _mm256_blendv_pd(e, _mm256_add_pd(e, one), big);
+
+        t = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+        z = _mm256_mul_pd(t, t);
+        p = _mm256_set1_pd(log_c[LOG_N - 1]);
+        for (k = LOG_N - 1; k > 0; k -= 1) p = _mm256_add_pd(_mm256_set1_pd(log_c[k - 1]), _mm256_mul_pd(z, p));
+        tmp = _mm256_add_pd(t, t);
+        p = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(tmp, z), p), _mm256_mul_pd(e, ln2lo));
+        p = _mm256_add_pd(_mm256_mul_pd(e, ln2hi), _mm256_add_pd(tmp, p));
+
+        rad = _mm256_sqrt_pd(_mm256_mul_pd(m2, p));
+
+        f = _mm256_loadu_pd(u2 + i);
+        q = _mm256_round_pd(_mm256_mul_pd(four, f), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        f = _mm256_sub_pd(f, _mm256_mul_pd(quarter, q));
+        t = _mm256_mul_pd(twopi, f);
+        z = _mm256_mul_pd(t, t);
+        p = _mm256_set1_pd(sin_c[SIN_N - 1]);
+        for (k = SIN_N - 1; k > 0; k -= 1) p = _mm256_add_pd(_mm256_set1_pd(sin_c[k - 1]), _mm256_mul_pd(z, p));
+        sn = _mm256_add_pd(t, _mm256_mul_pd(_mm256_mul_pd(t, z), p));
+        p = _mm256_set1_pd(cos_c[COS_N - 1]);
+        for (k = COS_N - 1; k > 0; k -= 1) p = _mm256_add_pd(_mm256_set1_pd(cos_c[k - 1]), _mm256_mul_pd(z, p));
+        cs = _mm256_add_pd(one, _mm256_mul_pd(z, p));
+
+        // quadrant q mod 4 picks swap / sign of (cos, sin)
+        q = _mm256_sub_pd(q, _mm256_mul_pd(four, _mm256_floor_pd(_mm256_mul_pd(q, quarter))));
+        odd = _mm256_or_pd(_mm256_cmp_pd(q, one, _CMP_EQ_OQ), _mm256_cmp_pd(q, _mm256_set1_pd(3), _CMP_EQ_OQ));
+        tmp = cs;
+        cs = _mm256_blendv_pd(cs, sn, odd);
+        sn = _mm256_blendv_pd(sn, tmp, odd);
+        cs = _mm256_xor_pd(cs, _mm256_and_pd(sgn, _mm256_or_pd(_mm256_cmp_pd(q, one, _CMP_EQ_OQ), _mm256_cmp_pd(q, _mm256_set1_pd(2), _CMP_EQ_OQ))));
+        sn = _mm256_xor_pd(sn, _mm256_and_pd(sgn, _mm256_cmp_pd(q, _mm256_set1_pd(2), _CMP_GE_OQ)));
+
+        _mm256_storeu_pd(c + i, _mm256_mul_pd(rad, cs));
+        _mm256_storeu_pd(s + i, _mm256_mul_pd(rad, sn));
+    }
+
+    _mm256_zeroupper();
+    bm_scalar(u1 + i, u2 + i, n - i, c + i, s + i);
+}
+
+#endif // RNG_X86
+
+static pthread_once_t rng_once = PTHREAD_ONCE_INIT;
+static bm_fn bm;
+static const char *isa;
+
+static void rng_pick(void) {
+    const char *env = getenv(RNG_ISA_ENV);
+
+    isa = "scalar";
+    bm = bm_scalar;
+    if (env && !strcmp(env, "scalar")) return;
+
+#ifdef RNG_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        isa = "avx2";
+        bm = bm_avx2;
+    }
+#endif
+}
+
+// first use from any thread picks the kernel once
+static void rng_init(void) {
+    pthread_once(&rng_once, rng_pick);
+}
+
+const char *rng_isa(void) {
+    rng_init();
+    return isa;
+}
+
+/**
+ * @brief Fills out with n standard normals. Uniforms are drawn
+ * RNG_BLOCK at a time and transformed in one Box-Muller batch;
+ * both variates of every pair are used.
+ *
+ * @param r - Stream
+ * @param out - n normals
+ * @param n - Count
+ */
+void rng_normal(rng_t *r, double *out, size_t n) {
+    double u1[RNG_BLOCK / 2], u2[RNG_BLOCK / 2], z[RNG_BLOCK];
+    size_t i, l, h;
+
+    rng_init();
+
+    for (; n > 0; n -= l, out += l) {
+        l = (n < RNG_BLOCK) ? n : RNG_BLOCK;
+        h = (l + 1) / 2;
+
+        for (i = 0; i < h; i += 1) {
+            u1[i] = rng_uniform(r);
+            u2[i] = rng_uniform(r);
+        }
+
+        bm(u1, u2, h, z, z + h);
+        memcpy(out, z, sizeof(double) * l);
+    }
+}
@@ -0,0 +1,136 @@
+#include "roc.h"
+
+/**
+ * @brief Allocates an ROC accumulator over n uniformly
+ * spaced thresholds (start, start + step, ...). Scores
+ * are binned against the thresholds as they are added,
+ * so the whole curve is produced from a single pass over
+ * the samples regardless of n.
+ *
+ * @param n - Number of thresholds
+ * @param start - First (lowest) threshold
+ * @param step - Threshold spacing (> 0)
+ * @return roc_t* - New accumulator
+ */
+roc_t *roc_new(size_t n, double start, double step) {
+    roc_t *r = (roc_t*) malloc(sizeof(roc_t));
+    size_t i;
+
+    r->n = n;
+    r->start = start;
+    r->step = step;
+
+    r->thresh = (double*) malloc(sizeof(double) * n);
+    r->fpr = (double*) malloc(sizeof(double) * n);
+    r->fnr = (double*) malloc(sizeof(double) * n);
+    r->pos = (size_t*) malloc(sizeof(size_t) * (n + 1));
+    r->neg = (size_t*) malloc(sizeof(size_t) * (n + 1));
+
+    for (i = 0; i < n; i += 1) r->thresh[i] = start + i * step;
+
+    roc_reset(r);
+
+    return r;
+}
+
+void roc_free(roc_t *r) {
+    if (!r) return;
+
+    free(r->thresh);
+    free(r->fpr); free(r->fnr);
+    free(r->pos); free(r->neg);
+    free(r);
+}
+
+void roc_reset(roc_t *r) {
+    memset(r->pos, 0, sizeof(size_t) * (r->n + 1));
+    memset(r->neg, 0, sizeof(size_t) * (r->n + 1));
+    r->npos = 0; r->nneg = 0;
+    r->eer = 0;
+}
+
+/**
+ * @brief Number of thresholds a score meets (score >= t).
+ * Guesses the bin from the uniform spacing, then settles
+ * it against the stored thresholds so the result matches
+ * a direct comparison exactly.
+ *
+ * @param r - ROC accumulator
+ * @param score - Sample score
+ * @return size_t - Bin index in [0, n]
+ */
+size_t roc_bin(roc_t *r, double score) {
+    double f;
+    size_t b;
+
+    // no thresholds: everything lands in the single bin
+    if (!r->n || !(score >= r->thresh[0])) return 0;
+
+    f = (score - r->start) / r->step + 1;
+    b = (f >= r->n) ? r->n : (size_t)f;
+
+    while (b < r->n && score >= r->thresh[b]) b += 1;
+    while (b > 0 && score < r->thresh[b - 1]) b -= 1;
+
+    return b;
+}
+
+void roc_add(roc_t *r, double score, int truth) {
+    size_t b = roc_bin(r, score);
+
+    if (truth) { r->pos[b] += 1; r->npos += 1; }
+    else       { r->neg[b] += 1; r->nneg += 1; }
+}
+
+/**
+ * @brief Sweeps the binned counts once to produce the
+ * FPR/FNR at every threshold and locates the equal-error
+ * threshold (last minimum of |FPR - FNR|).
+ *
+ * @param r - ROC accumulator
+ * @return size_t - Index of equal-error threshold
+ */
+size_t roc_finish(roc_t *r) {
+    double fp, fn, tp, tn, err;
+    size_t i, lo_pos, lo_neg;
+
+    // samples in bins <= i fall below threshold i
+    for (i = 0, lo_pos = 0, lo_neg = 0, err = 999; i < r->n; i += 1) {
+        lo_pos += r->pos[i];
+        lo_neg += r->neg[i];
+
+        fn = lo_pos; tp = r->npos - lo_pos;
+        tn = lo_neg; fp = r->nneg - lo_neg;
+
+        r->fpr[i] = fp / (fp + tn);
+        r->fnr[i] = fn / (fn + tp);
+
+        if (fabs(r->fpr[i] - r->fnr[i]) <= err) {
+            r->eer = i;
+            err = fabs(r->fpr[i] - r->fnr[i]);
+        }
+    }
+
+    return r->eer;
+}
+
+/**
+ * @brief Builds the ROC curve dataset -> [ fn, fp, threshold ]
+ *
+ * @param r - Finished ROC accumulator
+ * @param out - Output matrix (resized to n x 3) or MNULL
+ * @return MAT* - ROC curve dataset
+ */
+MAT *roc_mat(roc_t *r, MAT *out) {
+    size_t i;
+
+    out = m_resize(out, r->n, 3);
+
+    for (i = 0; i < r->n; i += 1) {
+        m_set_val(out, i, 0, r->fnr[i]);
+        m_set_val(out, i, 1, r->fpr[i]);
+        m_set_val(out, i, 2, r->thresh[i]);
+    }
+
+    return out;
+}
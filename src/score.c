@@ -0,0 +1,447 @@
+#include "score.h"
+
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCORE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*quad2_fn)(const Real *, size_t, const double *, double, double, Real *);
+typedef void (*quad2m_fn)(const float *, const float *, size_t, const float *, double, double, Real *);
+
+/**
+ * @brief 2-D quadratic form over packed (ld == 2) rows:
+ * out[i] = offset + scale * (x_i - mu)' P (x_i - mu), where
+ * c = { mu0, mu1, p00, p10, p11 }. Evaluated in the same order
+ * as gauss_maha.
+ */
+static void quad2_scalar(const Real *x, size_t n, const double *c, double scale, double offset, Real *out) {
+    double d0, d1, q;
+    size_t i;
+
+    for (i = 0; i < n; i += 1, x += 2) {
+        d0 = x[0] - c[0];
+        d1 = x[1] - c[1];
+        q = d0 * (c[2] * d0);
+        q += d1 * (c[4] * d1 + 2 * (c[3] * d0));
+        out[i] = offset + scale * q;
+    }
+}
+
+/**
+ * @brief 2-D quadratic form over float32 feature planes
+ * (structure of arrays), c as for quad2_scalar. The distance is
+ * computed in float, scale and offset are applied in double.
+ */
+static void quad2m_scalar(const float *x0, const float *x1, size_t n, const float *c, double scale, double offset, Real *out) {
+    float d0, d1, q;
+    size_t i;
+
+    for (i = 0; i < n; i += 1) {
+        d0 = x0[i] - c[0];
+        d1 = x1[i] - c[1];
+        q = d0 * (c[2] * d0);
+        q += d1 * (c[4] * d1 + 2 * (c[3] * d0));
+        out[i] = offset + scale * (double)q;
+    }
+}
+
+#ifdef SCORE_X86
+
+__attribute__((target("sse2")))
+static void quad2_sse2(const Real *x, size_t n, const double *c, double scale, double offset, Real *out) {
+    __m128d m0 = _mm_set1_pd(c[0]), m1 = _mm_set1_pd(c[1]);
+    __m128d p00 = _mm_set1_pd(c[2]), p10 = _mm_set1_pd(c[3]), p11 = _mm_set1_pd(c[4]);
+    __m128d two = _mm_set1_pd(2), sc = _mm_set1_pd(scale), of = _mm_set1_pd(offset);
+    __m128d a, b, d0, d1, q;
+    size_t i;
+
+    for (i = 0; i + 2 <= n; i += 2, x += 4) {
+        a = _mm_loadu_pd(x);            // x0 y0
+        b = _mm_loadu_pd(x + 2);        // x1 y1
+        d0 = _mm_sub_pd(_mm_unpacklo_pd(a, b), m0);
+        d1 = _mm_sub_pd(_mm_unpackhi_pd(a, b), m1);
+
+        q = _mm_mul_pd(d0, _mm_mul_pd(p00, d0));
+        q = _mm_add_pd(q, _mm_mul_pd(d1, _mm_add_pd(_mm_mul_pd(p11, d1), _mm_mul_pd(two, _mm_mul_pd(p10, d0)))));
+        _mm_storeu_pd(out + i, _mm_add_pd(of, _mm_mul_pd(sc, q)));
+    }
+
+    quad2_scalar(x, n - i, c, scale, offset, out + i);
+}
+
+__attribute__((target("avx2,fma")))
+static void quad2_avx2(const Real *x, size_t n, const double *c, double scale, double offset, Real *out) {
+    __m256d m0 = _mm256_set1_pd(c[0]), m1 = _mm256_set1_pd(c[1]);
+    __m256d p00 = _mm256_set1_pd(c[2]), p10 = _mm256_set1_pd(c[3]), p11 = _mm256_set1_pd(c[4]);
+    __m256d two = _mm256_set1_pd(2), sc = _mm256_set1_pd(scale), of = _mm256_set1_pd(offset);
+    __m256d a, b, d0, d1, q;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4, x += 8) {
+        a = _mm256_loadu_pd(x);         // x0 y0 x1 y1
+        b = _mm256_loadu_pd(x + 4);     // x2 y2 x3 y3
+        // unpack gives lanes in 0 2 1 3 order, permute back
+        d0 = _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        d1 = _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        d0 = _mm256_sub_pd(d0, m0);
+        d1 = _mm256_sub_pd(d1, m1);
+
+        q = _mm256_mul_pd(d0, _mm256_mul_pd(p00, d0));
+        q = _mm256_fmadd_pd(d1, _mm256_fmadd_pd(p11, d1, _mm256_mul_pd(two, _mm256_mul_pd(p10, d0))), q);
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(sc, q, of));
+    }
+
+    // avoid AVX -> SSE transition stalls in the caller (libm etc.)
+    _mm256_zeroupper();
+    quad2_scalar(x, n - i, c, scale, offset, out + i);
+}
+
+__attribute__((target("avx512f")))
+static void quad2_avx512(const Real *x, size_t n, const double *c, double scale, double offset, Real *out) {
+    __m512d m0 = _mm512_set1_pd(c[0]), m1 = _mm512_set1_pd(c[1]);
+    __m512d p00 = _mm512_set1_pd(c[2]), p10 = _mm512_set1_pd(c[3]), p11 = _mm512_set1_pd(c[4]);
+    __m512d two = _mm512_set1_pd(2), sc = _mm512_set1_pd(scale), of = _mm512_set1_pd(offset);
+    __m512i ev = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    __m512i od = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    __m512d a, b, d0, d1, q;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8, x += 16) {
+        a = _mm512_loadu_pd(x);
+        b = _mm512_loadu_pd(x + 8);
+        d0 = _mm512_sub_pd(_mm512_permutex2var_pd(a, ev, b), m0);
+        d1 = _mm512_sub_pd(_mm512_permutex2var_pd(a, od, b), m1);
+
+        q = _mm512_mul_pd(d0, _mm512_mul_pd(p00, d0));
+        q = _mm512_fmadd_pd(d1, _mm512_fmadd_pd(p11, d1, _mm512_mul_pd(two, _mm512_mul_pd(p10, d0))), q);
+        _mm512_storeu_pd(out + i, _mm512_fmadd_pd(sc, q, of));
+    }
+
+    _mm256_zeroupper();
+    quad2_scalar(x, n - i, c, scale, offset, out + i);
+}
+
+__attribute__((target("avx2,fma")))
+static void quad2m_avx2(const float *x0, const float *x1, size_t n, const float *c, double scale, double offset, Real *out) {
+    __m256 m0 = _mm256_set1_ps(c[0]), m1 = _mm256_set1_ps(c[1]);
+    __m256 p00 = _mm256_set1_ps(c[2]), p10 = _mm256_set1_ps(c[3]), p11 = _mm256_set1_ps(c[4]);
+    __m256 two = _mm256_set1_ps(2);
+    __m256d sc = _mm256_set1_pd(scale), of = _mm256_set1_pd(offset);
+    __m256 d0, d1, q;
+    size_t i;
+
+    // 8 distances in float, widened to two double halves
+    for (i = 0; i + 8 <= n; i += 8) {
+        d0 = _mm256_sub_ps(_mm256_loadu_ps(x0 + i), m0);
+        d1 = _mm256_sub_ps(_mm256_loadu_ps(x1 + i), m1);
+
+        q = _mm256_mul_ps(d0, _mm256_mul_ps(p00, d0));
+        q = _mm256_fmadd_ps(d1, _mm256_fmadd_ps(p11, d1, _mm256_mul_ps(two, _mm256_mul_ps(p10, d0))), q);
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(sc, _mm256_cvtps_pd(_mm256_castps256_ps128(q)), of));
+        _mm256_storeu_pd(out + i + 4, _mm256_fmadd_pd(sc, _mm256_cvtps_pd(_mm256_extractf128_ps(q, 1)), of));
+    }
+
+    _mm256_zeroupper();
+    quad2m_scalar(x0 + i, x1 + i, n - i, c, scale, offset, out + i);
+}
+
+__attribute__((target("avx512f")))
+static void quad2m_avx512(const float *x0, const float *x1, size_t n, const float *c, double scale, double offset, Real *out) {
+    __m512 m0 = _mm512_set1_ps(c[0]), m1 = _mm512_set1_ps(c[1]);
+    __m512 p00 = _mm512_set1_ps(c[2]), p10 = _mm512_set1_ps(c[3]), p11 = _mm512_set1_ps(c[4]);
+    __m512 two = _mm512_set1_ps(2);
+    __m512d sc = _mm512_set1_pd(scale), of = _mm512_set1_pd(offset);
+    __m512 d0, d1, q;
+    __m256 h;
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        d0 = _mm512_sub_ps(_mm512_loadu_ps(x0 + i), m0);
+        d1 = _mm512_sub_ps(_mm512_loadu_ps(x1 + i), m1);
+
+        q = _mm512_mul_ps(d0, _mm512_mul_ps(p00, d0));
+        q = _mm512_fmadd_ps(d1, _mm512_fmadd_ps(p11, d1, _mm512_mul_ps(two, _mm512_mul_ps(p10, d0))), q);
+        _mm512_storeu_pd(out + i, _mm512_fmadd_pd(sc, _mm512_cvtps_pd(_mm512_castps512_ps256(q)), of));
+        // upper 8 floats via the 64-bit extract (AVX-512F only)
+        h = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(q), 1));
+        _mm512_storeu_pd(out + i + 8, _mm512_fmadd_pd(sc, _mm512_cvtps_pd(h), of));
+    }
+
+    _mm256_zeroupper();
+    quad2m_scalar(x0 + i, x1 + i, n - i, c, scale, offset, out + i);
+}
+
+#endif // SCORE_X86
+
+static quad2m_fn quad2m;
+static quad2_fn quad2;
+static const char *quad2_isa;
+static pthread_once_t score_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Picks the widest 2-D kernel the running CPU supports.
+ * Runs once under score_once, so pool workers that reach the
+ * kernels first all see the same complete choice.
+ */
+static void score_pick(void) {
+    quad2_isa = "scalar";
+    quad2m = quad2m_scalar;
+    quad2 = quad2_scalar;
+
+#ifdef SCORE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        quad2_isa = "avx512"; quad2m = quad2m_avx512; quad2 = quad2_avx512;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        quad2_isa = "avx2"; quad2m = quad2m_avx2; quad2 = quad2_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        quad2_isa = "sse2"; quad2 = quad2_sse2;
+    }
+#endif
+}
+
+static void score_init(void) {
+    pthread_once(&score_once, score_pick);
+}
+
+const char *score_isa(void) {
+    score_init();
+    return quad2_isa;
+}
+
+/**
+ * @brief Whether rows [lo, lo + n) of a MAT sit back-to-back
+ * in memory (row i at me[lo] + (i - lo) * x->n), i.e. usable
+ * as a raw row-major buffer with ld == x->n.
+ */
+int mat_contig(const MAT *x, size_t lo, size_t n) {
+    size_t i;
+
+    for (i = 1; i < n; i += 1) {
+        if (x->me[lo + i] != x->me[lo] + i * x->n) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Batched quadratic form over n row-major rows
+ * (row stride ld): out[i] = offset + scale * maha(x_i).
+ * 2-D rows go through the SIMD kernels, other rows up to
+ * FX_MAX_D through the fixed-dimension kernels, anything else
+ * through gauss_maha.
+ *
+ * @param m - Compiled model
+ * @param x - First row
+ * @param n - Number of rows
+ * @param ld - Row stride (elements)
+ * @param scale - Multiplier on the Mahalanobis distance
+ * @param offset - Added constant
+ * @param out - n scores
+ */
+void gauss_quad_batch(const gauss_model_t *m, const Real *x, size_t n, size_t ld, double scale, double offset, Real *out) {
+    double c[5];
+    size_t i;
+
+    score_init();
+
+    if (m->d == 2) {
+        c[0] = m->mu->ve[0]; c[1] = m->mu->ve[1];
+        c[2] = m->prec->me[0][0]; c[3] = m->prec->me[1][0]; c[4] = m->prec->me[1][1];
+
+        if (ld == 2) {
+            quad2(x, n, c, scale, offset, out);
+        } else {
+            for (i = 0; i < n; i += 1) quad2_scalar(x + i * ld, 1, c, scale, offset, out + i);
+        }
+    } else if (fx_has(m->d)) {
+        fx_quad(m->d, m->mu->ve, m->prec->me, x, n, ld, scale, offset, out);
+    } else {
+        for (i = 0; i < n; i += 1) out[i] = offset + scale * gauss_maha(m, x + i * ld);
+    }
+}
+
+void gauss_logeval_batch(const gauss_model_t *m, const Real *x, size_t n, size_t ld, Real *out) {
+    gauss_quad_batch(m, x, n, ld, -0.5, m->lognorm, out);
+}
+
+/**
+ * @brief Batched 2-D quadratic form over float32 feature planes
+ * as produced by feat_rg_f32 / feat_ycbcr_f32, in mixed precision:
+ * out[i] = offset + scale * maha(x0[i], x1[i]), with float
+ * arithmetic for the distance (full SIMD width) and double
+ * for scale, offset and the result. The log-normalizer can be
+ * large next to the distance, so adding it in float would cost
+ * the small likelihoods most of their digits.
+ *
+ * @param m - Compiled 2-D model
+ * @param x0 - First feature plane
+ * @param x1 - Second feature plane
+ * @param n - Number of rows
+ * @param scale - Multiplier on the Mahalanobis distance
+ * @param offset - Added constant
+ * @param out - n scores
+ */
+void gauss_quad_soa2m(const gauss_model_t *m, const float *x0, const float *x1, size_t n, double scale, double offset, Real *out) {
+    float c[5];
+
+    if (m->d != 2) error(E_SIZES, "gauss_quad_soa2m");
+
+    score_init();
+
+    c[0] = m->mu->ve[0]; c[1] = m->mu->ve[1];
+    c[2] = m->prec->me[0][0]; c[3] = m->prec->me[1][0]; c[4] = m->prec->me[1][1];
+
+    quad2m(x0, x1, n, c, scale, offset, out);
+}
+
+void gauss_logeval_soa2m(const gauss_model_t *m, const float *x0, const float *x1, size_t n, Real *out) {
+    gauss_quad_soa2m(m, x0, x1, n, -0.5, m->lognorm, out);
+}
+
+/**
+ * @brief Log-likelihood of rows [lo, lo + n) of a feature matrix.
+ *
+ * @param m - Compiled model
+ * @param x - Feature matrix (one sample per row)
+ * @param lo - First row
+ * @param n - Number of rows
+ * @param out - n log-likelihoods
+ */
+void gauss_logeval_rows(const gauss_model_t *m, const MAT *x, size_t lo, size_t n, Real *out) {
+    size_t i;
+
+    if (mat_contig(x, lo, n)) {
+        gauss_logeval_batch(m, x->me[lo], n, x->n, out);
+    } else {
+        for (i = 0; i < n; i += 1) gauss_logeval_batch(m, x->me[lo + i], 1, x->n, out + i);
+    }
+}
+
+VEC *gauss_logeval_mat(const gauss_model_t *m, const MAT *x, VEC *out) {
+    out = v_resize(out, x->m);
+    gauss_logeval_rows(m, x, 0, x->m, out->ve);
+
+    return out;
+}
+
+/**
+ * @brief Batched compiled discriminant over n row-major rows
+ * (row stride ld). 2-D rows use the expanded quadratic
+ * x0 (a x0 + b x1 + d) + x1 (c x1 + e) + f: five multiplies per
+ * sample (rounding differs from disc_eval in the last bit). Other
+ * dimensions up to FX_MAX_D run the fixed-dimension kernel (fully
+ * unrolled, coefficients held in registers).
+ *
+ * @param k - Compiled discriminant (disc_compile / disc_sub)
+ * @param x - First row
+ * @param n - Number of rows
+ * @param ld - Row stride (elements)
+ * @param out - n scores
+ */
+void disc_eval_batch(const disc_t *k, const Real *x, size_t n, size_t ld, Real *out) {
+    double a, b, c, d, e, f;
+    size_t i;
+
+    if (k->d == 2) {
+        a = k->quad ? k->W->me[0][0] : 0;
+        b = k->quad ? 2 * k->W->me[1][0] : 0;
+        c = k->quad ? k->W->me[1][1] : 0;
+        d = k->w->ve[0];
+        e = k->w->ve[1];
+        f = k->w0;
+        for (i = 0; i < n; i += 1, x += ld) out[i] = x[0] * (a * x[0] + b * x[1] + d) + x[1] * (c * x[1] + e) + f;
+    } else if (fx_has(k->d)) {
+        fx_disc(k->d, k->W->me, k->w->ve, k->w0, k->quad, x, n, ld, out);
+    } else {
+        for (i = 0; i < n; i += 1) out[i] = disc_eval(k, x + i * ld);
+    }
+}
+
+void disc_eval_rows(const disc_t *k, const MAT *x, size_t lo, size_t n, Real *out) {
+    size_t i;
+
+    if (mat_contig(x, lo, n)) {
+        disc_eval_batch(k, x->me[lo], n, x->n, out);
+    } else {
+        for (i = 0; i < n; i += 1) out[i] = disc_eval(k, x->me[lo + i]);
+    }
+}
+
+// per-thread scratch arena of disc_batch, freed at thread exit
+static __thread MEM_ARENA *disc_arena = NULL;
+static pthread_once_t disc_once = PTHREAD_ONCE_INIT;
+static pthread_key_t disc_key;
+
+static void disc_arena_exit(void *a) {
+    mem_arena_free((MEM_ARENA*)a);
+}
+
+static void disc_key_init(void) {
+    pthread_key_create(&disc_key, disc_arena_exit);
+}
+
+static MEM_ARENA *disc_scratch(void) {
+    if (!disc_arena) {
+        disc_arena = mem_arena_get(0);
+        pthread_once(&disc_once, disc_key_init);
+        pthread_setspecific(disc_key, disc_arena);
+    }
+
+    return disc_arena;
+}
+
+/**
+ * @brief Discriminant scores of n row-major rows against
+ * one class. g is called per row on a VEC that borrows the
+ * row in place, with its Meschach temporaries drawn from the
+ * thread's scratch arena and released after every row (so it
+ * must not keep static workspace between calls). c->model is
+ * not consulted: compiled scoring goes through disc_tab_compile
+ * and disc_eval_batch, which the caller recompiles.
+ *
+ * @param g - Discriminant
+ * @param c - Class/Category distribution
+ * @param x - First row
+ * @param n - Number of rows
+ * @param ld - Row stride (elements)
+ * @param out - n scores
+ */
+void disc_batch(Disc g, gauss_t *c, const Real *x, size_t n, size_t ld, Real *out) {
+    MEM_ARENA *a, *prev;
+    MEM_MARK mk;
+    VEC row;
+    size_t i;
+
+    a = disc_scratch();
+    prev = mem_arena_use(a);
+    mk = mem_arena_mark(a);
+
+    row.dim = row.max_dim = c->mu->dim;
+    for (i = 0; i < n; i += 1) {
+        row.ve = (Real*)(x + i * ld);
+        out[i] = g(&row, c);
+        mem_arena_release(a, mk);
+    }
+
+    mem_arena_use(prev);
+}
+
+void disc_rows(Disc g, gauss_t *c, const MAT *x, size_t lo, size_t n, Real *out) {
+    size_t i;
+
+    if (mat_contig(x, lo, n)) {
+        disc_batch(g, c, x->me[lo], n, x->n, out);
+    } else {
+        for (i = 0; i < n; i += 1) disc_batch(g, c, x->me[lo + i], 1, x->n, out + i);
+    }
+}
+
+VEC *disc_mat(Disc g, gauss_t *c, const MAT *x, VEC *out) {
+    out = v_resize(out, x->m);
+    disc_rows(g, c, x, 0, x->m, out->ve);
+
+    return out;
+}
@@ -0,0 +1,277 @@
+#include "stats.h"
+
+moments_t *mom_get(int d) {
+    moments_t *s = (moments_t*) malloc(sizeof(moments_t));
+
+    s->d = d;
+    s->n = 0;
+    s->mean = v_get(d);
+    s->m2 = m_get(d, d);
+
+    return s;
+}
+
+void mom_free(moments_t *s) {
+    if (!s) return;
+
+    v_free(s->mean);
+    m_free(s->m2);
+    free(s);
+}
+
+void mom_reset(moments_t *s) {
+    s->n = 0;
+    v_zero(s->mean);
+    m_zero(s->m2);
+}
+
+moments_t *mom_copy(const moments_t *s, moments_t *out) {
+    if (!out) out = mom_get(s->d);
+
+    out->n = s->n;
+    out->d = s->d;
+    v_copy(s->mean, out->mean);
+    m_copy(s->m2, out->m2);
+
+    return out;
+}
+
+/**
+ * @brief Welford update with one sample:
+ * mean += (x - mean) / n, M2 += (x - mean_old)(x - mean_new)'.
+ *
+ * @param s - Accumulator
+ * @param x - Sample (s->d contiguous values)
+ */
+void mom_add(moments_t *s, const Real *x) {
+    Real *mu = s->mean->ve, **m2 = s->m2->me;
+    Real delta[s->d];
+    double inv;
+    int i, k;
+
+    s->n += 1;
+    inv = 1.0 / s->n;
+
+    for (i = 0; i < s->d; i += 1) {
+        delta[i] = x[i] - mu[i];
+        mu[i] += delta[i] * inv;
+    }
+
+    for (i = 0; i < s->d; i += 1) {
+        for (k = 0; k <= i; k += 1) m2[i][k] += delta[i] * (x[k] - mu[k]);
+    }
+}
+
+/**
+ * @brief Accumulates rows [lo, lo + n) of a data matrix in
+ * place (no copy of the rows).
+ */
+void mom_add_rows(moments_t *s, const MAT *data, size_t lo, size_t n) {
+    mom_add_view(s, view_rows(view_mat(data), lo, n));
+}
+
+/**
+ * @brief Accumulates every row of a view (one sample per row,
+ * v.n == s->d). Rows are read in place when columns are unit
+ * stride and gathered otherwise (transposes).
+ */
+void mom_add_view(moments_t *s, view_t v) {
+    Real x[s->d];
+    size_t i, j;
+
+    if (v.cs == 1 && fx_has(s->d)) {
+        fx_mom(s->d, v.data, v.m, v.rs, &s->n, s->mean->ve, s->m2->me);
+        return;
+    }
+
+    for (i = 0; i < v.m; i += 1) {
+        if (v.cs == 1) {
+            mom_add(s, view_row(v, i));
+        } else {
+            for (j = 0; j < v.n; j += 1) x[j] = view_at(v, i, j);
+            mom_add(s, x);
+        }
+    }
+}
+
+/**
+ * @brief Folds accumulator b into a (Chan et al. pairwise
+ * combine). Gives the same moments as accumulating b's samples
+ * into a directly, up to rounding.
+ *
+ * @param a - Accumulator, updated
+ * @param b - Accumulator to merge
+ * @return moments_t* - a
+ */
+moments_t *mom_merge(moments_t *a, const moments_t *b) {
+    Real *mu = a->mean->ve, **m2 = a->m2->me;
+    Real delta[a->d];
+    double n, f;
+    int i, k;
+
+    if (b->n == 0) return a;
+    if (a->n == 0) return mom_copy(b, a);
+
+    n = (double)a->n + b->n;
+    f = (double)a->n * b->n / n;
+
+    for (i = 0; i < a->d; i += 1) {
+        delta[i] = b->mean->ve[i] - mu[i];
+        mu[i] += delta[i] * (b->n / n);
+    }
+
+    for (i = 0; i < a->d; i += 1) {
+        for (k = 0; k <= i; k += 1) m2[i][k] += b->m2->me[i][k] + delta[i] * delta[k] * f;
+    }
+
+    a->n += b->n;
+
+    return a;
+}
+
+typedef struct mom_ctx_t {
+    view_t v;
+    size_t *cut;        // segment boundaries (mom_prefix)
+    moments_t **part;
+} mom_ctx_t;
+
+static void mom_block(void *arg, size_t blk, int w) {
+    mom_ctx_t *ctx = (mom_ctx_t*)arg;
+    size_t lo = blk * MOM_BLOCK;
+    size_t l = (ctx->v.m - lo < MOM_BLOCK) ? ctx->v.m - lo : MOM_BLOCK;
+
+    mom_add_view(ctx->part[blk], view_rows(ctx->v, lo, l));
+}
+
+static void mom_segment(void *arg, size_t seg, int w) {
+    mom_ctx_t *ctx = (mom_ctx_t*)arg;
+
+    mom_add_view(ctx->part[seg], view_rows(ctx->v, ctx->cut[seg], ctx->cut[seg + 1] - ctx->cut[seg]));
+}
+
+static int size_cmp(const void *a, const void *b) {
+    size_t l = *(const size_t*)a, r = *(const size_t*)b;
+
+    return (l > r) - (l < r);
+}
+
+/**
+ * @brief Moments of several prefixes (first lens[j] rows) of a
+ * data matrix from a single pass. The rows are cut into segments
+ * at every MOM_BLOCK multiple and every requested length, the
+ * segments are accumulated on the thread pool, and a running
+ * merge in row order is checkpointed into out[j] as it reaches
+ * lens[j]. lens need not be sorted.
+ *
+ * @param data - Data matrix
+ * @param lens - Prefix lengths (each <= data->m)
+ * @param k - Number of prefixes
+ * @param nthreads - Worker count (< 1 for one per CPU)
+ * @param out - k accumulators, allocated where NULL
+ */
+void mom_prefix(const MAT *data, const size_t *lens, size_t k, int nthreads, moments_t **out) {
+    moments_t *run;
+    mom_ctx_t ctx;
+    size_t i, j, b, nc, max;
+
+    for (j = 0, max = 0; j < k; j += 1) if (lens[j] > max) max = lens[j];
+
+    // segment boundaries: 0, block multiples and prefix lengths
+    ctx.cut = (size_t*) malloc(sizeof(size_t) * (max / MOM_BLOCK + k + 2));
+    for (b = 0, nc = 0; b < max; b += MOM_BLOCK) ctx.cut[nc++] = b;
+    for (j = 0; j < k; j += 1) ctx.cut[nc++] = lens[j];
+    ctx.cut[nc++] = max;
+
+    qsort(ctx.cut, nc, sizeof(size_t), size_cmp);
+    for (i = 1, b = 1; i < nc; i += 1) {
+        if (ctx.cut[i] != ctx.cut[b - 1]) ctx.cut[b++] = ctx.cut[i];
+    }
+    nc = b;
+
+    ctx.v = view_mat(data);
+    ctx.part = (moments_t**) malloc(sizeof(moments_t*) * nc);
+    for (i = 0; i + 1 < nc; i += 1) ctx.part[i] = mom_get(data->n);
+
+    pool_run(nc - 1, nthreads, mom_segment, &ctx);
+
+    run = mom_get(data->n);
+    for (i = 0; i < nc; i += 1) {
+        if (i) {
+            mom_merge(run, ctx.part[i - 1]);
+            mom_free(ctx.part[i - 1]);
+        }
+
+        // checkpoint every prefix ending here
+        for (j = 0; j < k; j += 1) {
+            if (lens[j] == ctx.cut[i]) out[j] = mom_copy(run, out[j]);
+        }
+    }
+
+    mom_free(run);
+    free(ctx.part);
+    free(ctx.cut);
+}
+
+/**
+ * @brief Moments of rows [lo, lo + n) computed as MOM_BLOCK
+ * partial accumulators on the thread pool, merged in block
+ * order so the result does not depend on the thread count.
+ *
+ * @param data - Data matrix
+ * @param lo - First row
+ * @param n - Number of rows
+ * @param nthreads - Worker count (< 1 for one per CPU)
+ * @param out - Accumulator to fill (reset first) or NULL
+ * @return moments_t* - Accumulated moments
+ */
+moments_t *mom_rows_par(const MAT *data, size_t lo, size_t n, int nthreads, moments_t *out) {
+    return mom_view_par(view_rows(view_mat(data), lo, n), nthreads, out);
+}
+
+/**
+ * @brief As mom_rows_par over the rows of a view.
+ */
+moments_t *mom_view_par(view_t v, int nthreads, moments_t *out) {
+    mom_ctx_t ctx;
+    size_t b, nblk;
+
+    if (!out) out = mom_get(v.n);
+    mom_reset(out);
+
+    nblk = (v.m + MOM_BLOCK - 1) / MOM_BLOCK;
+
+    ctx.v = v;
+    ctx.part = (moments_t**) malloc(sizeof(moments_t*) * nblk);
+    for (b = 0; b < nblk; b += 1) ctx.part[b] = mom_get(v.n);
+
+    pool_run(nblk, nthreads, mom_block, &ctx);
+
+    for (b = 0; b < nblk; b += 1) {
+        mom_merge(out, ctx.part[b]);
+        mom_free(ctx.part[b]);
+    }
+    free(ctx.part);
+
+    return out;
+}
+
+VEC *mom_mean(const moments_t *s, VEC *out) {
+    return v_copy(s->mean, out);
+}
+
+/**
+ * @brief Unbiased sample covariance M2 / (n - 1).
+ */
+MAT *mom_cov(const moments_t *s, MAT *out) {
+    int i, k;
+
+    out = m_resize(out, s->d, s->d);
+
+    for (i = 0; i < s->d; i += 1) {
+        for (k = 0; k <= i; k += 1) {
+            out->me[i][k] = out->me[k][i] = s->m2->me[i][k] / (s->n - 1.0);
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,162 @@
+#include "stream.h"
+
+static FILE *stream_open(const char *fname, const char *mode) {
+    char fpath[MAX_FPATH];
+
+    snprintf(fpath, MAX_FPATH, "%s%s", IMAGE_DIR, fname);
+
+    return fopen(fpath, mode);
+}
+
+/**
+ * @brief Runs skin detection over a PPM one band of rows at a
+ * time: each band is read, converted to RG/YCbCr features,
+ * scored, thresholded, checked against the matching reference
+ * band and written out before the next band is read. Peak memory
+ * is a few band-sized buffers whatever the image size. With
+ * st->lut set, pixels are scored by table lookup and no
+ * features are computed; otherwise features are built in
+ * st->prec (PREC_F32 gives float32 planes scored in mixed
+ * precision).
+ *
+ * @param color - Skin color distribution (unused with st->lut)
+ * @param st - Stream configuration; receives detection stats
+ * @return int - 0 on success, 1 on error
+ */
+int face_stream(gauss_t *color, stream_t *st) {
+    FILE *fi = NULL, *fr = NULL, *fo = NULL;
+    uint8_t *ibuf = NULL, *rbuf = NULL, *obuf = NULL;
+    Image in, ref, band;
+    feats_t *feat = NULL, *ff;
+    Real *lik = NULL;
+    size_t nb, rows, r, i, j, k, l, s, p, e, rowsz, px = 0, io = 0;
+    trace_t t = trace_begin("face_stream");
+    double v;
+    int ret = 1;
+
+    if (!st->lut && !gauss_compile(color)) {
+        fprintf(stderr, "Error. Color covariance is not positive definite.\n");
+        goto done;
+    }
+
+    st->fp = 0; st->fn = 0; st->tp = 0; st->tn = 0;
+    nb = st->band ? st->band : STREAM_BAND;
+
+    if (!(fi = stream_open(st->ifname, "rb")) || load_header(fi, &in)) {
+        fprintf(stderr, "Error opening '%s'.\n", st->ifname);
+        goto done;
+    }
+    if (in.size != (size_t)in.m * in.n * 3) {
+        fprintf(stderr, "Error. '%s' is not an RGB image.\n", st->ifname);
+        goto done;
+    }
+
+    if (st->rfname) {
+        if (!(fr = stream_open(st->rfname, "rb")) || load_header(fr, &ref)) {
+            fprintf(stderr, "Error opening '%s'.\n", st->rfname);
+            goto done;
+        }
+        if (ref.m != in.m || ref.n != in.n || ref.size != in.size) {
+            fprintf(stderr, "Error. '%s' does not match '%s'.\n", st->rfname, st->ifname);
+            goto done;
+        }
+    }
+
+    if (st->ofname) {
+        if (!(fo = stream_open(st->ofname, "wb"))) {
+            fprintf(stderr, "Error opening destination file '%s'.\n", st->ofname);
+            goto done;
+        }
+        fprintf(fo, "P6\n%" PRIu32 " %" PRIu32 "\n%d\n", in.m, in.n, in.q);
+    }
+
+    rowsz = (size_t)in.m * 3;
+    ibuf = (uint8_t*) malloc(nb * rowsz);
+    obuf = (uint8_t*) malloc(nb * rowsz);
+    if (fr) rbuf = (uint8_t*) malloc(nb * rowsz);
+    lik = (Real*) malloc(sizeof(Real) * nb * in.m);
+
+    // band images borrow the band buffer
+    band.m = in.m;
+    band.q = in.q;
+    band.data = ibuf;
+    band.mode = IMAGE_BORROWED;
+    band.map = NULL;
+    band.map_size = 0;
+
+    for (r = 0; r < in.n; r += rows) {
+        rows = (in.n - r < nb) ? in.n - r : nb;
+        band.n = rows;
+        band.size = rows * rowsz;
+
+        if (fread(ibuf, 1, band.size, fi) != band.size || (fr && fread(rbuf, 1, band.size, fr) != band.size)) {
+            fprintf(stderr, "Error. Image data ends before row %llu.\n", (unsigned long long)r);
+            goto done;
+        }
+
+        if (st->lut) {
+            for (j = 0, i = 0; i < band.size; j += 1, i += 3) {
+                lik[j] = st->lut->lik[lut_cell(st->lut, ibuf + i)];
+            }
+        } else {
+            if (!(ff = feats_image(&band, st->rg, st->prec, feat))) {
+                fprintf(stderr, "Error. Out of memory for the features of row %llu.\n", (unsigned long long)r);
+                goto done;
+            }
+            feat = ff;
+
+            for (k = 0; k < feat->n; k += l) {
+                l = (feat->n - k < SCORE_BLOCK) ? feat->n - k : SCORE_BLOCK;
+                feats_logeval(color->model, feat, k, l, lik + k);
+            }
+            for (j = 0; j < feat->n; j += 1) lik[j] = exp(lik[j]);
+        }
+
+        memset(obuf, 0, band.size);
+
+        for (j = 0, i = 0; i < band.size; j += 1, i += 3) {
+            // black pixels are never marked as detected
+            for (s = 0, p = 0; s < 3; s += 1) p += ibuf[i + s];
+            v = p ? lik[j] : -HUGE_VAL;
+
+            if (v >= st->thresh) {
+                for (s = 0; s < 3; s += 1) obuf[i + s] = ibuf[i + s];
+            }
+
+            if (!rbuf) continue;
+
+            for (s = 0, e = 0; s < 3; s += 1) e += rbuf[i + s];
+            if (v >= st->thresh) {
+                if (e) st->tp += 1; else st->fp += 1;
+            } else {
+                if (e) st->fn += 1; else st->tn += 1;
+            }
+
+            if (st->roc) roc_add(st->roc, v, e != 0);
+        }
+
+        if (fo && fwrite(obuf, 1, band.size, fo) != band.size) {
+            fprintf(stderr, "Error writing image data to file.\n");
+            goto done;
+        }
+
+        px += band.size / 3;
+        io += band.size * (1 + (fr != NULL) + (fo != NULL));
+    }
+
+    st->fpr = (double)st->fp / (st->fp + st->tn);
+    st->fnr = (double)st->fn / (st->fn + st->tp);
+    ret = 0;
+
+done:
+    if (fi) fclose(fi);
+    if (fr) fclose(fr);
+    if (fo) fclose(fo);
+    free(ibuf); free(rbuf); free(obuf);
+    free(lik);
+    feats_free(feat);
+
+    trace_end(&t, st->ifname, px, io);
+
+    return ret;
+}
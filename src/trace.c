@@ -0,0 +1,217 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef struct trace_ev_t {
+    const char *name;
+    char tag[TRACE_TAG];
+    int tid;
+    double t0, dur;     // seconds
+    size_t items, bytes;
+} trace_ev_t;
+
+// per-stage summary row
+typedef struct trace_sum_t {
+    const char *name;
+    size_t calls, items, bytes;
+    double total, p50, max;
+    const char *max_tag;
+} trace_sum_t;
+
+int trace_enabled = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static trace_ev_t *evs = NULL;
+static size_t nev = 0, cap = 0, dropped = 0;
+static const char *path = NULL;
+static double origin = 0;
+static int ntid = 0;
+static __thread int tid = 0;
+
+double trace_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/**
+ * @brief Enables tracing if TRACE_ENV asks for it; the Chrome
+ * trace and the per-stage summary are written at exit. Safe to
+ * call more than once.
+ */
+void trace_init(void) {
+    const char *env = getenv(TRACE_ENV);
+
+    if (trace_enabled || !env || !*env || !strcmp(env, "0")) return;
+
+    path = strcmp(env, "1") ? env : TRACE_FILE;
+    origin = trace_now();
+    trace_enabled = 1;
+
+    atexit(trace_dump);
+}
+
+/**
+ * @brief Appends a finished span (trace_end's slow path). Spans
+ * are coarse, per stage call, so one lock is cheap enough.
+ */
+void trace_record(const trace_t *t, const char *tag, size_t items, size_t bytes) {
+    double now = trace_now();
+    trace_ev_t *e;
+
+    pthread_mutex_lock(&lock);
+
+    if (!tid) tid = ++ntid;
+
+    if (nev == cap) {
+        if (cap == TRACE_MAX) {
+            dropped += 1;
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        cap = cap ? 2 * cap : 1024;
+        evs = (trace_ev_t*) realloc(evs, sizeof(trace_ev_t) * cap);
+    }
+
+    e = &evs[nev++];
+    e->name = t->name;
+    snprintf(e->tag, TRACE_TAG, "%s", tag ? tag : "");
+    e->tid = tid;
+    e->t0 = t->t0 - origin;
+    e->dur = now - t->t0;
+    e->items = items;
+    e->bytes = bytes;
+
+    pthread_mutex_unlock(&lock);
+}
+
+static int dbl_cmp(const void *a, const void *b) {
+    double l = *(const double*)a, r = *(const double*)b;
+
+    return (l > r) - (l < r);
+}
+
+static int sum_cmp(const void *a, const void *b) {
+    double l = ((const trace_sum_t*)a)->total, r = ((const trace_sum_t*)b)->total;
+
+    return (l < r) - (l > r);
+}
+
+// JSON string body: tags are file names, so only quotes, backslashes and controls matter
+static void json_str(FILE *fp, const char *s) {
+    for (; *s; s += 1) {
+        if (*s == '"' || *s == '\\') fprintf(fp, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20) fprintf(fp, "\\u%04x", *s);
+        else fputc(*s, fp);
+    }
+}
+
+static void write_chrome(void) {
+    FILE *fp;
+    size_t i;
+
+    if (!(fp = fopen(path, "w"))) {
+        fprintf(stderr, "Error opening trace file '%s'.\n", path);
+        return;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (i = 0; i < nev; i += 1) {
+        fprintf(fp, "{\"name\":\"%s\",\"cat\":\"pa2\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"tag\":\"",
+                evs[i].name, evs[i].tid, evs[i].t0 * 1e6, evs[i].dur * 1e6);
+        json_str(fp, evs[i].tag);
+        fprintf(fp, "\",\"items\":%zu,\"bytes\":%zu}}%s\n", evs[i].items, evs[i].bytes, (i < nev - 1) ? "," : "");
+    }
+
+    fprintf(fp, "]}\n");
+    fclose(fp);
+}
+
+/**
+ * @brief Per-stage summary on stderr: calls, inclusive time
+ * (spans nest), median and slowest call with its tag, and
+ * throughput over the stage's total time.
+ */
+static void write_summary(void) {
+    trace_sum_t *sum;
+    double *d;
+    size_t i, k, l, ns;
+
+    sum = (trace_sum_t*) calloc(nev, sizeof(trace_sum_t));
+    d = (double*) malloc(sizeof(double) * nev);
+
+    for (i = 0, ns = 0; i < nev; i += 1) {
+        for (k = 0; k < ns && strcmp(sum[k].name, evs[i].name); k += 1);
+        if (k == ns) {
+            sum[ns++].name = evs[i].name;
+        }
+    }
+
+    for (k = 0; k < ns; k += 1) {
+        for (i = 0, l = 0; i < nev; i += 1) {
+            if (strcmp(sum[k].name, evs[i].name)) continue;
+
+            d[l++] = evs[i].dur;
+            sum[k].total += evs[i].dur;
+            sum[k].items += evs[i].items;
+            sum[k].bytes += evs[i].bytes;
+            if (evs[i].dur >= sum[k].max) {
+                sum[k].max = evs[i].dur;
+                sum[k].max_tag = evs[i].tag;
+            }
+        }
+
+        sum[k].calls = l;
+        qsort(d, l, sizeof(double), dbl_cmp);
+        sum[k].p50 = d[(l - 1) / 2];
+    }
+
+    qsort(sum, ns, sizeof(trace_sum_t), sum_cmp);
+
+    fprintf(stderr, "\n%-16s %7s %11s %10s %10s  %-24s %10s %9s\n",
+            "stage", "calls", "total ms", "p50 ms", "max ms", "slowest", "Mitem/s", "MB/s");
+
+    for (k = 0; k < ns; k += 1) {
+        fprintf(stderr, "%-16s %7zu %11.3f %10.3f %10.3f  %-24s ", sum[k].name, sum[k].calls,
+                sum[k].total * 1e3, sum[k].p50 * 1e3, sum[k].max * 1e3, sum[k].max_tag);
+
+        if (sum[k].items) fprintf(stderr, "%10.2f ", sum[k].items / sum[k].total * 1e-6);
+        else fprintf(stderr, "%10s ", "-");
+
+        if (sum[k].bytes) fprintf(stderr, "%9.1f\n", sum[k].bytes / sum[k].total * 1e-6);
+        else fprintf(stderr, "%9s\n", "-");
+    }
+
+    if (dropped) fprintf(stderr, "(%zu spans dropped past %d)\n", dropped, TRACE_MAX);
+    fprintf(stderr, "trace written to '%s'\n", path);
+
+    free(sum); free(d);
+}
+
+/**
+ * @brief Writes the Chrome trace-event JSON (chrome://tracing,
+ * Perfetto) and the summary table. Runs at exit; tracing is off
+ * afterwards.
+ */
+void trace_dump(void) {
+    pthread_mutex_lock(&lock);
+    trace_enabled = 0;
+
+    if (nev) {
+        write_chrome();
+        write_summary();
+    }
+
+    free(evs);
+    evs = NULL;
+    nev = cap = 0;
+
+    pthread_mutex_unlock(&lock);
+}
@@ -1,30 +1,44 @@
 #include "util.h"
 
+/**
+ * @brief Uniform in (0, m] from the calling thread's stream.
+ */
 double ranf(double m) {
-    return (m * rand() / (double)RAND_MAX);
+    return m * rng_uniform(rng_thread());
 }
 
+/**
+ * @brief One N(mu, sigma^2) draw (sigma is a standard deviation).
+ * Normals come in Box-Muller pairs; the second of each pair is
+ * kept for the next call.
+ */
 double rang(double mu, double sigma) {
-    static double x1, x2, y1, y2;
-    double w;
+    static __thread double z[2];
+    static __thread int left = 0;
 
-    do {
-        x1 = 2.0 * ranf(1) - 1;
-        x2 = 2.0 * ranf(1) - 1;
-        w = x1 * x1 + x2 * x2;
-    } while (w >= 1.0);
-
-    w = sqrt((-2.0 * log(w)) / w);
-
-    y1 = x1 * w;
-    y2 = x2 * w;
+    if (!left) {
+        rng_normal(rng_thread(), z, 2);
+        left = 2;
+    }
 
-    return y1 * sigma + mu;
+    return z[2 - left--] * sigma + mu;
 }
 
+/**
+ * @brief One 2-D draw of N(mu, sigma) with the full covariance:
+ * xy = mu + L z with L the 2x2 Cholesky factor of sigma.
+ */
 VEC *rang2D(VEC *xy, VEC *mu, MAT *sigma) {
-    xy->ve[0] = rang(v_get_val(mu, 0), m_get_val(sigma, 0, 0));
-    xy->ve[1] = rang(v_get_val(mu, 1), m_get_val(sigma, 1, 1));
+    double l00, l10, l11, z[2];
+
+    l00 = sqrt(m_get_val(sigma, 0, 0));
+    l10 = m_get_val(sigma, 1, 0) / l00;
+    l11 = sqrt(m_get_val(sigma, 1, 1) - l10 * l10);
+
+    rng_normal(rng_thread(), z, 2);
+
+    xy->ve[0] = v_get_val(mu, 0) + l00 * z[0];
+    xy->ve[1] = v_get_val(mu, 1) + l10 * z[0] + l11 * z[1];
 
     return xy;
 }
@@ -34,7 +48,7 @@ double gauss_eval(gauss_t *g, VEC *x) {
     VEC *y, *z;
     MAT *inv;
 
-    inv = m_inverse(g->sigma, MNULL);
+    inv = fx_inverse(g->sigma, MNULL);
     y = v_sub(x, g->mu, VNULL);
     z = mv_mlt(inv, y, VNULL);
 
@@ -50,7 +64,7 @@ double gauss_eval(gauss_t *g, VEC *x) {
 
 double bhatta_err(gauss_t *c1, gauss_t *c2) {
     MAT *s, *si;
-    VEC *mu_diff;
+    VEC *mu_diff, *t;
     double ds, d1, d2, e, k;
 
     mu_diff = v_sub(c2->mu, c1->mu, VNULL);
@@ -58,102 +72,145 @@ double bhatta_err(gauss_t *c1, gauss_t *c2) {
     s = m_add(c1->sigma, c2->sigma, MNULL);
     sm_mlt(0.5, s, s);
 
-    si = m_inverse(s, MNULL);
+    si = fx_inverse(s, MNULL);
 
     ds = m_det(s);
     d1 = m_det(c1->sigma); d2 = m_det(c2->sigma);
 
-    k = 0.125 * in_prod(mu_diff, mv_mlt(si, mu_diff, VNULL));
+    t = mv_mlt(si, mu_diff, VNULL);
+    k = 0.125 * in_prod(mu_diff, t);
     k += 0.5 * log(ds / sqrt(d1 * d2));  
 
     e = pow(c1->prior, 0.5) * pow(c2->prior, 0.5) * exp(-k);
 
     m_free(s); m_free(si);
-    v_free(mu_diff);
+    v_free(mu_diff); v_free(t);
 
     return e;
 }
 
 void sample_mean(MAT *data, VEC *out) {
-    MAT *tdata = m_transp(data, MNULL);
-    VEC *avg = v_get(data->m);
-    size_t i;
-
-    for (i = 0; i < avg->dim; i += 1) avg->ve[i] = 1.0 / data->m;
+    moments_t *s = mom_get(data->n);
 
-    mv_mlt(tdata, avg, out);
+    mom_add_view(s, view_mat(data));
+    mom_mean(s, out);
 
-    v_free(avg);
-    m_free(tdata);
+    mom_free(s);
 }
 
 void sample_cov(MAT *data, VEC *mean, MAT *out) {
-    MAT *tdata = m_get(data->n, data->m);
-    size_t i, k;
+    Real d[data->n];
+    view_t v;
+    size_t i, j, k;
 
-    for (i = 0; i < data->n; i += 1) {
-        for (k = 0; k < data->m; k += 1) {
-            tdata->me[i][k] = data->me[k][i] - mean->ve[i];
-        }
+    out = m_resize(out, data->n, data->n);
+
+    if (fx_has(data->n)) {
+        v = view_mat(data);
+        fx_cov(data->n, v.data, v.m, v.rs, mean->ve, out->me);
+        return;
     }
 
-    m_mlt(tdata, data, out);
-    sm_mlt(1.0 / (data->m - 1), out, out);
+    m_zero(out);
+
+    // one pass about the given mean, no centered copy
+    for (i = 0; i < data->m; i += 1) {
+        for (j = 0; j < data->n; j += 1) d[j] = data->me[i][j] - mean->ve[j];
+        for (j = 0; j < data->n; j += 1) {
+            for (k = 0; k <= j; k += 1) out->me[j][k] += d[j] * d[k];
+        }
+    }
 
-    m_free(tdata);
+    for (j = 0; j < data->n; j += 1) {
+        for (k = 0; k <= j; k += 1) {
+            out->me[j][k] = out->me[k][j] = out->me[j][k] / (data->m - 1);
+        }
+    }
 }
 
-void compute_mle(gauss_t *g, size_t n) {
-    MAT *mle = m_copy(g->dataset, MNULL);
+int compute_mle(gauss_t *g, size_t n) {
+    moments_t *s;
+    int rc;
+
+    // single pass over a view of the first n rows
+    s = mom_view_par(view_rows(view_mat(g->dataset), 0, n), 0, NULL);
+    rc = apply_mle(g, s);
 
-    mle = m_resize(mle, n, 2);
+    mom_free(s);
 
-    sample_mean(mle, g->mu);
-    sample_cov(mle, g->mu, g->sigma);
+    return rc;
+}
 
-    m_free(mle);
+/**
+ * @brief Sets g's mean and covariance from accumulated moments
+ * and recompiles it.
+ *
+ * @return int - 0 on success, 1 if the covariance is not
+ * positive definite
+ */
+int apply_mle(gauss_t *g, const moments_t *s) {
+    mom_mean(s, g->mu);
+    mom_cov(s, g->sigma);
+
+    return gauss_compile(g) == NULL;
 }
 
-FILE *setup_dataset(char *fname, gauss_t *dist, size_t n) {
-    char path[MAX_FPATH];
+/**
+ * @brief Loads a class dataset, preferring its binary form
+ * (fname with a .bin extension, mapped and copied without
+ * parsing). A text dataset of the given name is imported once
+ * and saved as binary; with neither present, n samples are
+ * drawn from dist and saved as binary. A malformed binary is
+ * treated as missing and rebuilt the same way.
+ *
+ * @param fname - Dataset name under DATA_DIR (e.g. "data_1A.mat")
+ * @param dist - Class distribution; dist->dataset is filled
+ * @param n - Samples to generate if no dataset exists
+ * @return int - 0 on success, 1 on error
+ */
+int setup_dataset(char *fname, gauss_t *dist, size_t n) {
+    char path[MAX_FPATH], bpath[MAX_FPATH];
     FILE *fp;
+    dset_t d;
+    MAT *m;
+    int rc;
+
+    snprintf(path, MAX_FPATH, "%s%s", DATA_DIR, fname);
+    dset_path(path, bpath, MAX_FPATH);
 
-    sprintf(path, "%s%s", DATA_DIR, fname);
+    if (!(rc = dset_open(bpath, &d))) {
+        dist->dataset = dset_mat(&d, dist->dataset);
+        dset_close(&d);
+        return 0;
+    }
+    if (rc > 0) printf("Rebuilding dataset '%s'...\n", bpath);
 
-    if ((fp = fopen(path, "r+"))) {
+    if ((fp = fopen(path, "r"))) {
+        // text is an import path only
+        printf("Importing text dataset '%s'...\n", path);
         if (!load_dataset(fp, dist->dataset)) {
             printf("Failed to load data matrix '%s'...\n", path);
             fclose(fp);
+            return 1;
         }
-    } else if ((fp = fopen(path, "w+"))) {
-        dist->dataset = gen_dataset(fp, dist->dataset, dist, n);
+        fclose(fp);
+        if (dset_write(bpath, dist->dataset, dist->id)) return 1;
     } else {
-        printf("Failed to open '%s'...\n", path);
+        if (!(m = gen_dataset(dist->dataset, dist, n))) return 1;
+        dist->dataset = m;
+        if (dset_write(bpath, dist->dataset, dist->id)) return 1;
     }
 
-    return fp;
+    return 0;
 }
 
-MAT *gen_dataset(FILE *fp, MAT *m, gauss_t *dist, size_t n) {
-    VEC *v;
-    MAT *out;
-
-    if (!fp) return NULL;
-    if (!m) out = m_resize(MNULL, n, 2);
-    else out = m_resize(m, n, 2);
-
-    v = v_get(2);
-
-    while (n--) {
-        rang2D(v, dist->mu, dist->sigma);
-        set_row(out, n, v);
-    }
+MAT *gen_dataset(MAT *m, gauss_t *dist, size_t n) {
+    rng_t r;
 
-    m_foutput(fp, out);
+    // seeded per class: regenerated datasets are reproducible
+    rng_seed(&r, RNG_SEED + dist->id);
 
-    v_free(v); 
-    
-    return out;
+    return gauss_sample(dist, n, &r, 0, m);
 }
 
 size_t load_dataset(FILE *fp, MAT *data) {
@@ -165,17 +222,16 @@ size_t load_dataset(FILE *fp, MAT *data) {
 }
 
 size_t trim_zeros(MAT *m) {
-    MAT *s;
     size_t l;
-    VEC *v;
-    v = v_get(m->n);
+    view_t v;
 
     norm_sort(m);
+    v = view_mat(m);
 
+    // rows move in place, no staging vector
     for (l = m->m - 1; l >= 0; l -= 1) {
-        get_row(m, l, v);
-        if (v_norm2(v) == 0) break;
-        set_row(m, m->m - 1 - l, v);
+        if (__ip__(view_row(v, l), view_row(v, l), v.n) == 0) break;
+        MEM_COPY(view_row(v, l), view_row(v, m->m - 1 - l), v.n * sizeof(Real));
     }
 
     m_resize(m, m->m - 1 - l, m->n);
@@ -185,17 +241,18 @@ size_t trim_zeros(MAT *m) {
 
 void norm_sort(MAT *m) {
     MAT *s;
-    VEC *v, *n;
+    VEC *n;
     PERM *p;
+    view_t v;
     size_t i;
 
     p = px_get(m->m);
     n = v_get(m->m);
-    v = v_get(m->n);
+    v = view_mat(m);
 
+    // norms straight off the rows
     for (i = 0; i < m->m; i += 1) {
-        get_row(m, i, v);
-        v_set_val(n, i, v_norm2(v));
+        v_set_val(n, i, sqrt(__ip__(view_row(v, i), view_row(v, i), v.n)));
     }
 
     v_sort(n, p);
@@ -205,7 +262,7 @@ void norm_sort(MAT *m) {
     m_copy(s, m);
 
     m_free(s);
-    v_free(v); v_free(n);
+    v_free(n);
     px_free(p);
 }
 
@@ -217,11 +274,16 @@ int dataset_len_cmp(const void *a, const void *b) {
 }
 
 double m_det(MAT *m) {
-    MAT *a = m_copy(m, MNULL);
-    PERM *p = px_get(a->m);
+    MAT *a;
+    PERM *p;
     double det;
     int i;
 
+    if (m->m == m->n && fx_has(m->m)) return fx_det(m);
+
+    a = m_copy(m, MNULL);
+    p = px_get(a->m);
+
     det = 1;
     LUfactor(a, p);
 
@@ -229,9 +291,7 @@ double m_det(MAT *m) {
         det *= a->me[i][i];
     }
 
-    for (i = 0; i < a->m; i += 1) {
-        if (p->pe[i] != i) det = -det;
-    }
+    det *= px_sign(p);
 
     m_free(a);
     px_free(p);
@@ -253,6 +313,10 @@ MAT *image_rgmat(Image *img, MAT *m) {
         if (n > 0) {
             m_set_val(out, i / 3, 0, (double)img->data[i] / n);
             m_set_val(out, i / 3, 1, (double)img->data[i + 1] / n);
+        } else {
+            // reused matrices may hold stale rows
+            m_set_val(out, i / 3, 0, 0);
+            m_set_val(out, i / 3, 1, 0);
         }
     }
 
@@ -0,0 +1,59 @@
+#include "view.h"
+
+/**
+ * @brief View of a whole MAT. Meschach lays rows out at a fixed
+ * stride from an aligned base (MAT_ALIGN), as does sub_mat() of
+ * such a matrix; anything else raises E_FORMAT.
+ *
+ * @param a - Matrix
+ * @return view_t - a->m x a->n view, row stride from a->me
+ */
+view_t view_mat(const MAT *a) {
+    view_t v;
+    size_t i;
+
+    if (!a) error(E_NULL, "view_mat");
+
+    v.data = (a->m > 0) ? a->me[0] : a->base;
+    v.m = a->m;
+    v.n = a->n;
+    v.rs = (a->m > 1) ? a->me[1] - a->me[0] : a->n;
+    v.cs = 1;
+
+    for (i = 2; i < a->m; i += 1) {
+        if (a->me[i] != a->me[0] + i * v.rs) error(E_FORMAT, "view_mat");
+    }
+
+    return v;
+}
+
+// rows [lo, lo + n), zero-copy
+view_t view_rows(view_t v, size_t lo, size_t n) {
+    if (lo + n > v.m) error(E_BOUNDS, "view_rows");
+
+    v.data += (ptrdiff_t)lo * v.rs;
+    v.m = n;
+
+    return v;
+}
+
+// columns [lo, lo + n), zero-copy
+view_t view_cols(view_t v, size_t lo, size_t n) {
+    if (lo + n > v.n) error(E_BOUNDS, "view_cols");
+
+    v.data += (ptrdiff_t)lo * v.cs;
+    v.n = n;
+
+    return v;
+}
+
+// transpose, zero-copy (swaps the strides)
+view_t view_trans(view_t v) {
+    view_t t;
+
+    t.data = v.data;
+    t.m = v.n;      t.n = v.m;
+    t.rs = v.cs;    t.cs = v.rs;
+
+    return t;
+}
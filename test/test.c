@@ -0,0 +1,1443 @@
+#include "exp.h"
+
+#include <float.h>
+#include <sys/stat.h>
+
+#define TEST_IMG        "test_img.ppm"
+#define TEST_REF        "test_ref.ppm"
+#define TEST_M          192
+#define TEST_N          256
+#define TEST_THRESH     20
+#define TEST_DSET       "test_dset.bin"
+#define TEST_CACHE      "test_cache.mat"
+
+// fails the current test (returns 1) with the condition and line
+#define CHECK(c) do { \
+    if (!(c)) { \
+        fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+        return 1; \
+    } \
+} while (0)
+
+typedef int (*test_fn)(void);
+
+// shared fixture: a skin-like synthetic image, its mask and a model fit on it
+typedef struct fixture_t {
+    Image *img, *ref;
+    gauss_t color[2];   // YCbCr (0), RG (1)
+    double step[2];     // threshold spacing (peak likelihood / TEST_THRESH)
+} fixture_t;
+
+static fixture_t fx;
+
+// path of this binary, re-run per Meschach instruction set
+static const char *self;
+
+/**
+ * @brief Builds the fixture: warm colors with a few black and
+ * saturated pixels, a random mask, both written under IMAGE_DIR
+ * for face_stream, and an RG and a YCbCr model fit on the image.
+ */
+static int fixture_init(void) {
+    rng_t r;
+    size_t i, s;
+    double v;
+    int rg;
+
+    rng_seed(&r, RNG_SEED);
+
+    fx.img = new_image(TEST_M, TEST_N, 255);
+    fx.ref = new_image(TEST_M, TEST_N, 255);
+
+    for (i = 0; i < fx.img->size; i += 3) {
+        v = 80 + 175 * rng_uniform(&r);
+        fx.img->data[i] = (uint8_t)v;
+        fx.img->data[i + 1] = (uint8_t)(v * (0.55 + 0.35 * rng_uniform(&r)));
+        fx.img->data[i + 2] = (uint8_t)(v * (0.35 + 0.45 * rng_uniform(&r)));
+
+        if (rng_next(&r) % 64 == 0) {
+            for (s = 0; s < 3; s += 1) fx.img->data[i + s] = 0;
+        } else if (rng_next(&r) % 64 == 0) {
+            for (s = 0; s < 3; s += 1) fx.img->data[i + s] = (uint8_t)rng_next(&r);
+        }
+
+        fx.ref->data[i] = fx.ref->data[i + 1] = fx.ref->data[i + 2] = (rng_next(&r) & 1) ? 255 : 0;
+    }
+
+    mkdir(IMAGE_DIR, 0755);
+    if (write_image(TEST_IMG, fx.img) || write_image(TEST_REF, fx.ref)) return 1;
+
+    for (rg = 0; rg < 2; rg += 1) {
+        fx.color[rg] = (gauss_t) { .id = rg, .mu = v_get(2), .sigma = m_get(2, 2) };
+        fx.color[rg].dataset = rg ? image_rgmat(fx.img, MNULL) : image_ycbcrmat(fx.img, MNULL);
+        compute_mle(&fx.color[rg], fx.color[rg].dataset->m);
+        gauss_compile(&fx.color[rg]);
+
+        fx.step[rg] = 1 / (2 * M_PI * sqrt(m_det(fx.color[rg].sigma))) / TEST_THRESH;
+    }
+
+    return 0;
+}
+
+static void fixture_free(void) {
+    char path[MAX_FPATH];
+    int rg;
+
+    for (rg = 0; rg < 2; rg += 1) {
+        v_free(fx.color[rg].mu); m_free(fx.color[rg].sigma);
+        m_free(fx.color[rg].dataset);
+        gauss_model_free(fx.color[rg].model);
+    }
+
+    del_image(fx.img); del_image(fx.ref);
+
+    snprintf(path, sizeof(path), "%s%s", IMAGE_DIR, TEST_IMG);
+    remove(path);
+    snprintf(path, sizeof(path), "%s%s", IMAGE_DIR, TEST_REF);
+    remove(path);
+}
+
+/**
+ * @brief Model likelihood of every pixel through the feature path
+ * in the given precision (what face_stream computes without a
+ * table).
+ */
+static double *model_lik(int rg, prec_t prec) {
+    feats_t *f = feats_image(fx.img, rg, prec, NULL);
+    double *lik = (double*) malloc(sizeof(double) * f->n);
+    size_t k, l;
+
+    for (k = 0; k < f->n; k += l) {
+        l = (f->n - k < SCORE_BLOCK) ? f->n - k : SCORE_BLOCK;
+        feats_logeval(fx.color[rg].model, f, k, l, lik + k);
+    }
+    for (k = 0; k < f->n; k += 1) lik[k] = exp(lik[k]);
+
+    feats_free(f);
+
+    return lik;
+}
+
+// pixels whose two likelihoods fall on different sides of some threshold
+static size_t straddles(const roc_t *r, const double *a, const double *b) {
+    size_t i, k, n = 0;
+
+    for (i = 0; i < fx.img->size / 3; i += 1) {
+        for (k = 0; k < r->n && (a[i] >= r->thresh[k]) == (b[i] >= r->thresh[k]); k += 1);
+        n += (k < r->n);
+    }
+
+    return n;
+}
+
+// ROC bins of the fixture image streamed with the given scoring path
+static roc_t *stream_roc(int rg, const lut_t *lut, prec_t prec) {
+    roc_t *r = roc_new(TEST_THRESH, fx.step[rg], fx.step[rg]);
+    stream_t st = {
+        .ifname = TEST_IMG,
+        .rfname = TEST_REF,
+        .rg = rg,
+        .thresh = HUGE_VAL,
+        .roc = r,
+        .lut = lut,
+        .prec = prec
+    };
+
+    if (face_stream(&fx.color[rg], &st)) {
+        roc_free(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+// samples that moved bin between two ROCs of the same image
+static size_t roc_moved(const roc_t *a, const roc_t *b) {
+    size_t i, n = 0;
+
+    for (i = 0; i <= a->n; i += 1) {
+        n += (a->pos[i] > b->pos[i]) ? a->pos[i] - b->pos[i] : b->pos[i] - a->pos[i];
+        n += (a->neg[i] > b->neg[i]) ? a->neg[i] - b->neg[i] : b->neg[i] - a->neg[i];
+    }
+
+    return n / 2;
+}
+
+// the fixture raster under IMAGE_DIR/name behind a hand-written header, cut short by cut bytes
+static int write_raw(const char *name, const char *hdr, size_t cut) {
+    char path[MAX_FPATH];
+    FILE *fp;
+    int bad;
+
+    snprintf(path, sizeof(path), "%s%s", IMAGE_DIR, name);
+    if (!(fp = fopen(path, "wb"))) return 1;
+    bad = fputs(hdr, fp) < 0 || fwrite(fx.img->data, 1, fx.img->size - cut, fp) != fx.img->size - cut;
+
+    return fclose(fp) || bad;
+}
+
+/**
+ * @brief face_stream reads headers with the parse_header grammar:
+ * single-line, CRLF and commented headers stream exactly like
+ * the file write_image produced (and load_image accepts them);
+ * maxval > 255 and a short raster are rejected by both.
+ */
+static int test_stream_header(void) {
+    const char *ok[] = { "P6 192 256 255\n", "P6\r\n# c\r\n192\t256\r\n255\n", "P6\n192 256\n255\r" };
+    const char *name = "test_hdr.ppm";
+    stream_t ref = { .ifname = TEST_IMG, .rfname = TEST_REF, .rg = 1, .thresh = 5 * fx.step[1] }, st;
+    char path[MAX_FPATH];
+    Image *img;
+    size_t i;
+
+    CHECK(!face_stream(&fx.color[1], &ref));
+
+    for (i = 0; i < sizeof(ok) / sizeof(ok[0]); i += 1) {
+        CHECK(!write_raw(name, ok[i], 0));
+        st = ref;
+        st.ifname = name;
+        CHECK(!face_stream(&fx.color[1], &st));
+        CHECK(st.tp == ref.tp && st.fp == ref.fp && st.tn == ref.tn && st.fn == ref.fn);
+
+        CHECK((img = load_image(name)) != NULL);
+        CHECK(img->m == TEST_M && img->n == TEST_N && !memcmp(img->data, fx.img->data, img->size));
+        del_image(img);
+    }
+
+    st = ref;
+    st.ifname = name;
+    CHECK(!write_raw(name, "P6\n192 256\n65535\n", 0));
+    CHECK(face_stream(&fx.color[1], &st) && !load_image(name));
+    CHECK(!write_raw(name, "P6\n192 256\n255\n", 1));
+    CHECK(face_stream(&fx.color[1], &st) && !load_image(name));
+
+    snprintf(path, sizeof(path), "%s%s", IMAGE_DIR, name);
+    remove(path);
+
+    return 0;
+}
+
+/**
+ * @brief An 8-bit table holds the model likelihood of each exact
+ * color, rounded to float: every pixel must match the model path
+ * to float precision, and the ROC may only differ by the pixels
+ * that rounding moves across a threshold.
+ */
+static int lut_matches_model(int rg) {
+    lut_t *lut = lut_compile(&fx.color[rg], rg, 8, fx.step[rg]);
+    double *lik = model_lik(rg, PREC_F64), *tab;
+    roc_t *a, *b;
+    size_t i, n = fx.img->size / 3, moved, near;
+    uint8_t *p;
+
+    CHECK(lut);
+
+    tab = (double*) malloc(sizeof(double) * n);
+    for (i = 0; i < n; i += 1) {
+        p = fx.img->data + 3 * i;
+        tab[i] = lut->lik[lut_cell(lut, p)];
+
+        // black pixels are never detected, whatever the table holds
+        if (!(p[0] | p[1] | p[2])) continue;
+        CHECK(fabs(tab[i] - lik[i]) <= FLT_EPSILON * lik[i] + FLT_MIN);
+    }
+
+    a = stream_roc(rg, NULL, PREC_F64);
+    b = stream_roc(rg, lut, PREC_F64);
+    CHECK(a && b);
+    CHECK(a->npos == b->npos && a->nneg == b->nneg);
+
+    moved = roc_moved(a, b);
+    near = straddles(a, lik, tab);
+    CHECK(moved <= near);
+
+    roc_free(a); roc_free(b);
+    free(lik); free(tab);
+    lut_free(lut);
+
+    return 0;
+}
+
+static int test_lut_rg(void) { return lut_matches_model(1); }
+static int test_lut_ycbcr(void) { return lut_matches_model(0); }
+
+/**
+ * @brief PREC_F32 rounds the features to float and computes the
+ * distance q in float: the log-likelihood may move by a few float
+ * ulps of (1 + q), and the ROC only by the pixels that this moves
+ * across a threshold.
+ */
+static int f32_matches_f64(int rg) {
+    double *l64 = model_lik(rg, PREC_F64), *l32 = model_lik(rg, PREC_F32);
+    double lognorm = fx.color[rg].model->lognorm, q;
+    size_t i, n = fx.img->size / 3, moved, near;
+    roc_t *a, *b;
+
+    for (i = 0; i < n; i += 1) {
+        // both underflowed: nothing to compare
+        if (l64[i] == 0 && l32[i] == 0) continue;
+
+        q = 2 * (lognorm - log(l64[i]));
+        CHECK(fabs(log(l32[i]) - log(l64[i])) <= 16 * FLT_EPSILON * (1 + q));
+    }
+
+    a = stream_roc(rg, NULL, PREC_F64);
+    b = stream_roc(rg, NULL, PREC_F32);
+    CHECK(a && b);
+    CHECK(a->npos == b->npos && a->nneg == b->nneg);
+
+    moved = roc_moved(a, b);
+    near = straddles(a, l64, l32);
+    CHECK(moved <= near);
+
+    roc_free(a); roc_free(b);
+    free(l64); free(l32);
+
+    return 0;
+}
+
+static int test_f32_rg(void) { return f32_matches_f64(1); }
+static int test_f32_ycbcr(void) { return f32_matches_f64(0); }
+
+// the float32 plane kernel only takes 2-D models
+static int test_soa2_dims(void) {
+    gauss_t g = { .mu = v_get(3), .sigma = m_ident(m_get(3, 3)) };
+    gauss_model_t *m = gauss_compile(&g);
+    float x[1] = { 0 };
+    Real d[1];
+    volatile int caught = 0;
+
+    catch(E_SIZES, gauss_quad_soa2m(m, x, x, 1, 1, 0, d), caught += 1);
+
+    gauss_model_free(m);
+    v_free(g.mu); m_free(g.sigma);
+
+    CHECK(caught == 1);
+
+    return 0;
+}
+
+/**
+ * @brief The per-call evaluators ignore a model compiled before
+ * sigma was rewritten in place: they agree with a class that was
+ * never compiled.
+ */
+static int test_model_stale(void) {
+    gauss_t g = { .mu = v_get(2), .sigma = m_get(2, 2), .prior = 0.4 };
+    gauss_t h = { .mu = v_get(2), .sigma = m_get(2, 2), .prior = 0.4 };
+    Real x[2] = { 1.5, -0.5 }, a, b;
+    VEC row = { .dim = 2, .max_dim = 2, .ve = x };
+
+    g.mu->ve[0] = h.mu->ve[0] = 1;
+    g.mu->ve[1] = h.mu->ve[1] = 2;
+    m_set_val(g.sigma, 0, 0, 1); m_set_val(g.sigma, 1, 1, 2);
+    m_set_val(g.sigma, 0, 1, 0.3); m_set_val(g.sigma, 1, 0, 0.3);
+    gauss_compile(&g);
+
+    // as main.c does between experiments
+    m_zero(g.sigma);
+    m_set_val(g.sigma, 0, 0, 4); m_set_val(g.sigma, 1, 1, 8);
+    m_copy(g.sigma, h.sigma);
+
+    CHECK(gauss_eval(&g, &row) == gauss_eval(&h, &row));
+    CHECK(case3_disc(&row, &g) == case3_disc(&row, &h));
+    disc_batch(case3_disc, &g, x, 1, 2, &a);
+    disc_batch(case3_disc, &h, x, 1, 2, &b);
+    CHECK(a == b);
+
+    gauss_model_free(g.model);
+    v_free(g.mu); m_free(g.sigma);
+    v_free(h.mu); m_free(h.sigma);
+
+    return 0;
+}
+
+// 2-D class with the given mean, covariance and prior
+static void class_init(gauss_t *g, double m0, double m1, double s00, double s01, double s11, double prior) {
+    *g = (gauss_t) { .mu = v_get(2), .sigma = m_get(2, 2), .prior = prior };
+
+    g->mu->ve[0] = m0; g->mu->ve[1] = m1;
+    m_set_val(g->sigma, 0, 0, s00); m_set_val(g->sigma, 0, 1, s01);
+    m_set_val(g->sigma, 1, 0, s01); m_set_val(g->sigma, 1, 1, s11);
+}
+
+static void class_free(gauss_t *g) {
+    v_free(g->mu); m_free(g->sigma);
+    gauss_model_free(g->model);
+}
+
+// n uniform rows in [lo, hi)^d
+static MAT *rows_uniform(size_t n, int d, double lo, double hi, uint64_t seed) {
+    MAT *x = m_get(n, d);
+    rng_t r;
+    size_t i;
+    int j;
+
+    rng_seed(&r, seed);
+    for (i = 0; i < n; i += 1) {
+        for (j = 0; j < d; j += 1) x->me[i][j] = lo + (hi - lo) * rng_uniform(&r);
+    }
+
+    return x;
+}
+
+// case2_disc under another name: no compiled form, so per-row calls
+static double disc_plain(VEC *x, gauss_t *g) { return case2_disc(x, g); }
+
+/**
+ * @brief classify_run against the serial rule of the original
+ * classify (g per row, last minimum wins) with 1 and 8 workers.
+ * Labels and counts must be identical across thread counts. A
+ * compiled table may only pick another class where the serial
+ * scores tie to rounding.
+ */
+static int classify_matches(Disc g, size_t c) {
+    gauss_t cls[3], *dist[3] = { &cls[0], &cls[1], &cls[2] };
+    batch_t b = { .c = c, .d = 2, .g = g, .dist = dist };
+    size_t n = 3 * CLASSIFY_BLOCK + 17, cnt[2][3], ref[3] = { 0 }, i, k, pm;
+    IVEC *lab[2] = { IVNULL, IVNULL };
+    MAT *x = rows_uniform(n, 2, -3, 9, 7);
+    VEC row = { .dim = 2, .max_dim = 2 };
+    double p[3];
+    int t;
+
+    class_init(&cls[0], 1, 1, 1, 0.2, 1, 0.3);
+    class_init(&cls[1], 4, 4, 4, -0.5, 8, 0.5);
+    class_init(&cls[2], 6, 0, 2, 0.7, 1, 0.2);
+    b.n = n;
+
+    for (t = 0; t < 2; t += 1) {
+        b.nthreads = t ? 8 : 1;
+        classify_run(&b, x, cnt[t], lab[t] = iv_get(n));
+    }
+
+    for (i = 0; i < n; i += 1) {
+        row.ve = x->me[i];
+        for (k = 0, pm = 0; k < c; k += 1) {
+            p[k] = g(&row, dist[k]);
+            if (p[k] <= p[pm]) pm = k;
+        }
+
+        CHECK(lab[0]->ive[i] == lab[1]->ive[i]);
+        k = lab[0]->ive[i];
+        CHECK(k == pm || p[k] - p[pm] <= 1e-9 * (1 + fabs(p[pm])));
+        ref[k] += 1;
+    }
+
+    for (k = 0; k < c; k += 1) CHECK(cnt[0][k] == ref[k] && cnt[1][k] == ref[k]);
+
+    for (k = 0; k < 3; k += 1) class_free(&cls[k]);
+    iv_free(lab[0]); iv_free(lab[1]);
+    m_free(x);
+
+    return 0;
+}
+
+// two classes: difference discriminant; three: per-class tables; plain: disc_rows
+static int test_classify_diff(void) { return classify_matches(case3_disc, 2); }
+static int test_classify_tab(void) { return classify_matches(case2_disc, 3) || classify_matches(euclid_disc, 3); }
+static int test_classify_plain(void) { return classify_matches(disc_plain, 3); }
+
+/**
+ * @brief Compiled (W, w, w0) tables reproduce the discriminant
+ * functions row by row, in 2-D and 3-D with a correlated sigma,
+ * and disc_sub reproduces the difference of two classes.
+ */
+static int test_disc_compile(void) {
+    const Disc g[] = { euclid_disc, case1_disc, case2_disc, case3_disc };
+    const double s[3][3] = { { 2, 0.6, -0.3 }, { 0.6, 1.5, 0.4 }, { -0.3, 0.4, 1 } };
+    disc_t k[2] = { { 0 } }, diff = { 0 };
+    gauss_t c[2];
+    VEC row;
+    MAT *x;
+    double a, b, e;
+    size_t i, j, l;
+    int d, t;
+
+    for (d = 2; d <= 3; d += 1) {
+        x = rows_uniform(500, d, -4, 6, 40 + d);
+        for (t = 0; t < 2; t += 1) {
+            c[t] = (gauss_t) { .mu = v_get(d), .sigma = m_get(d, d), .prior = t ? 0.7 : 0.3 };
+            for (i = 0; i < d; i += 1) {
+                c[t].mu->ve[i] = t ? 3 - i : 0.5 * i;
+                for (j = 0; j < d; j += 1) c[t].sigma->me[i][j] = (1 + t) * s[i][j];
+            }
+        }
+        row = (VEC) { .dim = d, .max_dim = d };
+
+        for (l = 0; l < sizeof(g) / sizeof(g[0]); l += 1) {
+            CHECK(!disc_compile(g[l], &c[0], &k[0]) && !disc_compile(g[l], &c[1], &k[1]));
+            disc_sub(&k[0], &k[1], &diff);
+
+            for (i = 0, e = 0; i < x->m; i += 1) {
+                row.ve = x->me[i];
+                a = g[l](&row, &c[0]);
+                b = g[l](&row, &c[1]);
+                e = fmax(e, fabs(disc_eval(&k[0], row.ve) - a) / (1 + fabs(a)));
+                e = fmax(e, fabs(disc_eval(&k[1], row.ve) - b) / (1 + fabs(b)));
+                e = fmax(e, fabs(disc_eval(&diff, row.ve) - (a - b)) / (1 + fabs(a) + fabs(b)));
+            }
+            CHECK(e < 1e-12);
+        }
+
+        CHECK(disc_compile(disc_plain, &c[0], &k[0]) == 1);
+
+        for (t = 0; t < 2; t += 1) class_free(&c[t]);
+        m_free(x);
+    }
+
+    disc_free(&k[0]); disc_free(&k[1]); disc_free(&diff);
+
+    return 0;
+}
+
+/**
+ * @brief classify() keeps plot_quota evenly spaced samples of each
+ * assigned class for plot_batch, grouped by class, in data order
+ * and tagged with the class id.
+ */
+static int test_classify_plot(void) {
+    gauss_t cls[2], *dist[2] = { &cls[0], &cls[1] };
+    batch_t b = { .c = 2, .d = 2, .g = case3_disc, .dist = dist, .budget = 300, .bname = "test_plot" };
+    size_t n = 5000, cnt[2], i, j, r, k;
+    MAT *x = rows_uniform(n, 2, -3, 9, 5);
+    IVEC *lab = iv_get(n);
+
+    class_init(&cls[0], 1, 1, 1, 0.2, 1, 0.3);
+    class_init(&cls[1], 4, 4, 4, -0.5, 8, 0.7);
+    cls[0].id = 1; cls[1].id = 2;
+    b.n = n;
+
+    classify(&b, x, 1);
+    classify_run(&b, x, cnt, lab);
+
+    for (k = 0, r = 0; k < 2; k += 1) {
+        for (i = 0, j = 0; i < n; i += 1) {
+            if (lab->ive[i] != k || !plot_keep(j++, plot_quota(cnt[k], n, 300), cnt[k])) continue;
+            CHECK(r < b.plot->m && b.plot->me[r][2] == cls[k].id);
+            CHECK(b.plot->me[r][0] == x->me[i][0] && b.plot->me[r][1] == x->me[i][1]);
+            r += 1;
+        }
+    }
+    CHECK(r == b.plot->m && r <= 300 + 2);
+
+    m_free(b.plot); m_free(x); iv_free(lab);
+    class_free(&cls[0]); class_free(&cls[1]);
+
+    return 0;
+}
+
+static void posdef_block(void *arg, size_t blk, int w) {
+    int *ok = (int*)arg;
+    gauss_t g;
+
+    // no catch(): a singular sigma comes back as NULL on any thread
+    class_init(&g, 0, 0, 1, 1, 1, 1);
+    ok[blk] = gauss_compile(&g) == NULL;
+    class_free(&g);
+}
+
+/**
+ * @brief A singular covariance is reported, not raised: by
+ * gauss_compile (also on pool threads) and by everything that
+ * compiles a model.
+ */
+static int test_not_posdef(void) {
+    gauss_t cls[2], *dist[2] = { &cls[0], &cls[1] };
+    batch_t b = { .c = 2, .d = 2, .g = case3_disc, .dist = dist, .n = 10, .nthreads = 4 };
+    disc_t k = { 0 };
+    MAT *x = rows_uniform(10, 2, 0, 1, 3);
+    size_t cnt[2] = { 7, 7 };
+    int ok[8] = { 0 }, i;
+    rng_t r;
+
+    rng_seed(&r, 5);
+    class_init(&cls[0], 1, 1, 1, 0.2, 1, 0.5);
+    class_init(&cls[1], 2, 2, 1, 2, 1, 0.5);
+
+    CHECK(gauss_compile(&cls[0]) && !gauss_compile(&cls[1]));
+    CHECK(disc_compile(case3_disc, &cls[1], &k) == 1);
+    CHECK(!disc_compile(case1_disc, &cls[1], &k));
+    CHECK(!lut_compile(&cls[1], 1, 4, 1e-3));
+    CHECK(!gauss_sample(&cls[1], 10, &r, 1, MNULL));
+    CHECK(classify_run(&b, x, cnt, IVNULL) == 1 && cnt[0] == 7);
+
+    pool_run(8, 4, posdef_block, ok);
+    for (i = 0; i < 8; i += 1) CHECK(ok[i]);
+
+    disc_free(&k);
+    class_free(&cls[0]); class_free(&cls[1]);
+    m_free(x);
+
+    return 0;
+}
+
+// single-pass Welford reference over rows [lo, lo + n)
+static moments_t *mom_serial(const MAT *x, size_t lo, size_t n) {
+    moments_t *s = mom_get(x->n);
+    size_t i;
+
+    for (i = lo; i < lo + n; i += 1) mom_add(s, x->me[i]);
+
+    return s;
+}
+
+// same count, mean and M2 (lower triangle) to a relative tol
+static int mom_close(const moments_t *a, const moments_t *b, double tol) {
+    int i, k;
+
+    if (a->n != b->n || a->d != b->d) return 0;
+
+    for (i = 0; i < a->d; i += 1) {
+        if (fabs(a->mean->ve[i] - b->mean->ve[i]) > tol * (1 + fabs(b->mean->ve[i]))) return 0;
+        for (k = 0; k <= i; k += 1) {
+            if (fabs(a->m2->me[i][k] - b->m2->me[i][k]) > tol * (1 + fabs(b->m2->me[i][k]))) return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Chan merges of k partitions (empty and 1-row ones
+ * included) match one Welford pass; mom_view_par over several
+ * MOM_BLOCKs matches it too and is identical for 1 and 4
+ * workers. d = 3 takes the fixed-dimension path, d = 6 the
+ * generic one; the offset data stresses cancellation.
+ */
+static int mom_merge_matches(int d) {
+    const size_t cut[] = { 0, 0, 1, 2, 2, 7, 1000, 1001, 4000, 4000, 4321 };
+    size_t n = 2 * MOM_BLOCK + 123, i;
+    MAT *x = rows_uniform(n, d, 1e3, 1e3 + 10, 11);
+    moments_t *ref = mom_serial(x, 0, cut[10]), *acc = mom_get(d), *part, *empty, *par[2];
+
+    // every boundary pair is one partition, in order
+    for (i = 0; i + 1 < sizeof(cut) / sizeof(cut[0]); i += 1) {
+        part = mom_get(d);
+        mom_add_rows(part, x, cut[i], cut[i + 1] - cut[i]);
+        mom_merge(acc, part);
+        mom_free(part);
+    }
+    CHECK(mom_close(acc, ref, 1e-9));
+
+    // empty into empty, and into a filled accumulator: no change
+    empty = mom_get(d);
+    mom_merge(empty, empty);
+    CHECK(empty->n == 0);
+    part = mom_copy(acc, NULL);
+    mom_merge(acc, empty);
+    CHECK(mom_close(acc, part, 0));
+    mom_free(part); mom_free(empty);
+
+    mom_free(ref);
+    ref = mom_serial(x, 0, n);
+    par[0] = mom_rows_par(x, 0, n, 1, NULL);
+    par[1] = mom_rows_par(x, 0, n, 4, NULL);
+    CHECK(mom_close(par[0], ref, 1e-9));
+    CHECK(mom_close(par[1], par[0], 0));
+
+    mom_free(ref); mom_free(acc);
+    mom_free(par[0]); mom_free(par[1]);
+    m_free(x);
+
+    return 0;
+}
+
+static int test_mom_merge(void) { return mom_merge_matches(3) || mom_merge_matches(6); }
+
+/**
+ * @brief mom_prefix checkpoints (unsorted, duplicated, across
+ * and on MOM_BLOCK boundaries) give the same parameters as an
+ * independent compute_mle over the first l rows.
+ */
+static int test_mom_prefix(void) {
+    const size_t lens[] = { 5000, 3, 2 * MOM_BLOCK + 7, 5000, MOM_BLOCK, 3, 17, 0 };
+    size_t k = sizeof(lens) / sizeof(lens[0]), j;
+    moments_t *out[sizeof(lens) / sizeof(lens[0])] = { NULL };
+    gauss_t p, ref;
+    int i, c;
+
+    class_init(&p, 0, 0, 1, 0, 1, 1);
+    class_init(&ref, 0, 0, 1, 0, 1, 1);
+    ref.dataset = rows_uniform(2 * MOM_BLOCK + 50, 2, -5, 20, 13);
+
+    mom_prefix(ref.dataset, lens, k, 4, out);
+
+    for (j = 0; j < k; j += 1) {
+        CHECK(out[j] && out[j]->n == lens[j]);
+        if (!lens[j]) continue;
+
+        apply_mle(&p, out[j]);
+        compute_mle(&ref, lens[j]);
+
+        for (i = 0; i < 2; i += 1) {
+            CHECK(fabs(p.mu->ve[i] - ref.mu->ve[i]) <= 1e-10 * (1 + fabs(ref.mu->ve[i])));
+            for (c = 0; c < 2; c += 1) {
+                CHECK(fabs(p.sigma->me[i][c] - ref.sigma->me[i][c]) <= 1e-10 * (1 + fabs(ref.sigma->me[i][c])));
+            }
+        }
+    }
+
+    for (j = 0; j < k; j += 1) mom_free(out[j]);
+    m_free(ref.dataset);
+    class_free(&p); class_free(&ref);
+
+    return 0;
+}
+
+// vector lengths the primitive kernels are checked at (tails and long runs)
+static const int simd_len[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 257, 1000, 1003 };
+#define SIMD_NLEN   (sizeof(simd_len) / sizeof(simd_len[0]))
+#define SIMD_MAXLEN 1003
+
+// inputs for length len: mixed signs and magnitudes so summation order shows
+static double simd_input(int len, Real *x, Real *y) {
+    rng_t r;
+    int i;
+
+    rng_seed(&r, 1000 + len);
+    for (i = 0; i < len; i += 1) {
+        x[i] = (rng_uniform(&r) - 0.5) * exp(8 * rng_uniform(&r) - 4);
+        y[i] = (rng_uniform(&r) - 0.5) * exp(8 * rng_uniform(&r) - 4);
+    }
+
+    return rng_uniform(&r) - 0.5;
+}
+
+/**
+ * @brief Child side of test_simd: prints the selected instruction
+ * set, then for every length __ip__ fast and reproducible, and
+ * the outputs of __mltadd__ (fast, reproducible), __smlt__,
+ * __add__ and __sub__, all in %a.
+ */
+static int simd_dump(void) {
+    Real x[SIMD_MAXLEN], y[SIMD_MAXLEN], o[SIMD_MAXLEN];
+    size_t k;
+    double a;
+    int i, len, r;
+
+    printf("%s\n", m_simd_isa());
+
+    for (k = 0; k < SIMD_NLEN; k += 1) {
+        len = simd_len[k];
+        a = simd_input(len, x, y);
+
+        m_simd_repro(0);
+        printf("%a\n", __ip__(x, y, len));
+        m_simd_repro(1);
+        printf("%a\n", __ip__(x, y, len));
+
+        for (r = 0; r < 2; r += 1) {
+            m_simd_repro(r);
+            memcpy(o, y, sizeof(Real) * len);
+            __mltadd__(o, x, a, len);
+            for (i = 0; i < len; i += 1) printf("%a\n", o[i]);
+        }
+
+        __smlt__(x, a, o, len);
+        for (i = 0; i < len; i += 1) printf("%a\n", o[i]);
+        __add__(x, y, o, len);
+        for (i = 0; i < len; i += 1) printf("%a\n", o[i]);
+        __sub__(x, y, o, len);
+        for (i = 0; i < len; i += 1) printf("%a\n", o[i]);
+    }
+
+    return fflush(stdout) != 0;
+}
+
+// runs this binary under env (a dump mode); returns the number of values read into v
+static size_t child_run(const char *env, char *name, double *v, size_t cap) {
+    char cmd[MAX_FPATH + 64];
+    size_t n = 0;
+    FILE *fp;
+
+    snprintf(cmd, sizeof(cmd), "%s '%s'", env, self);
+    if (!(fp = popen(cmd, "r"))) return 0;
+
+    if (fscanf(fp, "%15s", name) == 1) {
+        while (n < cap && fscanf(fp, "%la", &v[n]) == 1) n += 1;
+    }
+
+    return pclose(fp) ? 0 : n;
+}
+
+// runs simd_dump under MESCHACH_ISA=isa
+static size_t simd_run(const char *isa, char *name, double *v, size_t cap) {
+    char env[64];
+
+    snprintf(env, sizeof(env), "MESCHACH_ISA=%s PA2_TEST_SIMD=1", isa);
+
+    return child_run(env, name, v, cap);
+}
+
+/**
+ * @brief Every Meschach kernel table against the portable C one.
+ * Reproducible __ip__ / __mltadd__ and the elementwise kernels
+ * must be bit-identical on every instruction set; the fast __ip__
+ * may reorder (error bounded by the sum of |x_i y_i|) and the
+ * fast __mltadd__ may fuse (within a rounding of each term).
+ */
+static int test_simd(void) {
+    const char *isa[] = { "sse2", "avx2", "avx512" };
+    Real x[SIMD_MAXLEN], y[SIMD_MAXLEN];
+    size_t need = 0, k, j, o, n;
+    double *ref, *v, a, bound;
+    char name[16], rname[16];
+    int i, len;
+
+    for (k = 0; k < SIMD_NLEN; k += 1) need += 2 + 5 * (size_t)simd_len[k];
+    ref = (double*) malloc(sizeof(double) * need);
+    v = (double*) malloc(sizeof(double) * need);
+
+    CHECK(simd_run("c", rname, ref, need) == need && !strcmp(rname, "c"));
+
+    for (j = 0; j < sizeof(isa) / sizeof(isa[0]); j += 1) {
+        CHECK(simd_run(isa[j], name, v, need) == need);
+        printf("     %s (asked %s)\n", name, isa[j]);
+
+        for (k = 0, o = 0; k < SIMD_NLEN; k += 1) {
+            len = simd_len[k];
+            a = simd_input(len, x, y);
+
+            for (i = 0, bound = 0; i < len; i += 1) bound += fabs(x[i] * y[i]);
+            CHECK(fabs(v[o] - ref[o]) <= 2 * len * DBL_EPSILON * bound);
+            CHECK(v[o + 1] == ref[o + 1]);
+            o += 2;
+
+            for (i = 0; i < len; i += 1) {
+                CHECK(fabs(v[o + i] - ref[o + i]) <= 2 * DBL_EPSILON * (fabs(y[i]) + fabs(a * x[i])));
+            }
+            o += len;
+
+            // reproducible __mltadd__, __smlt__, __add__, __sub__
+            for (n = o + 4 * (size_t)len; o < n; o += 1) CHECK(v[o] == ref[o]);
+        }
+    }
+
+    free(ref); free(v);
+
+    return 0;
+}
+
+// naive op(A).op(B) against m_mlt / mmtr_mlt / mtrm_mlt
+static double gemm_err(const MAT *a, const MAT *b, int ta, int tb, const MAT *c) {
+    size_t i, j, k, p = ta ? a->m : a->n;
+    double s, e = 0;
+
+    for (i = 0; i < c->m; i += 1) {
+        for (j = 0; j < c->n; j += 1) {
+            for (k = 0, s = 0; k < p; k += 1) {
+                s += (ta ? a->me[k][i] : a->me[i][k]) * (tb ? b->me[j][k] : b->me[k][j]);
+            }
+            e = fmax(e, fabs(s - c->me[i][j]));
+        }
+    }
+
+    return e;
+}
+
+// max |a - b| over a's extent
+static double mat_diff(const MAT *a, const MAT *b) {
+    double e = 0;
+    size_t i, j;
+
+    for (i = 0; i < a->m; i += 1) {
+        for (j = 0; j < a->n; j += 1) e = fmax(e, fabs(a->me[i][j] - b->me[i][j]));
+    }
+
+    return e;
+}
+
+static const int rng_len[] = { 1, 2, 3, 7, 8, 9, 511, 512, 513, 1025, 1500 };
+#define RNG_NLEN (sizeof(rng_len) / sizeof(rng_len[0]))
+
+/**
+ * @brief Child side of test_rng: prints the Box-Muller kernel in
+ * use, then rng_normal's output for every length in %a.
+ */
+static int rng_dump(void) {
+    double z[1500];
+    size_t k;
+    rng_t r;
+    int i;
+
+    printf("%s\n", rng_isa());
+
+    for (k = 0; k < RNG_NLEN; k += 1) {
+        rng_seed(&r, 77 + k);
+        rng_normal(&r, z, rng_len[k]);
+        for (i = 0; i < rng_len[k]; i += 1) printf("%a\n", z[i]);
+    }
+
+    return fflush(stdout) != 0;
+}
+
+/**
+ * @brief The selected Box-Muller kernel gives the scalar kernel's
+ * normals bit for bit, full vectors and tails alike.
+ */
+static int test_rng(void) {
+    size_t need = 0, k;
+    double *ref, *v;
+    char name[16], rname[16];
+
+    for (k = 0; k < RNG_NLEN; k += 1) need += rng_len[k];
+    ref = (double*) malloc(sizeof(double) * need);
+    v = (double*) malloc(sizeof(double) * need);
+
+    CHECK(child_run(RNG_ISA_ENV "=scalar PA2_TEST_RNG=1", rname, ref, need) == need && !strcmp(rname, "scalar"));
+    CHECK(child_run("PA2_TEST_RNG=1", name, v, need) == need);
+    printf("     %s\n", name);
+
+    CHECK(!memcmp(ref, v, sizeof(double) * need));
+
+    free(ref); free(v);
+
+    return 0;
+}
+
+/**
+ * @brief gauss_sample against a correlated 3-D sigma: sample mean
+ * and covariance within 5 standard errors of mu and sigma, and
+ * the draw independent of the thread count.
+ */
+static int test_gauss_sample(void) {
+    const double s[3][3] = { { 4, 1.2, -0.8 }, { 1.2, 2, 0.5 }, { -0.8, 0.5, 1 } };
+    gauss_t g = { .mu = v_get(3), .sigma = m_get(3, 3) };
+    size_t n = 200000, i, j;
+    MAT *x, *y, *c = m_get(3, 3);
+    VEC *mean = v_get(3);
+    rng_t r;
+
+    g.mu->ve[0] = 1; g.mu->ve[1] = -2; g.mu->ve[2] = 0.5;
+    for (i = 0; i < 3; i += 1) {
+        for (j = 0; j < 3; j += 1) g.sigma->me[i][j] = s[i][j];
+    }
+
+    rng_seed(&r, 11);
+    x = gauss_sample(&g, n, &r, 1, MNULL);
+    y = gauss_sample(&g, n, &r, 4, MNULL);
+    CHECK(x->m == n && mat_diff(x, y) == 0);
+
+    sample_mean(x, mean);
+    sample_cov(x, mean, c);
+
+    for (i = 0; i < 3; i += 1) {
+        CHECK(fabs(mean->ve[i] - g.mu->ve[i]) < 5 * sqrt(s[i][i] / n));
+        for (j = 0; j < 3; j += 1) {
+            CHECK(fabs(c->me[i][j] - s[i][j]) < 5 * sqrt((s[i][i] * s[j][j] + s[i][j] * s[i][j]) / n));
+        }
+    }
+
+    m_free(x); m_free(y); m_free(c); v_free(mean);
+    gauss_model_free(g.model);
+    v_free(g.mu); m_free(g.sigma);
+
+    return 0;
+}
+
+// random SPD matrix b b' + d I
+static MAT *spd_rand(int d, rng_t *r) {
+    MAT *b = m_get(d, d), *a;
+    int i, j;
+
+    for (i = 0; i < d; i += 1) {
+        for (j = 0; j < d; j += 1) b->me[i][j] = 2 * rng_uniform(r) - 1;
+    }
+    a = mmtr_mlt(b, b, MNULL);
+    for (i = 0; i < d; i += 1) a->me[i][i] += d;
+
+    m_free(b);
+
+    return a;
+}
+
+/**
+ * @brief The fixed-size kernels for d = 1..FX_MAX_D on random SPD
+ * inputs, against the generic code the library runs for larger d
+ * (m_det, gauss_maha and sample_cov route to the kernels at these
+ * sizes, so their generic paths are spelled out here): an LU
+ * determinant, m_inverse, the lower-triangle quadratic form, the
+ * two-loop covariance and mom_add. A singular matrix has a zero
+ * determinant and raises E_SING.
+ */
+static int test_fixed(void) {
+    size_t n = 257, i;
+    Real q[257], mu[FX_MAX_D], dv[FX_MAX_D], cnt_m2[FX_MAX_D][FX_MAX_D];
+    Real *m2[FX_MAX_D];
+    MAT *a, *lu, *inv, *ref, *x, *cov, *rcov;
+    moments_t *mom;
+    PERM *p;
+    size_t cnt;
+    double det, e, t;
+    int d, j, k;
+    volatile int caught;
+    rng_t r;
+
+    rng_seed(&r, 23);
+    for (k = 0; k < FX_MAX_D; k += 1) m2[k] = cnt_m2[k];
+
+    for (d = 1; d <= FX_MAX_D; d += 1) {
+        a = spd_rand(d, &r);
+
+        // determinant from LU, as m_det does past FX_MAX_D
+        lu = m_copy(a, MNULL);
+        p = px_get(d);
+        LUfactor(lu, p);
+        for (j = 0, det = px_sign(p); j < d; j += 1) det *= lu->me[j][j];
+        CHECK(fabs(fx_det(a) - det) <= 1e-12 * fabs(det));
+
+        inv = fx_inverse(a, MNULL);
+        ref = m_inverse(a, MNULL);
+        CHECK(mat_diff(inv, ref) <= 1e-12 * m_norm_inf(ref));
+
+        // quadratic form against the generic gauss_maha loop
+        x = rows_uniform(n, d, -3, 3, 60 + d);
+        for (j = 0; j < d; j += 1) mu[j] = 0.25 * j - 0.5;
+        fx_quad(d, mu, inv->me, x->me[0], n, x->me[1] - x->me[0], 1, 0, q);
+        for (i = 0, e = 0; i < n; i += 1) {
+            for (j = 0, t = 0; j < d; j += 1) {
+                dv[j] = x->me[i][j] - mu[j];
+                for (k = 0; k < j; k += 1) t += 2 * dv[j] * inv->me[j][k] * dv[k];
+                t += dv[j] * inv->me[j][j] * dv[j];
+            }
+            e = fmax(e, fabs(q[i] - t) / (1 + t));
+        }
+        CHECK(e < 1e-12);
+
+        // covariance about mu, against the two-loop form
+        cov = m_get(d, d);
+        rcov = m_get(d, d);
+        fx_cov(d, x->me[0], n, x->me[1] - x->me[0], mu, cov->me);
+        for (i = 0; i < n; i += 1) {
+            for (j = 0; j < d; j += 1) {
+                for (k = 0; k < d; k += 1) rcov->me[j][k] += (x->me[i][j] - mu[j]) * (x->me[i][k] - mu[k]) / (n - 1);
+            }
+        }
+        CHECK(mat_diff(cov, rcov) < 1e-12);
+
+        // moments against mom_add row by row
+        mom = mom_get(d);
+        for (i = 0; i < n; i += 1) mom_add(mom, x->me[i]);
+        cnt = 0;
+        memset(mu, 0, sizeof(mu));
+        memset(cnt_m2, 0, sizeof(cnt_m2));
+        fx_mom(d, x->me[0], n, x->me[1] - x->me[0], &cnt, mu, m2);
+        CHECK(cnt == n);
+        for (j = 0, e = 0; j < d; j += 1) {
+            e = fmax(e, fabs(mu[j] - mom->mean->ve[j]));
+            for (k = 0; k <= j; k += 1) e = fmax(e, fabs(m2[j][k] - mom->m2->me[j][k]) / n);
+        }
+        CHECK(e < 1e-12);
+
+        // singular: a zero row stays exactly zero through elimination
+        for (j = 0; j < d; j += 1) a->me[d / 2][j] = 0;
+        CHECK(fx_det(a) == 0);
+        caught = 0;
+        catch(E_SING, fx_inverse(a, inv), caught = 1);
+        CHECK(caught);
+
+        m_free(a); m_free(lu); m_free(inv); m_free(ref);
+        m_free(x); m_free(cov); m_free(rcov);
+        mom_free(mom); px_free(p);
+    }
+
+    return 0;
+}
+
+static void lu_ec_block(void *arg, size_t blk, int w) {
+    int *rc = (int*)arg;
+    MAT *a = m_get(6, 6), *inv = m_get(6, 6);
+    volatile int caught = 0;
+
+    // error state is per thread: catch() here only sees this block
+    rc[2 * blk] = m_inverse_ec(a, inv);
+    catch(E_POSDEF, CHfactor(a), caught = 1);
+    rc[2 * blk + 1] = caught;
+
+    m_free(a); m_free(inv);
+}
+
+/**
+ * @brief The error-code LU forms give LUfactor / m_inverse's
+ * results (stack and heap scale workspaces) and return E_SING for
+ * a singular matrix, on pool threads too, alongside a raising
+ * call caught per thread.
+ */
+static int test_lu_ec(void) {
+    int n[2] = { 7, 70 }, rc[16] = { 0 }, t, i;
+    MAT *a, *b, *ref, *inv;
+    PERM *p, *q;
+
+    for (t = 0; t < 2; t += 1) {
+        a = m_rand(m_get(n[t], n[t]));
+        for (i = 0; i < n[t]; i += 1) a->me[i][i] += n[t];
+        b = m_copy(a, MNULL);
+        p = px_get(n[t]); q = px_get(n[t]);
+
+        LUfactor(b, p);
+        CHECK(!LUfactor_ec(ref = m_copy(a, MNULL), q));
+        CHECK(mat_diff(b, ref) == 0 && px_sign(p) == px_sign(q));
+        for (i = 0; i < n[t]; i += 1) CHECK(p->pe[i] == q->pe[i]);
+
+        m_inverse(a, b);
+        CHECK(!m_inverse_ec(a, inv = m_get(n[t], n[t])));
+        CHECK(mat_diff(b, inv) < 1e-12);
+
+        CHECK(LUfactor_ec(a, px_resize(q, n[t] - 1)) == E_SIZES);
+
+        m_free(a); m_free(b); m_free(ref); m_free(inv);
+        px_free(p); px_free(q);
+    }
+
+    // a repeated row
+    a = m_rand(m_get(4, 4));
+    MEM_COPY(a->me[0], a->me[2], 4 * sizeof(Real));
+    CHECK(m_inverse_ec(a, inv = m_get(4, 4)) == E_SING);
+    m_free(a); m_free(inv);
+
+    pool_run(8, 4, lu_ec_block, rc);
+    for (i = 0; i < 8; i += 1) CHECK(rc[2 * i] == E_SING && rc[2 * i + 1] == 1);
+
+    return 0;
+}
+
+typedef struct gemm_ctx_t {
+    MAT *a, *b;
+    double err[4];
+} gemm_ctx_t;
+
+static void gemm_block(void *arg, size_t blk, int w) {
+    gemm_ctx_t *ctx = (gemm_ctx_t*)arg;
+    MAT *c = MNULL;
+    int r;
+
+    // each block redoes the product a few times on its own thread's buffers
+    for (r = 0; r < 3; r += 1) c = m_mlt(ctx->a, ctx->b, c);
+    ctx->err[blk] = gemm_err(ctx->a, ctx->b, 0, 0, c);
+    m_free(c);
+}
+
+/**
+ * @brief Packed products across more than one block and panel
+ * (m > MC, n > NC, odd edges) in every transpose form, then the
+ * same product on several pool threads at once.
+ */
+static int test_gemm(void) {
+    gemm_ctx_t ctx = { 0 };
+    MAT *a = m_rand(m_get(131, 300)), *b = m_rand(m_get(300, 2071));
+    MAT *at = m_transp(a, MNULL), *bt = m_transp(b, MNULL), *c;
+    int k;
+
+    c = m_mlt(a, b, MNULL);
+    CHECK(gemm_err(a, b, 0, 0, c) < 1e-10);
+    c = mtrm_mlt(at, b, c);
+    CHECK(gemm_err(at, b, 1, 0, c) < 1e-10);
+    c = mmtr_mlt(a, bt, c);
+    CHECK(gemm_err(a, bt, 0, 1, c) < 1e-10);
+
+    ctx.a = m_rand(m_get(97, 200));
+    ctx.b = m_rand(m_get(200, 45));
+    pool_run(4, 4, gemm_block, &ctx);
+    for (k = 0; k < 4; k += 1) CHECK(ctx.err[k] < 1e-10);
+
+    m_free(a); m_free(b); m_free(at); m_free(bt); m_free(c);
+    m_free(ctx.a); m_free(ctx.b);
+
+    return 0;
+}
+
+/**
+ * @brief Heap objects resized inside an arena scope keep heap
+ * storage and survive the release; arena objects grow inside
+ * their arena, on MAT_ALIGN like heap ones.
+ */
+static int test_arena_resize(void) {
+    MEM_ARENA *a = mem_arena_get(4096), *prev;
+    MEM_MARK mk = mem_arena_mark(a);
+    MAT *h = m_get(2, 2), *t;
+    VEC *v = v_get(4);
+    size_t i;
+
+    prev = mem_arena_use(a);
+
+    h = m_resize(h, 40, 30);
+    v = v_resize(v, 5000);
+    for (i = 0; i < 40 * 30; i += 1) h->base[i] = i;
+    for (i = 0; i < 5000; i += 1) v->ve[i] = i;
+
+    t = m_get(3, 3);
+    CHECK(((size_t)t->base & (MAT_ALIGN - 1)) == 0);
+    t = m_resize(t, 50, 50);
+    CHECK(((size_t)t->base & (MAT_ALIGN - 1)) == 0);
+    t = m_get(64, 64);
+    CHECK(((size_t)t->base & (MAT_ALIGN - 1)) == 0);
+
+    mem_arena_use(prev);
+    mem_arena_release(a, mk);
+
+    // reuse the released space, then read the heap objects back
+    mem_arena_use(a);
+    t = m_ones(m_get(64, 64));
+    mem_arena_use(prev);
+
+    for (i = 0; i < 40 * 30; i += 1) CHECK(h->base[i] == i);
+    for (i = 0; i < 5000; i += 1) CHECK(v->ve[i] == i);
+
+    m_free(h); v_free(v);
+    mem_arena_free(a);
+
+    return 0;
+}
+
+// views read MAT rows in place, sub_mat() windows included
+static int test_views(void) {
+    MAT *a = m_rand(m_get(300, 5)), *w = sub_mat(a, 10, 1, 259, 3, MNULL), *c;
+    moments_t *s = mom_get(3), *r = mom_get(3);
+    view_t v = view_rows(view_mat(w), 50, 200);
+    size_t i, j;
+    int bad = 0;
+
+    CHECK(v.m == 200 && v.n == 3 && v.rs == 5);
+    CHECK(view_row(v, 0) == &a->me[60][1]);
+
+    // the same rows copied out, through the row-at-a-time path
+    c = m_get(200, 3);
+    for (i = 0; i < 200; i += 1) {
+        for (j = 0; j < 3; j += 1) c->me[i][j] = a->me[60 + i][1 + j];
+    }
+    mom_add_view(s, v);
+    for (i = 0; i < 200; i += 1) mom_add(r, c->me[i]);
+
+    for (j = 0; j < 3; j += 1) {
+        bad += fabs(s->mean->ve[j] - r->mean->ve[j]) > 1e-12;
+        for (i = 0; i <= j; i += 1) bad += fabs(s->m2->me[j][i] - r->m2->me[j][i]) > 1e-10;
+    }
+    CHECK(!bad);
+
+    catch(E_BOUNDS, view_rows(v, 150, 51), bad = -1);
+    CHECK(bad == -1);
+
+    mom_free(s); mom_free(r);
+    m_free(c); m_free(w); m_free(a);
+
+    return 0;
+}
+
+/**
+ * @brief Column windows and transposes read the MAT elements they
+ * name, and moments over a transposed view (gathered rows) match
+ * the same samples copied out.
+ */
+static int test_views_trans(void) {
+    MAT *a = m_rand(m_get(3, 200)), *c = m_get(200, 3);
+    moments_t *s = mom_get(3), *r = mom_get(3);
+    view_t v = view_mat(a), t = view_trans(v), k = view_cols(v, 40, 100);
+    size_t i, j;
+    int bad = 0;
+
+    CHECK(t.m == 200 && t.n == 3 && t.cs == v.rs && t.rs == 1);
+    CHECK(k.m == 3 && k.n == 100 && k.cs == 1);
+
+    for (i = 0; i < 3; i += 1) {
+        for (j = 0; j < 100; j += 1) bad += view_at(k, i, j) != a->me[i][40 + j];
+    }
+    for (i = 0; i < 200; i += 1) {
+        for (j = 0; j < 3; j += 1) {
+            bad += view_at(t, i, j) != a->me[j][i];
+            c->me[i][j] = a->me[j][i];
+        }
+    }
+    CHECK(!bad);
+
+    // transposed column window: rows 40..139 of t
+    k = view_trans(k);
+    CHECK(k.m == 100 && view_at(k, 0, 2) == a->me[2][40]);
+
+    mom_add_view(s, t);
+    for (i = 0; i < 200; i += 1) mom_add(r, c->me[i]);
+
+    for (j = 0; j < 3; j += 1) {
+        bad += fabs(s->mean->ve[j] - r->mean->ve[j]) > 1e-12;
+        for (i = 0; i <= j; i += 1) bad += fabs(s->m2->me[j][i] - r->m2->me[j][i]) > 1e-10;
+    }
+    CHECK(!bad);
+
+    catch(E_BOUNDS, view_cols(v, 150, 51), bad = -1);
+    CHECK(bad == -1);
+
+    mom_free(s); mom_free(r);
+    m_free(c); m_free(a);
+
+    return 0;
+}
+
+// little-endian header field
+static void put_le(uint8_t *p, uint64_t v, int len) {
+    int i;
+
+    for (i = 0; i < len; i += 1) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// writes a dataset header with the given counts and len bytes of file
+static int dset_craft(uint64_t rows, uint32_t cols, uint64_t offset, uint64_t stride, size_t len) {
+    uint8_t *buf = (uint8_t*) calloc(1, len);
+    FILE *fp;
+
+    memcpy(buf, DSET_MAGIC, sizeof(DSET_MAGIC));
+    put_le(buf + 8, DSET_VERSION, 4);
+    put_le(buf + 12, DSET_F64, 4);
+    put_le(buf + 16, rows, 8);
+    put_le(buf + 24, cols, 4);
+    put_le(buf + 32, offset, 8);
+    put_le(buf + 40, stride, 8);
+
+    fp = fopen(TEST_DSET, "wb");
+    if (!fp || fwrite(buf, 1, len, fp) != len) len = 0;
+    if (fp) fclose(fp);
+    free(buf);
+
+    return len == 0;
+}
+
+/**
+ * @brief Binary datasets round-trip, and headers whose counts do
+ * not fit the file are rejected, including ones crafted so the
+ * size arithmetic wraps around.
+ */
+static int test_dset(void) {
+    MAT *m = m_rand(m_get(100, 3)), *r = MNULL;
+    dset_t d;
+    int bad;
+
+    CHECK(!dset_write(TEST_DSET, m, 7));
+    CHECK(!dset_open(TEST_DSET, &d));
+    CHECK(d.rows == 100 && d.cols == 3 && d.label == 7);
+    r = dset_mat(&d, r);
+    dset_close(&d);
+    CHECK(r->m == 100 && r->n == 3 && m_norm_inf(m_sub(m, r, r)) == 0);
+
+    // rows * 8 wraps to 0, so stride 0 "fits" a 128 byte file
+    CHECK(!dset_craft((uint64_t)1 << 61, 2, 64, 0, 128));
+    bad = dset_open(TEST_DSET, &d);
+    CHECK(bad == 1);
+
+    // (cols - 1) * stride wraps
+    CHECK(!dset_craft(8, 0xffffffffu, 64, (uint64_t)1 << 32, 128));
+    CHECK(dset_open(TEST_DSET, &d) == 1);
+
+    // offset past the end, and one row short
+    CHECK(!dset_craft(8, 1, (uint64_t)-64, 64, 128));
+    CHECK(dset_open(TEST_DSET, &d) == 1);
+    CHECK(!dset_craft(8, 2, 64, 64, 64 + 64 + 56));
+    CHECK(dset_open(TEST_DSET, &d) == 1);
+
+    // exactly fits
+    CHECK(!dset_craft(8, 2, 64, 64, 64 + 64 + 64));
+    CHECK(dset_open(TEST_DSET, &d) == 0);
+    dset_close(&d);
+
+    remove(TEST_DSET);
+    m_free(m); m_free(r);
+
+    return 0;
+}
+
+/**
+ * @brief The dataset cache is replaced whole (no .tmp left
+ * behind), and a malformed one is a miss: setup_dataset draws
+ * the samples again and rewrites a valid file.
+ */
+static int test_dset_cache(void) {
+    char path[MAX_FPATH];
+    gauss_t g;
+    MAT *ref;
+    dset_t d;
+    FILE *fp;
+
+    dset_path(DATA_DIR TEST_CACHE, path, MAX_FPATH);
+    class_init(&g, 1, 2, 1, 0.3, 2, 1);
+    g.id = 9;
+    ref = gen_dataset(MNULL, &g, 500);
+
+    // a truncated header
+    CHECK((fp = fopen(path, "wb")) && fwrite(DSET_MAGIC, 1, 8, fp) == 8 && !fclose(fp));
+    CHECK(dset_open(path, &d) == 1);
+
+    CHECK(!setup_dataset(TEST_CACHE, &g, 500));
+    CHECK(g.dataset->m == 500 && m_norm_inf(m_sub(g.dataset, ref, ref)) == 0);
+    CHECK(!dset_open(path, &d) && d.rows == 500 && d.label == 9);
+    dset_close(&d);
+
+    strcat(path, ".tmp");
+    CHECK(!(fp = fopen(path, "rb")));
+    path[strlen(path) - 4] = '\0';
+
+    remove(path);
+    m_free(g.dataset); m_free(ref);
+    class_free(&g);
+
+    return 0;
+}
+
+static const struct {
+    const char *name;
+    test_fn fn;
+} tests[] = {
+    { "stream_header", test_stream_header },
+    { "lut_rg", test_lut_rg },
+    { "lut_ycbcr", test_lut_ycbcr },
+    { "f32_rg", test_f32_rg },
+    { "f32_ycbcr", test_f32_ycbcr },
+    { "soa2_dims", test_soa2_dims },
+    { "model_stale", test_model_stale },
+    { "classify_diff", test_classify_diff },
+    { "classify_tab", test_classify_tab },
+    { "classify_plain", test_classify_plain },
+    { "disc_compile", test_disc_compile },
+    { "classify_plot", test_classify_plot },
+    { "not_posdef", test_not_posdef },
+    { "mom_merge", test_mom_merge },
+    { "mom_prefix", test_mom_prefix },
+    { "simd", test_simd },
+    { "rng", test_rng },
+    { "gauss_sample", test_gauss_sample },
+    { "fixed", test_fixed },
+    { "lu_ec", test_lu_ec },
+    { "gemm", test_gemm },
+    { "arena_resize", test_arena_resize },
+    { "views", test_views },
+    { "views_trans", test_views_trans },
+    { "dset", test_dset },
+    { "dset_cache", test_dset_cache },
+};
+
+int main(int argc, char *argv[]) {
+    size_t k, failed = 0;
+
+    self = argv[0];
+    if (getenv("PA2_TEST_SIMD")) return simd_dump();
+    if (getenv("PA2_TEST_RNG")) return rng_dump();
+
+    if (fixture_init()) {
+        fprintf(stderr, "Error writing the test images under '%s'.\n", IMAGE_DIR);
+        return 1;
+    }
+
+    for (k = 0; k < sizeof(tests) / sizeof(tests[0]); k += 1) {
+        if (argc > 1 && !strstr(tests[k].name, argv[1])) continue;
+
+        if (tests[k].fn()) {
+            printf("FAIL %s\n", tests[k].name);
+            failed += 1;
+        } else {
+            printf("ok   %s\n", tests[k].name);
+        }
+    }
+
+    fixture_free();
+
+    printf("%zu failed\n", failed);
+
+    return failed != 0;
+}